@@ -5,7 +5,20 @@
 
 // std
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef SUPERSTRING_THREAD_SAFE
+#include <atomic>
+#endif
 
 /*-- declarations --*/
 
@@ -17,14 +30,18 @@ class SuperString {
 public:
     //*-- Encoding
     /**
-     * Supported encoding.
+     * Supported encoding. Strings are stored in the first four, `Latin1` and
+     * `UTF16LE` are read into and written from them: `Latin1` bytes are stored
+     * as `ASCII`, whose code units are the byte values, and `UTF16LE` is
+     * swapped into a `UTF16BE` copy.
      */
     enum class Encoding {
         ASCII,
         UTF8,
         UTF16BE,
-        UTF32
-        // TODO: Support LE version of UTF-16
+        UTF32,
+        Latin1,
+        UTF16LE
     };
 
     //*-- Error
@@ -36,7 +53,20 @@ public:
         Unexpected, // Something that never happen, Unreachable code
         RangeError,
         InvalidByteSequence,
-        NotFound
+        NotFound,
+        Unencodable, // A code unit that the requested encoding cannot represent
+        IOError
+    };
+
+    //*-- Access
+    /**
+     * How a mapped file is expected to be read, passed on to the kernel as a
+     * paging hint.
+     */
+    enum class Access {
+        Normal,
+        Sequential,
+        Random
     };
 
     //*-- Byte
@@ -52,8 +82,21 @@ public:
     template<class T, class E>
     class Result {
     private:
-        char *_ok;
-        char *_err;
+        enum class State: char {
+            None,
+            Ok,
+            Err
+        };
+
+        /**
+         * Raw storage large enough for either a `T` or an `E`, so that
+         * results live entirely inline and never touch the heap.
+         */
+        typedef typename std::aligned_storage<(sizeof(T) > sizeof(E) ? sizeof(T) : sizeof(E)),
+                (alignof(T) > alignof(E) ? alignof(T) : alignof(E))>::type Storage;
+
+        Storage _storage;
+        State _state;
 
     public:
         //*- Constructors
@@ -66,6 +109,8 @@ public:
 
         Result(const SuperString::Result<T, E> &other) /*copy*/;
 
+        Result(SuperString::Result<T, E> &&other) /*move*/;
+
         //*- Destructor
 
         ~Result();
@@ -107,6 +152,218 @@ public:
         //*- Operators
 
         SuperString::Result<T, E> &operator=(const SuperString::Result<T, E> &other);
+
+        SuperString::Result<T, E> &operator=(SuperString::Result<T, E> &&other);
+
+    private:
+        /**
+         * Returns true if both `T` and `E` can be copied byte-wise.
+         */
+        static constexpr bool isTrivial();
+
+        void _clear();
+    };
+
+    //*-- Chunk
+    /**
+     * A contiguous span of the storage of a string: [length] code units
+     * encoded in [encoding] over [byteLength] bytes starting at [bytes].
+     */
+    class Chunk {
+    private:
+        const Byte *_bytes;
+        std::size_t _byteLength;
+        std::size_t _length;
+        Encoding _encoding;
+
+    public:
+        //*- Constructors
+
+        Chunk(const Byte *bytes, std::size_t byteLength, std::size_t length, Encoding encoding);
+
+        //*- Getters
+
+        /**
+         * Returns the first byte of this chunk, valid as long as the string
+         * it was visited from is alive.
+         */
+        const Byte *bytes() const;
+
+        /**
+         * Returns the number of bytes of this chunk.
+         */
+        std::size_t byteLength() const;
+
+        /**
+         * Returns the number of code units of this chunk.
+         */
+        std::size_t length() const;
+
+        /**
+         * Returns the encoding of the bytes of this chunk.
+         */
+        Encoding encoding() const;
+    };
+
+    //*-- Stats
+    /**
+     * A snapshot of the counters that the garbage collector keeps over all
+     * strings, for monitoring. Counts since the start of the process are
+     * cumulative, the others describe the sequences alive.
+     */
+    class Stats {
+    private:
+        std::size_t _sequenceCount;
+        std::size_t _referencerCount;
+        std::size_t _freeingCost;
+        std::size_t _retainedBytes;
+        std::size_t _deferredCount;
+        std::size_t _retentionCount;
+        std::size_t _reconstructionCount;
+        std::size_t _reconstructedBytes;
+
+    public:
+        //*- Constructors
+
+        Stats(std::size_t sequenceCount, std::size_t referencerCount, std::size_t freeingCost,
+              std::size_t retainedBytes, std::size_t deferredCount, std::size_t retentionCount,
+              std::size_t reconstructionCount, std::size_t reconstructedBytes);
+
+        //*- Getters
+
+        /**
+         * Returns the number of sequences alive, held by strings or referenced
+         * by other sequences.
+         */
+        std::size_t sequenceCount() const;
+
+        /**
+         * Returns the number of references between sequences, a sequence
+         * referencing another one more than once counting for each.
+         */
+        std::size_t referencerCount() const;
+
+        /**
+         * Returns the bytes that reconstructing every referencer would take, the
+         * sum of the freeing costs of all sequences.
+         */
+        std::size_t freeingCost() const;
+
+        /**
+         * Returns the keeping costs of the sequences no longer held by any string
+         * but kept for their referencers, as of their last retention.
+         */
+        std::size_t retainedBytes() const;
+
+        /**
+         * Returns the number of sequences waiting for `collect` to be freed.
+         */
+        std::size_t deferredCount() const;
+
+        /**
+         * Returns the number of times a sequence no longer held by any string
+         * was kept because freeing it would cost more, since the start.
+         */
+        std::size_t retentionCount() const;
+
+        /**
+         * Returns the number of reconstructions since the start.
+         */
+        std::size_t reconstructionCount() const;
+
+        /**
+         * Returns the bytes of data that reconstructions allocated since the start.
+         */
+        std::size_t reconstructedBytes() const;
+    };
+
+    //*-- RetentionPolicy
+    /**
+     * Decides whether a sequence that no string holds any more, but that other
+     * strings still reference, is kept for them or freed, in which case they
+     * copy the parts they reference. Sequences nothing references are always
+     * freed. In the thread-safe build, referenced sequences are always kept.
+     */
+    class RetentionPolicy {
+    public:
+        //*- Destructor
+
+        virtual ~RetentionPolicy();
+
+        //*- Methods
+
+        /**
+         * Returns true if a sequence whose keeping costs [keepingCost] bytes is to
+         * be freed, at a cost of [freeingCost] bytes of reconstructions.
+         */
+        virtual bool isToBeFreed(std::size_t keepingCost, std::size_t freeingCost) const = 0;
+
+        // forward declaration
+        class CostBased;
+
+        class AlwaysKeep;
+
+        class Threshold;
+
+        class MemoryBudget;
+    };
+
+    //*-- RetentionPolicy::CostBased
+    /**
+     * Frees a sequence when the reconstructions take less than keeping it,
+     * the default.
+     */
+    class RetentionPolicy::CostBased: public RetentionPolicy {
+    public:
+        bool isToBeFreed(std::size_t keepingCost, std::size_t freeingCost) const /*override*/;
+    };
+
+    //*-- RetentionPolicy::AlwaysKeep
+    /**
+     * Never reconstructs, a sequence lives as long as something references it.
+     */
+    class RetentionPolicy::AlwaysKeep: public RetentionPolicy {
+    public:
+        bool isToBeFreed(std::size_t keepingCost, std::size_t freeingCost) const /*override*/;
+    };
+
+    //*-- RetentionPolicy::Threshold
+    /**
+     * Frees a sequence whenever the reconstructions take at most [threshold]
+     * bytes, whatever keeping it costs.
+     */
+    class RetentionPolicy::Threshold: public RetentionPolicy {
+    private:
+        std::size_t _threshold;
+
+    public:
+        //*- Constructors
+
+        Threshold(std::size_t threshold);
+
+        //*- Methods
+
+        bool isToBeFreed(std::size_t keepingCost, std::size_t freeingCost) const /*override*/;
+    };
+
+    //*-- RetentionPolicy::MemoryBudget
+    /**
+     * Decides as `CostBased` while the sequences kept for their referencers
+     * fit in [budget] bytes, and frees them once keeping one more would
+     * exceed it.
+     */
+    class RetentionPolicy::MemoryBudget: public RetentionPolicy {
+    private:
+        std::size_t _budget;
+
+    public:
+        //*- Constructors
+
+        MemoryBudget(std::size_t budget);
+
+        //*- Methods
+
+        bool isToBeFreed(std::size_t keepingCost, std::size_t freeingCost) const /*override*/;
     };
 
     //*-- SuperString
@@ -123,6 +380,12 @@ public:
      */
     SuperString(const SuperString &other) /*copy*/;
 
+    /**
+     * Constructs a new string from [other], taking its content over and
+     * leaving [other] empty.
+     */
+    SuperString(SuperString &&other) /*move*/;
+
     //*- Destructor
 
     /**
@@ -147,6 +410,22 @@ public:
      */
     std::size_t length() const;
 
+    //*- Iterators
+
+    // forward declaration
+    class Iterator;
+
+    /**
+     * Returns an iterator to the first code unit of this string. The iterators
+     * of a string stored inline point into it, moving the string ends them.
+     */
+    SuperString::Iterator begin() const;
+
+    /**
+     * Returns an iterator past the last code unit of this string.
+     */
+    SuperString::Iterator end() const;
+
     //*- Methods
 
     /**
@@ -155,7 +434,9 @@ public:
     SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const;
 
     /**
-     * Compares this to [other].
+     * Compares this to [other] code unit by code unit, returning -1, 0 or 1.
+     * Runs of contiguous storage are compared at once, with memcmp when their
+     * encodings agree.
      */
     int compareTo(const SuperString &other) const;
 
@@ -192,6 +473,33 @@ public:
      */
     bool print(std::ostream &stream, std::size_t startIndex, std::size_t endIndex) const;
 
+    /**
+     * Writes the code units from [startIndex], inclusive, to [endIndex], exclusive,
+     * to [buffer] in the given [encoding] and returns the number of bytes written,
+     * without any terminator. When [buffer] is NULL nothing is written and the
+     * number of bytes needed is returned. `Encoding::ASCII` and `Encoding::Latin1`
+     * both write Latin-1, SuperString::Error::Unencodable is returned for code
+     * units above 0xff.
+     */
+    SuperString::Result<std::size_t, SuperString::Error>
+    copyTo(Byte *buffer, std::size_t startIndex, std::size_t endIndex, Encoding encoding = Encoding::UTF8) const;
+
+    /**
+     * Returns this string encoded in UTF-8, or an empty string if it holds
+     * code units that are not Unicode scalar values.
+     */
+    std::string toStdString() const;
+
+    /**
+     * Calls [callback] on the raw chunks that hold the code units from
+     * [startIndex], inclusive, to [endIndex], exclusive, in order, without
+     * copying them. Returns false if [callback] stopped the traversal by
+     * returning false.
+     */
+    SuperString::Result<bool, SuperString::Error>
+    forEachChunk(std::size_t startIndex, std::size_t endIndex,
+                 const std::function<bool(const SuperString::Chunk &chunk)> &callback) const;
+
     /**
      * Returns the string without any leading and trailing whitespace.
      */
@@ -207,17 +515,64 @@ public:
      */
     SuperString trimRight() const;
 
-    // TODO: delete this two methods
+    /**
+     * Returns this string as a single contiguous copy in the given [encoding],
+     * that references no other string, built in one pass over the chunks and
+     * copied as is where their encoding agrees. `Encoding::ASCII` takes Latin-1,
+     * SuperString::Error::Unencodable is returned for code units out of reach.
+     * `Encoding::Latin1` gives an ASCII string, `Encoding::UTF16LE` returns
+     * SuperString::Error::Unimplemented as no string is stored little-endian.
+     */
+    SuperString::Result<SuperString, SuperString::Error> flatten(Encoding encoding = Encoding::UTF8) const;
+
+    /**
+     * Returns this string with every part built of other strings that has at
+     * most [threshold] code units flattened into a copy, ASCII when it can,
+     * UTF-8 otherwise. Longer concatenations are rebuilt from their compacted
+     * halves, other long parts are kept.
+     */
+    SuperString compact(std::size_t threshold = SuperString::CompactLength) const;
+
+    /**
+     * Returns the bytes that keeping this string takes, including the strings
+     * it references.
+     */
     std::size_t keepingCost() const;
 
+    /**
+     * Returns the bytes that the strings referencing this one would take to
+     * reconstruct if it was freed.
+     */
     std::size_t freeingCost() const;
 
+    //*- Setters
+
+    /**
+     * Makes [policy] decide whether the content of this string is kept for the
+     * strings referencing it once no string holds it, NULL for the global
+     * policy. The policy stays with the content, not with this variable, and
+     * has to outlive it.
+     */
+    void retentionPolicy(SuperString::RetentionPolicy *policy);
+
     //*- Operators
 
     /**
      * Creates a new string by concatenating this string with [other].
      */
-    SuperString operator+(const SuperString &other) const;
+    SuperString operator+(const SuperString &other) const &;
+
+    /**
+     * Creates a new string by concatenating this temporary string with [other],
+     * extending it in place when nothing else holds it.
+     */
+    SuperString operator+(const SuperString &other) &&;
+
+    /**
+     * Appends [other] to this string, in place when nothing else holds it;
+     * iterators over this string are then invalidated.
+     */
+    SuperString &operator+=(const SuperString &other);
 
     /**
      * Creates a new string by concatenating this string with itself a
@@ -231,15 +586,127 @@ public:
     SuperString &operator=(const SuperString &other);
 
     /**
-     * Returns `SuperString::TRUE` if this is equal to [other].
+     * Assigns [other] to this string, taking its content over and leaving
+     * [other] empty.
+     */
+    SuperString &operator=(SuperString &&other);
+
+    /**
+     * Returns `SuperString::TRUE` if this is equal to [other]. Strings of
+     * different lengths or with different cached hashes are told apart
+     * without reading them.
      */
     bool operator==(const SuperString &other) const;
 
+    /**
+     * Returns true if this is not equal to [other].
+     */
+    bool operator!=(const SuperString &other) const;
+
+    /**
+     * Returns true if this sorts before [other], as `compareTo`.
+     */
+    bool operator<(const SuperString &other) const;
+
+    /**
+     * Returns true if this sorts before or equal to [other].
+     */
+    bool operator<=(const SuperString &other) const;
+
+    /**
+     * Returns true if this sorts after [other].
+     */
+    bool operator>(const SuperString &other) const;
+
+    /**
+     * Returns true if this sorts after or equal to [other].
+     */
+    bool operator>=(const SuperString &other) const;
+
+    /**
+     * Returns a hash of the code units of this string, the same for equal
+     * strings whatever their encodings and shapes. A sequence computes its
+     * hash once, concatenations and repetitions combine those of their parts.
+     */
+    std::size_t hash() const;
+
     //*- Statics
 
+    /**
+     * The default threshold of `compact`, in code units.
+     */
+    static const std::size_t CompactLength = 4096;
+
+    /**
+     * The number of bytes of UTF-8 up to which a string is stored in itself
+     * rather than in a sequence on the heap. `Const`, `Copy`, `substring` and
+     * the operators store such short results inline, `Const` copying them.
+     */
+    static const std::size_t InlineCapacity = 15;
+
+    /**
+     * Returns the number of code units between two samples of the offset index
+     * built by UTF-8 and UTF-16BE strings for random access, 0 if disabled.
+     */
+    static std::size_t offsetIndexStride();
+
+    /**
+     * Sets the sampling [stride] of offset indexes built from now on,
+     * 0 disables them.
+     */
+    static void offsetIndexStride(std::size_t stride);
+
+    /**
+     * Returns the counters of the garbage collector over all strings.
+     */
+    static SuperString::Stats stats();
+
+    /**
+     * Returns the policy deciding whether strings are kept for their referencers.
+     */
+    static SuperString::RetentionPolicy &retentionPolicy();
+
+    /**
+     * Sets the global retention [policy], which has to outlive the strings.
+     */
+    static void retentionPolicy(SuperString::RetentionPolicy &policy);
+
+    /**
+     * Returns true if freeing the sequences that strings still reference is
+     * deferred to `collect`.
+     */
+    static bool deferredReconstruction();
+
+    /**
+     * Defers, or not, the freeing of the sequences that strings still reference,
+     * and so the reconstructions it takes, from the destructors to `collect`.
+     * Destructing a string then costs the same whatever references it. In the
+     * thread-safe build, referenced sequences are kept and nothing is deferred.
+     */
+    static void deferredReconstruction(bool isDeferred);
+
+    /**
+     * Frees deferred sequences, those they cascade into included, until their
+     * freeing costs add up to [budget] bytes, and returns how many were
+     * processed. Sequences held again meanwhile are left alone.
+     */
+    static std::size_t collect(std::size_t budget = (std::size_t) -1);
+
+    /**
+     * Checks that the given NUL-terminated [chars] are well formed in the given
+     * [encoding] (UTF-8 default as encoding), and returns their length. Otherwise returns
+     * SuperString::Error::InvalidByteSequence, and stores the offset of the first
+     * invalid byte in [errorOffset] if given.
+     */
+    static SuperString::Result<std::size_t, SuperString::Error>
+    validate(const char *chars, SuperString::Encoding encoding = SuperString::Encoding::UTF8,
+             std::size_t *errorOffset = NULL);
+
     /**
      * Creates a string for the given `const char *` [chars] (UTF-8 default as encoding),
-     * without copying the data of [chars].
+     * without copying the data of [chars]. Ill-formed UTF-8 gives an empty string whose
+     * `codeUnitAt`, `substring`, `copyTo` and `flatten` return
+     * SuperString::Error::InvalidByteSequence. UTF-16LE is copied as by `Copy`.
      */
     static SuperString Const(const char *chars, SuperString::Encoding encoding = SuperString::Encoding::UTF8);
 
@@ -258,7 +725,7 @@ public:
 
     /**
      * Creates a string for the given `const char *` [chars] (UTF-8 default as encoding),
-     * by copying the data of [chars].
+     * by copying the data of [chars]. Ill-formed UTF-8 is rejected as by `Const`.
      */
     static SuperString Copy(const char *chars, SuperString::Encoding encoding = SuperString::Encoding::UTF8);
 
@@ -275,6 +742,21 @@ public:
     static SuperString
     Copy(const SuperString::Byte *bytes, SuperString::Encoding encoding = SuperString::Encoding::UTF8);
 
+    /**
+     * Creates a string for the content of the file at [path] (UTF-8 default as encoding),
+     * by mapping the file read-only into memory rather than reading it. Pages are loaded on
+     * demand, the mapping lives as long as the string or a string referencing it. Like
+     * `Const`, the content is not validated and ends at its first NUL code unit. Returns
+     * SuperString::Error::IOError if the file cannot be opened or mapped, and
+     * SuperString::Error::Unimplemented for UTF-16LE, which cannot be read in place.
+     */
+    static SuperString::Result<SuperString, SuperString::Error>
+    MapFile(const char *path, SuperString::Encoding encoding = SuperString::Encoding::UTF8,
+            SuperString::Access access = SuperString::Access::Normal);
+
+    // forward declaration
+    class InternPool;
+
 private:
     // forward declaration
     class StringSequence;
@@ -289,52 +771,172 @@ private:
 
     class CopyUTF32Sequence;
 
+    class NodeAllocator;
+
     //*-- SuperString
-    StringSequence *_sequence;
+    // a short string is stored as UTF-8 in [_inline], its last byte holding the byte
+    // length plus one and `InlineASCII` if it is all ASCII; that byte is 0 while
+    // [_sequence] is used, NULL for no string
+    union {
+        StringSequence *_sequence;
+        Byte _inline[InlineCapacity + 1];
+    };
+
+    static const Byte InlineASCII = 0x80;
 
     //*- Constructors
 
     SuperString(StringSequence *sequence);
 
-    //*-- SingleLinkedList<E> (internal)
-    template<class E>
-    class SingleLinkedList {
-    public:
-        // forward declaration
-        template<class Ei>
-        class Node;
+    //*- Inline storage (internal)
 
-        Node<E> *_head;
-        Node<E> *_tail;
-    public:
-        //*- Constructors
+    /**
+     * Returns true if this string is stored inline rather than in a sequence.
+     */
+    inline bool isInline() const;
 
-        SingleLinkedList();
+    /**
+     * Returns the number of bytes this string stores inline.
+     */
+    inline std::size_t inlineByteLength() const;
 
-        //*- Destructor
+    /**
+     * Returns the number of code units this string stores inline.
+     */
+    std::size_t inlineLength() const;
 
-        ~SingleLinkedList();
+    /**
+     * Returns the offset of the code unit at [index] in the bytes stored inline.
+     */
+    std::size_t inlineOffset(std::size_t index) const;
 
-        //*- Getters
+    /**
+     * Stores the [byteLength] bytes of well formed UTF-8 at [bytes] inline,
+     * in place of an empty string.
+     */
+    void storeInline(const Byte *bytes, std::size_t byteLength);
 
-        std::size_t length() const;
+    /**
+     * Returns a string of a leaf sequence with the code units stored inline
+     * in this one, for code working on sequences.
+     */
+    SuperString materialize() const;
 
-        //*- Methods
+    /**
+     * Returns a string of a single leaf sequence with the code units stored
+     * inline in this string followed by those stored inline in [other].
+     */
+    SuperString materialize(const SuperString &other) const;
 
-        void push(E value);
+    /**
+     * Returns this inline string trimmed of white space on the left and/or the right.
+     */
+    SuperString trimInline(bool isLeft, bool isRight) const;
+
+    /**
+     * Returns the first, or last if [isReverse], position of [other] in this
+     * inline string.
+     */
+    SuperString::Result<std::size_t, SuperString::Error> searchInline(const SuperString &other, bool isReverse) const;
+
+    /**
+     * Stores the code units encoded at [bytes], up to their terminating NUL, in
+     * [string] inline. Returns false if they do not fit or are not well formed.
+     */
+    static bool Inline(const Byte *bytes, Encoding encoding, SuperString &string);
 
-        void remove(E value);
+    /**
+     * Stores the code units of [sequence] from [startIndex] to [endIndex] in
+     * [string] inline. Returns false if they do not fit.
+     */
+    static bool Inline(const StringSequence *sequence, std::size_t startIndex, std::size_t endIndex,
+                       SuperString &string);
 
-        template<class Ei>
-        class Node {
-        public:
-            Ei _data;
-            Node<E> *_next;
+    //*-- ReferencerSet (internal)
+    /**
+     * The sequences that reference a sequence, each with its cost of reconstruction,
+     * and their total. The first ones are stored inline, more spill into a hash
+     * table. A sequence may be added more than once, as both halves of a
+     * concatenation.
+     */
+    class ReferencerSet {
+    public:
+        struct Entry {
+            ReferenceStringSequence *_sequence;
+            std::size_t _cost;
+        };
 
-            //*- Constructors
+    private:
+        static const std::size_t InlineCount = 2;
+        static const std::size_t MinimumCapacity = 8;
 
-            Node(E data);
+        union {
+            Entry _inline[InlineCount];
+            Entry *_table;
         };
+        // zero while the entries are inline
+        std::size_t _capacity;
+        std::size_t _length;
+        std::size_t _cost;
+
+    public:
+        //*- Constructors
+
+        ReferencerSet();
+
+        //*- Destructor
+
+        ~ReferencerSet();
+
+        //*- Getters
+
+        std::size_t length() const;
+
+        /**
+         * Returns the sum of the costs of the entries.
+         */
+        std::size_t cost() const;
+
+        /**
+         * Returns the number of slots, to be iterated with `at`.
+         */
+        std::size_t slotCount() const;
+
+        /**
+         * Returns the sequence in [slot], or NULL if the slot is empty.
+         */
+        ReferenceStringSequence *at(std::size_t slot) const;
+
+        /**
+         * Returns whether [sequence] has an entry, wherever the entries are stored.
+         */
+        bool contains(const ReferenceStringSequence *sequence) const;
+
+        //*- Methods
+
+        void add(ReferenceStringSequence *sequence, std::size_t cost);
+
+        /**
+         * Removes one entry of [sequence], if any.
+         */
+        void remove(ReferenceStringSequence *sequence);
+
+        /**
+         * Recomputes the cost of every entry as a referencer of [owner].
+         */
+        void refresh(const StringSequence *owner);
+
+        void swap(SuperString::ReferencerSet &other);
+
+    private:
+        // not copyable
+        ReferencerSet(const SuperString::ReferencerSet &other);
+
+        SuperString::ReferencerSet &operator=(const SuperString::ReferencerSet &other);
+
+        std::size_t home(const ReferenceStringSequence *sequence) const;
+
+        void grow();
     };
 
     //*-- Pair<T, U>
@@ -363,11 +965,264 @@ private:
         void second(U $1);
     };
 
+    //*-- Cursor (internal)
+    /**
+     * A position inside the storage of a leaf: [_bytes] points at the encoded
+     * code unit, and [_startIndex, _endIndex) is the range of indexes, in the
+     * coordinates of the queried sequence, that are contiguous with it.
+     */
+    struct Cursor {
+        const Byte *_bytes;
+        Encoding _encoding;
+        std::size_t _startIndex;
+        std::size_t _endIndex;
+    };
+
+    //*-- ChunkVisitor (internal)
+    /**
+     * Called for every chunk of a traversal; returning false stops it.
+     */
+    typedef bool (*ChunkVisitor)(const Chunk &chunk, void *context);
+
+    /**
+     * Writes [chunk] to [buffer] in the given [encoding], copying the bytes
+     * as they are when the encodings agree. A NULL [buffer] only measures.
+     */
+    static SuperString::Result<std::size_t, SuperString::Error>
+    copyChunk(const Chunk &chunk, Byte *buffer, Encoding encoding);
+
+    /**
+     * The state of a copyTo traversal.
+     */
+    struct CopyContext {
+        Byte *_buffer;
+        std::size_t _size;
+        Encoding _encoding;
+        Error _error;
+    };
+
+    /**
+     * The visitor of copyTo; [context] is a CopyContext.
+     */
+    static bool copyVisitor(const Chunk &chunk, void *context);
+
+    /**
+     * The visitor of forEachChunk; [context] is the callback.
+     */
+    static bool forEachVisitor(const Chunk &chunk, void *context);
+
+    /**
+     * Visits the chunks of this string from [startIndex] to [endIndex], a
+     * valid range; an inline string is a single chunk.
+     */
+    bool visitChunks(std::size_t startIndex, std::size_t endIndex, ChunkVisitor visitor, void *context) const;
+
+    /**
+     * Compares the first [length] code units of [sequence] and [other], a run
+     * of contiguous storage at a time. A NULL sequence stands for the inline
+     * UTF-8 at [bytes], resp. [otherBytes].
+     */
+    static int compareSequences(const StringSequence *sequence, const Byte *bytes, const StringSequence *other,
+                                const Byte *otherBytes, std::size_t length);
+
+    /**
+     * Points [cursor] at the code unit at [index] of [sequence], or of the
+     * [length] code units of inline UTF-8 at [bytes] if it is NULL.
+     */
+    static bool cursorAt(const StringSequence *sequence, const Byte *bytes, std::size_t index, std::size_t length,
+                         Cursor &cursor);
+
+    /**
+     * Compares the [length] code units encoded at [bytes] and [otherBytes].
+     */
+    static int compareUnits(const Byte *bytes, Encoding encoding, const Byte *otherBytes, Encoding otherEncoding,
+                            std::size_t length);
+
+    /**
+     * Decodes the code unit at [pointer] and moves it past it.
+     */
+    static int nextCodeUnit(const Byte *&pointer, Encoding encoding);
+
+    //*-- OffsetIndex (internal)
+    /**
+     * A sampled index that maps every `stride`-th code unit of a variable width
+     * encoded buffer (UTF-8, UTF-16BE) to its byte offset, so that locating
+     * any code unit costs at most `stride` decoding steps.
+     */
+    class OffsetIndex {
+    private:
+        /**
+         * The stride, the number of samples, then the samples; published at
+         * once so that concurrent readers never see a partial index.
+         */
+#ifdef SUPERSTRING_THREAD_SAFE
+        std::atomic<std::size_t *> _offsets;
+#else
+        std::size_t *_offsets;
+#endif
+
+    public:
+        //*- Constructors
+
+        OffsetIndex();
+
+        //*- Destructor
+
+        ~OffsetIndex();
+
+        //*- Getters
+
+        /**
+         * Returns the memory used by this index, in bytes.
+         */
+        std::size_t memoryLength() const;
+
+        //*- Methods
+
+        /**
+         * Returns the byte offset of the code unit at [index] in [bytes], building
+         * the index on the first access that is far enough from the start, in
+         * which case [owner] is told that its keeping cost changed.
+         */
+        SuperString::Result<std::size_t, SuperString::Error>
+        offset(const StringSequence *owner, const Byte *bytes, SuperString::Encoding encoding, std::size_t length,
+               std::size_t index);
+
+        /**
+         * Drops the index, to be called when the indexed buffer changes.
+         */
+        void reset();
+
+    private:
+        static std::size_t *build(const Byte *bytes, SuperString::Encoding encoding, std::size_t length,
+                                  std::size_t stride);
+    };
+
+    static std::size_t _offsetIndexStride;
+
+    //*-- HashIndex (internal)
+    /**
+     * Samples the hashes of the prefixes of a flat sequence every `Stride` code
+     * units, so that hashing any of its substrings scans at most twice that.
+     */
+    class HashIndex {
+    private:
+        /**
+         * The number of samples, then the samples; published at once so that
+         * concurrent readers never see a partial index.
+         */
+#ifdef SUPERSTRING_THREAD_SAFE
+        std::atomic<std::uint64_t *> _hashes;
+#else
+        std::uint64_t *_hashes;
+#endif
+
+    public:
+        static const std::size_t Stride = 64;
+
+        //*- Constructors
+
+        HashIndex();
+
+        //*- Destructor
+
+        ~HashIndex();
+
+        //*- Getters
+
+        /**
+         * Returns the memory used by this index, in bytes.
+         */
+        std::size_t memoryLength() const;
+
+        //*- Methods
+
+        /**
+         * Returns the hash of the code units of [owner] from [startIndex],
+         * inclusive, to [endIndex], exclusive. The index is built by the first
+         * range that covers an eighth of [owner] or more, and [owner] is then
+         * told that its keeping cost changed.
+         */
+        std::uint64_t hashOf(const StringSequence *owner, std::size_t startIndex, std::size_t endIndex);
+
+        /**
+         * Drops the index, to be called when the indexed sequence changes.
+         */
+        void reset();
+
+    private:
+        std::uint64_t prefix(const StringSequence *owner, const std::uint64_t *hashes, std::size_t index) const;
+
+        static std::uint64_t *build(const StringSequence *owner);
+    };
+
+    //*-- Counters (internal)
+#ifdef SUPERSTRING_THREAD_SAFE
+    typedef std::atomic<std::size_t> Counter;
+#else
+    typedef std::size_t Counter;
+#endif
+
+    /**
+     * The counters behind `Stats`.
+     */
+    struct Counters {
+        Counter _sequenceCount;
+        Counter _referencerCount;
+        Counter _freeingCost;
+        Counter _retainedBytes;
+        Counter _retentionCount;
+        Counter _reconstructionCount;
+        Counter _reconstructedBytes;
+    };
+
+    static Counters _counters;
+
+    static RetentionPolicy::CostBased _costBasedPolicy;
+
+    static RetentionPolicy *_retentionPolicy;
+
+    static bool _isReconstructionDeferred;
+
+    // held by a reference each until collected
+    static std::vector<StringSequence *> _deferred;
+
+    static void countUp(Counter &counter, std::size_t delta);
+
+    static void countDown(Counter &counter, std::size_t delta);
+
     //*-- StringSequence (abstract|internal)
     class StringSequence {
     private:
+#ifdef SUPERSTRING_THREAD_SAFE
+        std::atomic<std::size_t> _refCount;
+        std::atomic_flag _referencersLock;
+#else
         std::size_t _refCount;
-        SingleLinkedList<ReferenceStringSequence *> _referencers;
+        // the keeping cost counted in the retained bytes while released but kept
+        std::size_t _retainedCost;
+#endif
+        ReferencerSet _referencers;
+        RetentionPolicy *_retentionPolicy;
+        // the pool holding this sequence weakly, if any
+#ifdef SUPERSTRING_THREAD_SAFE
+        std::atomic<InternPool *> _internPool;
+#else
+        InternPool *_internPool;
+#endif
+
+    protected:
+        /**
+         * The cached hash, or `HashNotComputed`.
+         */
+#ifdef SUPERSTRING_THREAD_SAFE
+        std::atomic<std::uint64_t> _hash;
+#else
+        std::uint64_t _hash;
+#endif
+        HashIndex _hashIndex;
+
+        static const std::uint64_t HashNotComputed = (std::uint64_t) -1;
 
     public:
         // Constructors
@@ -381,6 +1236,15 @@ private:
          */
         virtual ~StringSequence();
 
+        //*- Allocation
+
+        /**
+         * Sequences are allocated by the `NodeAllocator`.
+         */
+        static void *operator new(std::size_t size);
+
+        static void operator delete(void *pointer);
+
         //*- Getters
 
         /**
@@ -398,6 +1262,30 @@ private:
          */
         virtual std::size_t length() const = 0;
 
+        /**
+         * Returns the number of reference levels below this sequence, flat
+         * sequences have a depth of 0.
+         */
+        virtual std::size_t depth() const;
+
+        /**
+         * Returns the number of bytes per code unit that a reconstruction of
+         * this sequence takes, or an upper bound when it is not known.
+         */
+        virtual std::size_t packedWidth() const;
+
+        /**
+         * Returns true if the code units of this sequence are not its own, but
+         * borrowed from a buffer or a file that may change or go away.
+         */
+        virtual bool isBorrowed() const;
+
+        /**
+         * Returns false if this sequence was made from ill-formed input, which
+         * it keeps as an empty string.
+         */
+        virtual bool isValid() const;
+
         //*- Methods
 
         /**
@@ -405,8 +1293,31 @@ private:
          */
         virtual SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const = 0;
 
+        /**
+         * Points [cursor] at the code unit at the given [index], and bounds it
+         * by the contiguous run of storage that contains it. Returns false if
+         * [index] is out of range.
+         */
+        virtual bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const = 0;
+
+        /**
+         * Calls [visitor] on the chunks that hold the code units from
+         * [startIndex], inclusive, to [endIndex], exclusive, in order, in a
+         * single descent. Returns false if the visitor stopped the traversal.
+         */
+        virtual bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                                 void *context) const = 0;
+
+        /**
+         * Returns the position of the first occurrence of [other] in this sequence,
+         * or SuperString::Error::NotFound. An empty [other] is found at 0.
+         */
         SuperString::Result<std::size_t, SuperString::Error> indexOf(SuperString other) const;
 
+        /**
+         * Returns the position of the last occurrence of [other] in this sequence,
+         * or SuperString::Error::NotFound. An empty [other] is found at the end.
+         */
         SuperString::Result<std::size_t, SuperString::Error> lastIndexOf(SuperString other) const;
 
         /**
@@ -443,18 +1354,96 @@ private:
          */
         virtual SuperString trimRight() const = 0;
 
+        /**
+         * Returns this sequence with the parts of at most [threshold] code units
+         * flattened, flat sequences as they are.
+         */
+        virtual SuperString compact(std::size_t threshold) const;
+
+        /**
+         * Returns the code units from [startIndex], inclusive, to [endIndex],
+         * exclusive, with the range already checked: this sequence or one of its
+         * parts if it covers the range exactly, otherwise a new sequence that
+         * nothing holds yet, built from the parts the range touches.
+         */
+        virtual const SuperString::StringSequence *slice(std::size_t startIndex, std::size_t endIndex) const;
+
+        /**
+         * Returns the hash of this sequence, computed on the first call.
+         */
+        std::uint64_t hash() const;
+
+        /**
+         * Returns the hash of the code units from [startIndex], inclusive, to
+         * [endIndex], exclusive, the cached one for the whole sequence.
+         */
+        std::uint64_t hash(std::size_t startIndex, std::size_t endIndex) const;
+
+        /**
+         * Computes the hash of the code units from [startIndex], inclusive, to
+         * [endIndex], exclusive; flat sequences go through their hash index.
+         */
+        virtual std::uint64_t hashOf(std::size_t startIndex, std::size_t endIndex) const;
+
+        /**
+         * Appends [other] to the end of this sequence, in place. Only called on
+         * a unique sequence; returns false, leaving this sequence unchanged, if
+         * it cannot hold [other].
+         */
+        virtual bool append(const StringSequence *other);
+
+        /**
+         * Returns true if a single string holds this sequence, no other sequence
+         * references it and no pool interns it, so that it can be changed in place.
+         * Checked under the referencer lock, the answer holds as long as the
+         * caller's string does.
+         */
+        bool isUnique() const;
+
+        /**
+         * Returns true if no string holds this sequence and [sequence] is its
+         * only referencer, so that [sequence] can change it in place. Checked
+         * under the referencer lock.
+         */
+        bool isOwnedBy(const ReferenceStringSequence *sequence) const;
+
         // TODO: comment
         virtual std::size_t keepingCost() const = 0;
 
-        // TODO: comment
+        /**
+         * Returns what deleting this sequence would cost its referencers, kept
+         * up to date as they come and go.
+         */
         std::size_t freeingCost() const;
 
         // TODO: comment
         void refAdd() const;
 
+        /**
+         * Adds a reference unless no string holds this sequence anymore, a
+         * sequence whose count dropped to 0 being on its way to `tryDelete`.
+         * Always adds one when not thread safe.
+         */
+        bool refAddIfHeld() const;
+
         // TODO: comment
         std::size_t refRelease() const;
 
+        /**
+         * Releases a reference and tries to delete this sequence if it was the
+         * last one, see `tryDelete`. In the thread-safe build the count is taken
+         * to 0 and the sequence claimed in one step under the referencer lock, so
+         * that only the thread releasing the last reference deletes it.
+         */
+        void release(bool isDeferrable = true) const;
+
+        /**
+         * Removes [sequence] from the referencers and tries to delete this
+         * sequence if nothing else holds it, as `release` does. This sequence is
+         * held meanwhile, another thread may release it once [sequence] is gone.
+         */
+        void dropReferencer(SuperString::ReferenceStringSequence *sequence) const;
+
         // TODO: comment
         std::size_t refCount() const;
 
@@ -467,23 +1456,195 @@ private:
         // TODO: comment
         void reconstructReferencers();
 
-    protected:
-        virtual void doDelete() const = 0;
+        /**
+         * Sets the [policy] deciding whether to keep this sequence, NULL for the
+         * global one.
+         */
+        void retentionPolicy(SuperString::RetentionPolicy *policy);
 
-        virtual bool isToBeDeleted() const = 0;
+        /**
+         * Deletes this sequence once no string holds it any more and its
+         * retention policy frees it. Unless [isDeferrable] is false, freeing a
+         * referenced sequence may be deferred to `collect`. Only for a sequence
+         * no other thread can reach, `release` and `dropReferencer` otherwise.
+         *
+         * In the thread-safe build, sequences are never reconstructed under the
+         * feet of other threads: one is deleted only when no other sequence
+         * references it either, and kept as long as one does. Retention
+         * policies, the retention counters and deferral do not apply there.
+         */
+        void tryDelete(bool isDeferrable = true) const;
 
-    private:
-        bool _substringMatches(std::size_t startIndex, SuperString other) const;
+    protected:
+        /**
+         * Marks this sequence as being destructed and deletes it, unless it is
+         * already being destructed.
+         */
+        void doDelete() const;
 
-        friend class SuperString;
-    };
+        /**
+         * Returns true once [doDelete] has started destructing this sequence.
+         */
+        bool isToBeDeleted() const;
 
-    //*-- ReferenceStringSequence (abstract|internal)
-    class ReferenceStringSequence: public StringSequence {
-    public:
-        //*- Destructor
+        /**
+         * Drops the cached keeping cost of every sequence referencing this one,
+         * to be called whenever the keeping cost of this sequence changes.
+         */
+        void keepingCostChanged() const;
 
-        virtual ~ReferenceStringSequence();
+        /**
+         * Recomputes what reconstructing every referencer would cost, to be called
+         * whenever the length or the packed width of this sequence changes.
+         */
+        void reconstructionCostChanged() const;
+
+        /**
+         * Drops the cached hash and the hash index, to be called whenever the
+         * code units of this sequence change.
+         */
+        void hashChanged();
+
+        /**
+         * Deletes [sequence], built by [slice], unless it was used as a part.
+         */
+        static void discard(const StringSequence *sequence);
+
+    private:
+        /**
+         * Guard the referencer set in the thread-safe build, do nothing otherwise.
+         */
+        void lockReferencers() const;
+
+        void unlockReferencers() const;
+
+#ifdef SUPERSTRING_THREAD_SAFE
+        /**
+         * Swaps a count of 0 for the deletion mark if no sequence references this
+         * one, under the referencer lock. Returns true if this thread is to delete it.
+         */
+        bool claim() const;
+
+        /**
+         * Deletes this claimed sequence, once out of its intern pool.
+         */
+        void deleteClaimed() const;
+#endif
+
+        /**
+         * Searches the first, or the last if [isReverse], occurrence of the
+         * non-empty [other], no longer than this sequence.
+         */
+        SuperString::Result<std::size_t, SuperString::Error> _search(SuperString other, bool isReverse) const;
+
+        /**
+         * Searches [pattern], the UTF-8 encoding of a string of [otherLength]
+         * code units, block by block. Fails with SuperString::Error::Unencodable
+         * if this sequence holds code units that UTF-8 cannot represent.
+         */
+        SuperString::Result<std::size_t, SuperString::Error>
+        _searchEncoded(std::size_t otherLength, const SuperString::Byte *pattern, std::size_t patternLength,
+                       bool isReverse, const std::size_t *skips) const;
+
+        /**
+         * Searches [other] block by block over decoded 32-bit code units.
+         */
+        SuperString::Result<std::size_t, SuperString::Error> _searchCodeUnits(SuperString other, bool isReverse) const;
+
+        /**
+         * The number of candidate positions decoded at once when searching a
+         * sequence that is not a single flat byte buffer.
+         */
+        static const std::size_t SearchBlockLength = 4096;
+
+        /**
+         * Stores [chunk] in [context], a Chunk, as long as it is the only one
+         * visited; a second chunk resets it and stops the traversal.
+         */
+        static bool _singleChunk(const SuperString::Chunk &chunk, void *context);
+
+        /**
+         * Returns [string] encoded in [encoding] in a new buffer of [byteLength]
+         * bytes, or NULL if [encoding] cannot represent it.
+         */
+        static SuperString::Byte *_encode(SuperString string, SuperString::Encoding encoding,
+                                          std::size_t &byteLength);
+
+        /**
+         * Decodes the code units from [startIndex] to [endIndex] into [codeUnits].
+         */
+        void _decode(std::size_t startIndex, std::size_t endIndex, int *codeUnits) const;
+
+        /**
+         * Fills the 256 entries of [skips], the Boyer-Moore-Horspool shifts of
+         * [pattern] keyed by the low byte of each unit, for a forward search or
+         * a backward one if [isReverse].
+         */
+        template<class T>
+        static void _skips(const T *pattern, std::size_t patternLength, bool isReverse, std::size_t *skips);
+
+        /**
+         * Returns the first position of [pattern] in [text], scanning forward
+         * with the [skips] of _skips.
+         */
+        template<class T>
+        static SuperString::Result<std::size_t, SuperString::Error>
+        _horspool(const T *text, std::size_t textLength, const T *pattern, std::size_t patternLength,
+                  const std::size_t *skips);
+
+        /**
+         * Returns the last position of [pattern] in [text], scanning backward
+         * with the reverse [skips] of _skips.
+         */
+        template<class T>
+        static SuperString::Result<std::size_t, SuperString::Error>
+        _reverseHorspool(const T *text, std::size_t textLength, const T *pattern, std::size_t patternLength,
+                         const std::size_t *skips);
+
+        /**
+         * Returns the first position of [pattern] in [text], locating candidates
+         * with memchr on the first byte.
+         */
+        static SuperString::Result<std::size_t, SuperString::Error>
+        _findBytes(const SuperString::Byte *text, std::size_t textLength, const SuperString::Byte *pattern,
+                   std::size_t patternLength);
+
+        /**
+         * Returns the first, or the last if [isReverse], position of [pattern] in
+         * the UTF-8 [text], as a code unit index. [skips] are the reverse shifts
+         * of [pattern].
+         */
+        static SuperString::Result<std::size_t, SuperString::Error>
+        _searchBytes(const SuperString::Byte *text, std::size_t textLength, const SuperString::Byte *pattern,
+                     std::size_t patternLength, bool isReverse, const std::size_t *skips);
+
+        friend class SuperString;
+
+        friend class InternPool;
+    };
+
+    //*-- ReferenceStringSequence (abstract|internal)
+    class ReferenceStringSequence: public StringSequence {
+    protected:
+        /**
+         * The cached keeping cost, or `KeepingCostNotComputed`.
+         */
+#ifdef SUPERSTRING_THREAD_SAFE
+        std::atomic<std::size_t> _keepingCost;
+#else
+        std::size_t _keepingCost;
+#endif
+
+        static const std::size_t KeepingCostNotComputed = (std::size_t) -1;
+
+    public:
+        //*- Constructors
+
+        ReferenceStringSequence();
+
+        //*- Destructor
+
+        virtual ~ReferenceStringSequence();
 
         //*- Getters
 
@@ -493,10 +1654,17 @@ private:
 
         virtual std::size_t length() const = 0 /*override*/;
 
+        virtual std::size_t depth() const = 0 /*override*/;
+
         //*- Methods
 
         virtual SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const = 0 /*override*/;
 
+        virtual bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const = 0 /*override*/;
+
+        virtual bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                                 void *context) const = 0 /*override*/;
+
         virtual SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const = 0 /*override*/;
 
@@ -521,10 +1689,43 @@ private:
         // TODO: comment
         virtual void reconstruct(const StringSequence *sequence) const = 0;
 
-    protected:
-        virtual void doDelete() const = 0;
+        /**
+         * Drops the cached keeping cost of this sequence and of its referencers.
+         */
+        void invalidateKeepingCost() const;
+
+        /**
+         * Copies the code units of [sequence] from [startIndex], inclusive, to
+         * [endIndex], exclusive, in the narrowest [encoding] that holds them
+         * all: ASCII, UTF-16BE without surrogates, or else UTF-32.
+         */
+        static SuperString::Byte *
+        pack(const StringSequence *sequence, std::size_t startIndex, std::size_t endIndex,
+             SuperString::Encoding &encoding);
+
+        /**
+         * Returns the number of bytes per code unit of data packed in [encoding].
+         */
+        static std::size_t widthOf(SuperString::Encoding encoding);
+
+        /**
+         * Returns the code unit at [index] of packed [data].
+         */
+        static int unpack(const SuperString::Byte *data, SuperString::Encoding encoding, std::size_t index);
 
-        virtual bool isToBeDeleted() const = 0;
+        /**
+         * Calls [visitor] on the code units of packed [data] from [startIndex],
+         * inclusive, to [endIndex], exclusive.
+         */
+        static bool visitData(const SuperString::Byte *data, SuperString::Encoding encoding, std::size_t startIndex,
+                              std::size_t endIndex, SuperString::ChunkVisitor visitor, void *context);
+
+        /**
+         * Prints the code units of packed [data] from [startIndex], inclusive,
+         * to [endIndex], exclusive.
+         */
+        static void printData(std::ostream &stream, const SuperString::Byte *data, SuperString::Encoding encoding,
+                              std::size_t startIndex, std::size_t endIndex);
     };
 
     //*-- ConstASCIISequence (internal)
@@ -532,8 +1733,7 @@ private:
     private:
         enum class Status {
             LengthNotComputed,
-            LengthComputed,
-            ToBeDestructed
+            LengthComputed
         };
 
         const Byte *_bytes;
@@ -557,10 +1757,19 @@ private:
 
         std::size_t length() const /*override*/;
 
+        bool isBorrowed() const /*override*/;
+
+        std::size_t packedWidth() const /*override*/;
+
         //*- Methods
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -580,11 +1789,6 @@ private:
         // inherited: std::size_t freeingCost() const;
 
         friend class CopyASCIISequence;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*-- CopyASCIISequence (internal)
@@ -592,6 +1796,7 @@ private:
     private:
         Byte *_data;
         std::size_t _length;
+        std::size_t _capacity;
 
     public:
         //*- Constructors
@@ -600,6 +1805,12 @@ private:
 
         CopyASCIISequence(const SuperString::ConstASCIISequence *sequence);
 
+        /**
+         * Takes over [data], [length] ASCII bytes followed by a NUL in a buffer
+         * of [capacity] bytes allocated with `new[]`.
+         */
+        CopyASCIISequence(SuperString::Byte *data, std::size_t length, std::size_t capacity);
+
         //*- Destructor
 
         ~CopyASCIISequence();
@@ -612,10 +1823,17 @@ private:
 
         std::size_t length() const /*override*/;
 
+        std::size_t packedWidth() const /*override*/;
+
         //*- Methods
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -630,14 +1848,11 @@ private:
 
         SuperString trimRight() const /*override*/;
 
+        bool append(const StringSequence *other) /*override*/;
+
         std::size_t keepingCost() const /*override*/;
 
         // inherited: std::size_t freeingCost() const;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*--ConstUTF8Sequence (internal)
@@ -646,12 +1861,14 @@ private:
         enum class Status {
             LengthNotComputed,
             LengthComputed,
-            ToBeDestructed
+            // ill-formed, kept with a length of 0
+            Invalid
         };
 
         const Byte *_bytes;
         std::size_t _length;
         Status _status;
+        OffsetIndex _offsetIndex;
 
     public:
         //*- Constructors
@@ -670,10 +1887,19 @@ private:
 
         std::size_t length() const /*override*/;
 
+        bool isBorrowed() const /*override*/;
+
+        bool isValid() const /*override*/;
+
         //*- Methods
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -693,11 +1919,6 @@ private:
         // inherited:SuperString:: std::size_t freeingCost() const;
 
         friend class CopyUTF8Sequence;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*-- CopyUTF8Sequence (internal)
@@ -706,6 +1927,10 @@ private:
         Byte *_data;
         std::size_t _length;
         std::size_t _memoryLength;
+        std::size_t _capacity;
+        // false if copied from ill-formed UTF-8, kept with a length of 0
+        bool _isValid;
+        OffsetIndex _offsetIndex;
 
     public:
         //*- Constructors
@@ -714,6 +1939,12 @@ private:
 
         CopyUTF8Sequence(const SuperString::ConstUTF8Sequence *sequence);
 
+        /**
+         * Takes over [data], [length] code units over [memoryLength] bytes, the
+         * terminating NUL included, in a buffer of [capacity] bytes allocated with `new[]`.
+         */
+        CopyUTF8Sequence(SuperString::Byte *data, std::size_t length, std::size_t memoryLength, std::size_t capacity);
+
         //*- Destructor
 
         ~CopyUTF8Sequence();
@@ -726,10 +1957,19 @@ private:
 
         std::size_t length() const /*override*/;
 
+        std::size_t packedWidth() const /*override*/;
+
+        bool isValid() const /*override*/;
+
         //*- Methods
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -744,14 +1984,11 @@ private:
 
         SuperString trimRight() const /*override*/;
 
+        bool append(const StringSequence *other) /*override*/;
+
         std::size_t keepingCost() const /*override*/;
 
         // inherited: std::size_t freeingCost() const;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*-- ConstUTF16BESequence (internal)
@@ -759,13 +1996,13 @@ private:
     private:
         enum class Status {
             LengthNotComputed,
-            LengthComputed,
-            ToBeDestructed
+            LengthComputed
         };
 
         const Byte *_bytes;
         std::size_t _length;
         Status _status;
+        OffsetIndex _offsetIndex;
 
     public:
         //*- Constructors
@@ -784,10 +2021,17 @@ private:
 
         std::size_t length() const /*override*/;
 
+        bool isBorrowed() const /*override*/;
+
         //*- Methods
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -807,11 +2051,6 @@ private:
         // inherited:SuperString:: std::size_t freeingCost() const;
 
         friend class CopyUTF16BESequence;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*-- CopyUTF16BESequence (internal)
@@ -820,6 +2059,7 @@ private:
         Byte *_data;
         std::size_t _length;
         std::size_t _memoryLength;
+        OffsetIndex _offsetIndex;
 
     public:
         //*- Constructors
@@ -828,6 +2068,12 @@ private:
 
         CopyUTF16BESequence(const SuperString::ConstUTF16BESequence *sequence);
 
+        /**
+         * Takes over [data], [length] code points over [memoryLength] bytes, the
+         * terminating NUL included, allocated with `new[]`.
+         */
+        CopyUTF16BESequence(SuperString::Byte *data, std::size_t length, std::size_t memoryLength);
+
         //*- Destructor
 
         ~CopyUTF16BESequence();
@@ -844,6 +2090,11 @@ private:
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -861,11 +2112,6 @@ private:
         std::size_t keepingCost() const /*override*/;
 
         // inherited: std::size_t freeingCost() const;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*-- ConstUTF32Sequence (internal)
@@ -873,8 +2119,7 @@ private:
     private:
         enum class Status {
             LengthNotComputed,
-            LengthComputed,
-            ToBeDestructed
+            LengthComputed
         };
 
         const int *_bytes;
@@ -898,10 +2143,17 @@ private:
 
         std::size_t length() const /*override*/;
 
+        bool isBorrowed() const /*override*/;
+
         //*- Methods
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -921,11 +2173,6 @@ private:
         // inherited: std::size_t freeingCost() const;
 
         friend class CopyUTF32Sequence;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*-- CopyUTF32Sequence (internal)
@@ -941,6 +2188,12 @@ private:
 
         CopyUTF32Sequence(const SuperString::ConstUTF32Sequence *sequence);
 
+        /**
+         * Takes over [data], [length] code units followed by a NUL, allocated
+         * with `new[]`.
+         */
+        CopyUTF32Sequence(int *data, std::size_t length);
+
         //*- Destructor
 
         ~CopyUTF32Sequence();
@@ -957,6 +2210,11 @@ private:
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -974,11 +2232,31 @@ private:
         std::size_t keepingCost() const /*override*/;
 
         // inherited: std::size_t freeingCost() const;
+    };
 
-    protected:
-        void doDelete() const;
+    //*-- MappedSequence<T> (internal)
+    /**
+     * A `Const` sequence over a file mapped by `MapFile`, followed by at least
+     * one page of zeros as its terminator. The mapping is released with the sequence.
+     */
+    template<class T>
+    class MappedSequence: public T {
+    private:
+        Byte *_region;
+        std::size_t _regionLength;
 
-        bool isToBeDeleted() const;
+    public:
+        //*- Constructors
+
+        MappedSequence(SuperString::Byte *region, std::size_t regionLength);
+
+        //*- Destructor
+
+        ~MappedSequence();
+
+        //*- Methods
+
+        std::size_t keepingCost() const /*override*/;
     };
 
     //*-- SubstringSequence (internal)
@@ -994,7 +2272,8 @@ private:
             std::size_t _endIndex;
         };
         struct ReconstructedMetaInfo {
-            int *_data;
+            Byte *_data;
+            Encoding _encoding;
             std::size_t _length;
         };
 
@@ -1019,10 +2298,19 @@ private:
 
         std::size_t length() const /*override*/;
 
+        std::size_t depth() const /*override*/;
+
+        std::size_t packedWidth() const /*override*/;
+
         //*- Methods
 
         SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
 
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
         SuperString::Result<SuperString, SuperString::Error>
         substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
 
@@ -1037,6 +2325,10 @@ private:
 
         SuperString trimRight() const /*override*/;
 
+        const SuperString::StringSequence *slice(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        std::uint64_t hashOf(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
         std::size_t keepingCost() const /*override*/;
 
         // inherited: std::size_t freeingCost() const;
@@ -1046,11 +2338,6 @@ private:
         void reconstruct(const StringSequence *sequence) const /*override*/;
 
         friend class StringSequence;
-
-    protected:
-        void doDelete() const;
-
-        bool isToBeDeleted() const;
     };
 
     //*-- ConcatenationSequence (internal)
@@ -1068,227 +2355,785 @@ private:
         };
         struct LeftReconstructedMetaInfo {
             const StringSequence *_right;
-            int *_leftData;
+            Byte *_leftData;
+            Encoding _leftEncoding;
             std::size_t _leftLength;
         };
         struct RightReconstructedMetaInfo {
             const StringSequence *_left;
-            int *_rightData;
+            Byte *_rightData;
+            Encoding _rightEncoding;
             std::size_t _rightLength;
         };
         struct ReconstructedMetaInfo {
-            int *_data;
+            Byte *_data;
+            Encoding _encoding;
             std::size_t _length;
         };
 
-        Kind _kind;
-        union {
-            struct ConcatenationMetaInfo _concatenation;
-            struct LeftReconstructedMetaInfo _leftReconstructed;
-            struct RightReconstructedMetaInfo _rightReconstructed;
-            struct ReconstructedMetaInfo _reconstructed;
-        } _container;
+        Kind _kind;
+        std::size_t _length;
+        std::size_t _depth;
+        std::size_t _packedWidth;
+        union {
+            struct ConcatenationMetaInfo _concatenation;
+            struct LeftReconstructedMetaInfo _leftReconstructed;
+            struct RightReconstructedMetaInfo _rightReconstructed;
+            struct ReconstructedMetaInfo _reconstructed;
+        } _container;
+
+    public:
+        /**
+         * Concatenations whose combined length stays under this limit are
+         * flattened into a single copy instead of adding a node, and strings
+         * this short are appended in place to a unique string.
+         */
+        static const std::size_t MergeLength = 128;
+
+        //*- Constructors
+
+        ConcatenationSequence(const StringSequence *leftSequence, const StringSequence *rightSequence);
+
+        //*- Destructor
+
+        ~ConcatenationSequence();
+
+        //*- Getters
+
+        SuperString::ConcatenationSequence::Kind kind() const;
+
+        std::size_t length() const /*override*/;
+
+        std::size_t depth() const /*override*/;
+
+        std::size_t packedWidth() const /*override*/;
+
+        //*- Methods
+
+        SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
+
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
+        SuperString::Result<SuperString, SuperString::Error>
+        substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        bool print(std::ostream &stream) const /*override*/;
+
+        bool
+        print(std::ostream &stream, std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        SuperString trim() const /*override*/;
+
+        SuperString trimLeft() const /*override*/;
+
+        SuperString trimRight() const /*override*/;
+
+        SuperString compact(std::size_t threshold) const /*override*/;
+
+        const SuperString::StringSequence *slice(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        std::uint64_t hashOf(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        bool append(const StringSequence *other) /*override*/;
+
+        std::size_t keepingCost() const /*override*/;
+
+        // inherited: std::size_t freeingCost() const;
+
+        std::size_t reconstructionCost(const StringSequence *sequence) const /*override*/;
+
+        void reconstruct(const StringSequence *sequence) const /*override*/;
+
+        //*- Statics
+
+        /**
+         * Returns a sequence holding [left] followed by [right]. Short operands are
+         * merged into a flat copy and the tree is rebalanced AVL-style on the node
+         * depths, so access stays logarithmic however the string was appended to.
+         */
+        static const SuperString::StringSequence *
+        concatenate(const StringSequence *left, const StringSequence *right);
+
+    private:
+        static const SuperString::ConcatenationSequence *asConcatenation(const StringSequence *sequence);
+
+        /**
+         * Returns what packing the child [sequence] costs a concatenation. A
+         * child that is itself a tree is charged its whole keeping cost: the
+         * concatenation covers all of it, so packing would only trade its nodes
+         * for a copy of every code unit, and would copy the whole prefix again
+         * on each append to a string that keeps growing.
+         */
+        static std::size_t packingCost(const StringSequence *sequence);
+
+        static const SuperString::StringSequence *merge(const StringSequence *left, const StringSequence *right);
+
+        static const SuperString::StringSequence *
+        replaceLast(const StringSequence *sequence, const StringSequence *right);
+
+        static const SuperString::StringSequence *
+        replaceFirst(const StringSequence *left, const StringSequence *sequence);
+
+        static SuperString::Pair<const SuperString::StringSequence *, const SuperString::StringSequence *>
+        joinRight(const ConcatenationSequence *left, const StringSequence *right);
+
+        static SuperString::Pair<const SuperString::StringSequence *, const SuperString::StringSequence *>
+        joinLeft(const StringSequence *left, const ConcatenationSequence *right);
+    };
+
+    //*-- MultipleSequence (internal)
+    class MultipleSequence: public ReferenceStringSequence {
+    private:
+        struct MultipleMetaInfo {
+            std::size_t _time;
+            const StringSequence *_sequence;
+        };
+        struct ReconstructedMetaInfo {
+            std::size_t _time;
+            Byte *_data;
+            Encoding _encoding;
+            std::size_t _dataLength;
+        };
+        enum class Kind {
+            MULTIPLE,
+            RECONSTRUCTED
+        };
+
+        Kind _kind;
+        std::size_t _length;
+        std::size_t _depth;
+        union {
+            struct MultipleMetaInfo _multiple;
+            struct ReconstructedMetaInfo _reconstructed;
+        } _container;
+
+    public:
+        //*- Constructors
+
+        MultipleSequence(const StringSequence *sequence, std::size_t time);
+
+        //*- Destructor
+
+        ~MultipleSequence();
+
+        //*- Getters
+
+        SuperString::MultipleSequence::Kind kind() const;
+
+        std::size_t length() const /*override*/;
+
+        std::size_t depth() const /*override*/;
+
+        std::size_t packedWidth() const /*override*/;
+
+        //*- Methods
+
+        SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
+
+        bool cursorAt(std::size_t index, SuperString::Cursor &cursor) const /*override*/;
+
+        bool visitChunks(std::size_t startIndex, std::size_t endIndex, SuperString::ChunkVisitor visitor,
+                         void *context) const /*override*/;
+
+        SuperString::Result<SuperString, SuperString::Error>
+        substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        bool print(std::ostream &stream) const /*override*/;
+
+        bool
+        print(std::ostream &stream, std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        SuperString trim() const /*override*/;
+
+        SuperString trimLeft() const /*override*/;
+
+        SuperString trimRight() const /*override*/;
+
+        const SuperString::StringSequence *slice(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        std::uint64_t hashOf(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+
+        std::size_t keepingCost() const /*override*/;
+
+        // inherited: std::size_t freeingCost() const;
+
+        std::size_t reconstructionCost(const StringSequence *sequence) const /*override*/;
+
+        void reconstruct(const StringSequence *sequence) const /*override*/;
+    };
+
+    inline static bool isWhiteSpace(int codeUnit);
+
+    //
+    class ASCII {
+    public:
+        static std::size_t length(const SuperString::Byte *bytes);
+
+        static int codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
+                          std::size_t endIndex);
+
+        static SuperString::Pair<std::size_t, std::size_t>
+        trim(const SuperString::Byte *bytes, std::size_t length);
+
+        static std::size_t trimLeft(const SuperString::Byte *bytes);
+
+        static std::size_t trimRight(const SuperString::Byte *bytes, std::size_t length);
+
+        /**
+         * Writes [codeUnit] to [bytes] as Latin-1 and returns 1, or 0 if it does
+         * not fit in a byte.
+         */
+        static std::size_t encode(int codeUnit, SuperString::Byte *bytes);
+
+        /**
+         * Returns true if none of the [length] bytes at [bytes] is above 0x7f,
+         * so that they read the same in UTF-8, checking them a word at a time.
+         */
+        static bool isSevenBit(const SuperString::Byte *bytes, std::size_t length);
+    };
+
+    class UTF8 {
+    public:
+        /**
+         * Returns the number of code units of [bytes], or
+         * SuperString::Error::InvalidByteSequence if it is not well formed UTF-8.
+         */
+        static SuperString::Result<std::size_t, SuperString::Error> length(const SuperString::Byte *bytes);
+
+        /**
+         * Returns the number of code units in the first [byteLength] bytes of
+         * well formed UTF-8 at [bytes], counting them a word at a time.
+         */
+        static std::size_t length(const SuperString::Byte *bytes, std::size_t byteLength);
+
+        /**
+         * Returns the length and the memory length of [bytes], or
+         * SuperString::Error::InvalidByteSequence if it is not well formed UTF-8.
+         */
+        static SuperString::Result<SuperString::Pair<std::size_t, std::size_t>, SuperString::Error>
+        lengthAndMemoryLength(const SuperString::Byte *bytes);
+
+        /**
+         * Returns the length and the memory length of [bytes] if it is well formed
+         * UTF-8, otherwise stores the offset of the first invalid byte in [errorOffset].
+         */
+        static SuperString::Result<SuperString::Pair<std::size_t, std::size_t>, SuperString::Error>
+        validate(const SuperString::Byte *bytes, std::size_t *errorOffset);
+
+        /**
+         * Returns a pointer to the first byte from [pointer] that is either
+         * non-ASCII or the terminating NUL, using the widest vector unit available.
+         */
+        static const SuperString::Byte *skipASCII(const SuperString::Byte *pointer);
+
+        /**
+         * Returns a pointer to the first byte from [pointer], at a sequence start,
+         * up to which the bytes are well formed UTF-8 without a NUL, classifying
+         * whole vector blocks at once. It may stop anywhere before the first
+         * ill-formed sequence or the terminating NUL, even at [pointer].
+         */
+        static const SuperString::Byte *skipValid(const SuperString::Byte *pointer);
+
+        static SuperString::Result<int, SuperString::Error>
+        codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
+                          std::size_t endIndex);
+
+        static SuperString::Result<SuperString::Pair<std::size_t, std::size_t>, SuperString::Error>
+        rangeIndexes(const SuperString::Byte *bytes, std::size_t startIndex, std::size_t endIndex);
+
+        static SuperString::Pair<SuperString::Byte *, std::size_t> codeUnitToChar(int c);
+
+        /**
+         * Writes the encoding of [codeUnit] to [bytes] and returns the number of
+         * bytes written, or 0 if [codeUnit] is not a scalar value.
+         */
+        static std::size_t encode(int codeUnit, SuperString::Byte *bytes);
+
+        static SuperString::Result<std::size_t, SuperString::Error>
+        offset(const SuperString::Byte *bytes, std::size_t index);
+
+        static int decode(const SuperString::Byte *pointer);
+
+        static std::size_t width(const SuperString::Byte *pointer);
+
+        /**
+         * Returns the width of the well formed sequence at [pointer], which must have
+         * `width(pointer)` bytes readable, or 0 if it is ill-formed.
+         */
+        static std::size_t check(const SuperString::Byte *pointer);
+
+        // TODO: add customized trims methods
+
+    private:
+        // the kinds of error the block classifier flags, a bit each
+        static const SuperString::Byte TooShort = 1 << 0; // a lead byte or ASCII where a continuation is due
+        static const SuperString::Byte TooLong = 1 << 1; // a continuation byte after ASCII
+        static const SuperString::Byte Overlong3 = 1 << 2; // 11100000 100xxxxx
+        static const SuperString::Byte TooLarge = 1 << 3; // above U+10FFFF
+        static const SuperString::Byte Surrogate = 1 << 4; // 11101101 101xxxxx
+        static const SuperString::Byte Overlong2 = 1 << 5; // 1100000x 10xxxxxx
+        static const SuperString::Byte TooLarge1000 = 1 << 6; // 11110101 1000xxxx and above
+        static const SuperString::Byte Overlong4 = 1 << 6; // 11110000 1000xxxx
+        static const SuperString::Byte TwoContinuations = 1 << 7; // a continuation after a continuation
+        static const SuperString::Byte Carry = TooShort | TooLong | TwoContinuations;
+
+        /**
+         * The errors possible after a byte, by its high and its low nibble, and
+         * before a byte, by its high nibble. An error is one set in all three.
+         */
+        static const SuperString::Byte FirstHighErrors[16];
+
+        static const SuperString::Byte FirstLowErrors[16];
+
+        static const SuperString::Byte SecondHighErrors[16];
+
+        typedef const SuperString::Byte *(*SkipASCIIKernel)(const SuperString::Byte *pointer);
+
+        static SkipASCIIKernel selectSkipASCIIKernel();
+
+        static const SuperString::Byte *skipASCIIScalar(const SuperString::Byte *pointer);
+
+        static const SuperString::Byte *skipASCIISSE2(const SuperString::Byte *pointer);
+
+        static const SuperString::Byte *skipASCIIAVX2(const SuperString::Byte *pointer);
+
+        typedef const SuperString::Byte *(*SkipValidKernel)(const SuperString::Byte *pointer);
+
+        static SkipValidKernel selectSkipValidKernel();
+
+        static const SuperString::Byte *skipValidScalar(const SuperString::Byte *pointer);
+
+        static const SuperString::Byte *skipValidSSSE3(const SuperString::Byte *pointer);
+    };
+
+    class UTF16BE {
+    public:
+        static std::size_t length(const SuperString::Byte *bytes);
+
+        static SuperString::Pair<std::size_t, std::size_t>
+        lengthAndMemoryLength(const SuperString::Byte *bytes);
+
+        static SuperString::Result<int, SuperString::Error>
+        codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
+
+        static SuperString::Result<std::size_t, SuperString::Error>
+        offset(const SuperString::Byte *bytes, std::size_t index);
+
+        static int decode(const SuperString::Byte *pointer);
+
+        static std::size_t width(const SuperString::Byte *pointer);
+
+        /**
+         * Writes the encoding of [codeUnit] to [bytes] and returns the number of
+         * bytes written, or 0 if [codeUnit] is not a scalar value.
+         */
+        static std::size_t encode(int codeUnit, SuperString::Byte *bytes);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t length);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
+                          std::size_t endIndex);
+
+        // TODO: add customized trims methods
+    };
+
+    class UTF16LE {
+    public:
+        /**
+         * Returns a UTF-16BE copy of the NUL-terminated UTF-16LE [bytes], terminator
+         * included, to be deleted with `delete[]`.
+         */
+        static SuperString::Byte *toBigEndian(const SuperString::Byte *bytes);
+
+        /**
+         * Swaps the two bytes of every code unit of the [size] bytes at [bytes],
+         * which turns either byte order into the other.
+         */
+        static void swap(SuperString::Byte *bytes, std::size_t size);
+    };
+
+    class UTF32 {
+    public:
+        static std::size_t length(const SuperString::Byte *bytes);
+
+        static SuperString::Pair<std::size_t, std::size_t>
+        lengthAndMemoryLength(const SuperString::Byte *bytes);
+
+        static int codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
+
+        /**
+         * Writes [codeUnit] to [bytes] as a native `int` and returns 4, or 0 if
+         * [codeUnit] is not a scalar value.
+         */
+        static std::size_t encode(int codeUnit, SuperString::Byte *bytes);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes);
+
+        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
+                          std::size_t endIndex);
+
+        static SuperString::Pair<std::size_t, std::size_t>
+        trim(const SuperString::Byte *bytes, std::size_t length);
+
+        static std::size_t trimLeft(const SuperString::Byte *bytes);
+
+        static std::size_t trimRight(const SuperString::Byte *bytes, std::size_t length);
+    };
+
+    //
+    class Hash {
+    public:
+        /**
+         * Hashes are polynomials in `Base` of the code units, modulo the
+         * Mersenne prime 2^61 - 1.
+         */
+        static const std::uint64_t Modulus = 0x1fffffffffffffffULL;
+
+        static const std::uint64_t Base = 0x16a09e667f3bcc9ULL;
+
+        static std::uint64_t multiply(std::uint64_t a, std::uint64_t b);
+
+        static std::uint64_t add(std::uint64_t a, std::uint64_t b);
+
+        static std::uint64_t subtract(std::uint64_t a, std::uint64_t b);
+
+        /**
+         * Returns `Base` to the power of [exponent].
+         */
+        static std::uint64_t power(std::size_t exponent);
 
-    public:
-        //*- Constructors
+        /**
+         * Returns the hash of a string of hash [left] followed by one of hash
+         * [right] and [rightLength] code units.
+         */
+        static std::uint64_t combine(std::uint64_t left, std::uint64_t right, std::size_t rightLength);
 
-        ConcatenationSequence(const StringSequence *leftSequence, const StringSequence *rightSequence);
+        /**
+         * Returns the hash of [times] copies of a string of hash [hash] and
+         * [length] code units, in O(log [times]).
+         */
+        static std::uint64_t repeat(std::uint64_t hash, std::size_t length, std::size_t times);
 
-        //*- Destructor
+        /**
+         * Returns the hash of the code units of [sequence] from [startIndex],
+         * inclusive, to [endIndex], exclusive, by scanning them.
+         */
+        static std::uint64_t scan(const StringSequence *sequence, std::size_t startIndex, std::size_t endIndex);
 
-        ~ConcatenationSequence();
+        /**
+         * The state of a scan: the hash so far, the number of code units
+         * hashed, and where to sample the prefix hashes every
+         * `HashIndex::Stride` code units, if anywhere.
+         */
+        struct State {
+            std::uint64_t _hash;
+            std::size_t _index;
+            std::uint64_t *_samples;
+        };
 
-        //*- Getters
+        /**
+         * Hashes the code units of [chunk] into [context], a State.
+         */
+        static bool visit(const SuperString::Chunk &chunk, void *context);
+    };
 
-        SuperString::ConcatenationSequence::Kind kind() const;
+public:
+    //*-- Iterator
+    /**
+     * A bidirectional iterator over the code units of a string. It remembers
+     * the leaf storage it is walking, so stepping is amortized O(1) whatever
+     * the shape of the string; the tree is only descended again when it
+     * crosses into another leaf.
+     */
+    class Iterator {
+    private:
+        const StringSequence *_sequence;
+        // the storage of an inline string, walked instead of a sequence
+        const Byte *_bytes;
+        std::size_t _index;
+        std::size_t _length;
+        Cursor _cursor;
 
-        std::size_t length() const /*override*/;
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int *pointer;
+        typedef int reference;
 
-        //*- Methods
+        //*- Constructors
 
-        SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
+        Iterator();
 
-        SuperString::Result<SuperString, SuperString::Error>
-        substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
+        Iterator(const StringSequence *sequence, std::size_t index);
 
-        bool print(std::ostream &stream) const /*override*/;
+        //*- Getters
 
-        bool
-        print(std::ostream &stream, std::size_t startIndex, std::size_t endIndex) const /*override*/;
+        /**
+         * Returns the index of the code unit this iterator points to.
+         */
+        std::size_t index() const;
 
-        SuperString trim() const /*override*/;
+        //*- Operators
 
-        SuperString trimLeft() const /*override*/;
+        int operator*() const;
 
-        SuperString trimRight() const /*override*/;
+        SuperString::Iterator &operator++();
 
-        std::size_t keepingCost() const /*override*/;
+        SuperString::Iterator operator++(int);
 
-        // inherited: std::size_t freeingCost() const;
+        SuperString::Iterator &operator--();
 
-        std::size_t reconstructionCost(const StringSequence *sequence) const /*override*/;
+        SuperString::Iterator operator--(int);
 
-        void reconstruct(const StringSequence *sequence) const /*override*/;
+        bool operator==(const SuperString::Iterator &other) const;
 
-    protected:
-        void doDelete() const;
+        bool operator!=(const SuperString::Iterator &other) const;
 
-        bool isToBeDeleted() const;
+    private:
+        Iterator(const Byte *bytes, std::size_t length, std::size_t index);
+
+        /**
+         * Points the cursor at the code unit at the index, or at nothing.
+         */
+        void seek();
+
+        static std::size_t width(const SuperString::Cursor &cursor);
+
+        friend class SuperString;
     };
 
-    //*-- MultipleSequence (internal)
-    class MultipleSequence: public ReferenceStringSequence {
+    //*-- Builder
+    /**
+     * Accumulates UTF-8 input, such as the reads of a socket or a pipe, into
+     * fixed-capacity chunks that become the leaves of the built string, so that
+     * a string is built with one allocation per chunk rather than per fragment.
+     * A multi-byte sequence may be split across appends.
+     */
+    class Builder {
     private:
-        struct MultipleMetaInfo {
-            std::size_t _time;
-            const StringSequence *_sequence;
-        };
-        struct ReconstructedMetaInfo {
-            std::size_t _time;
-            int *_data;
-            std::size_t _dataLength;
-        };
-        enum class Kind {
-            MULTIPLE,
-            RECONSTRUCTED
-        };
-
-        Kind _kind;
-        union {
-            struct MultipleMetaInfo _multiple;
-            struct ReconstructedMetaInfo _reconstructed;
-        } _container;
+        std::vector<StringSequence *> _pieces;
+        Byte *_chunk;
+        std::size_t _chunkCapacity;
+        std::size_t _chunkByteLength;
+        std::size_t _chunkLength;
+        bool _isChunkASCII;
+        Byte _pending[4];
+        std::size_t _pendingLength;
+        std::size_t _length;
 
     public:
+        static const std::size_t DefaultChunkCapacity = 16384;
+
         //*- Constructors
 
-        MultipleSequence(const StringSequence *sequence, std::size_t time);
+        /**
+         * Constructs a builder filling chunks of [chunkCapacity] bytes.
+         */
+        Builder(std::size_t chunkCapacity = SuperString::Builder::DefaultChunkCapacity);
 
         //*- Destructor
 
-        ~MultipleSequence();
+        ~Builder();
 
         //*- Getters
 
-        SuperString::MultipleSequence::Kind kind() const;
-
-        std::size_t length() const /*override*/;
+        /**
+         * Returns the number of code units appended since the last build.
+         */
+        std::size_t length() const;
 
         //*- Methods
 
-        SuperString::Result<int, SuperString::Error> codeUnitAt(std::size_t index) const /*override*/;
-
-        SuperString::Result<SuperString, SuperString::Error>
-        substring(std::size_t startIndex, std::size_t endIndex) const /*override*/;
-
-        bool print(std::ostream &stream) const /*override*/;
-
-        bool
-        print(std::ostream &stream, std::size_t startIndex, std::size_t endIndex) const /*override*/;
+        /**
+         * Appends [byteLength] bytes of UTF-8 at [bytes]. A sequence cut at the end is
+         * completed by the next append. Returns SuperString::Error::InvalidByteSequence on
+         * an ill-formed sequence or a NUL byte, keeping what precedes it.
+         */
+        SuperString::Result<bool, SuperString::Error> append(const char *bytes, std::size_t byteLength);
 
-        SuperString trim() const /*override*/;
+        SuperString::Result<bool, SuperString::Error>
+        append(const SuperString::Byte *bytes, std::size_t byteLength);
 
-        SuperString trimLeft() const /*override*/;
+        /**
+         * Appends [string] as a whole, without copying it.
+         */
+        SuperString::Result<bool, SuperString::Error> append(const SuperString &string);
 
-        SuperString trimRight() const /*override*/;
+        /**
+         * Appends [codeUnit], or returns SuperString::Error::Unencodable if it is
+         * not a non-NUL scalar value.
+         */
+        SuperString::Result<bool, SuperString::Error> appendCodeUnit(int codeUnit);
 
-        std::size_t keepingCost() const /*override*/;
+        /**
+         * Returns the string appended so far as a balanced tree of its chunks, and
+         * empties this builder. Returns SuperString::Error::InvalidByteSequence if the
+         * input ends in the middle of a sequence.
+         */
+        SuperString::Result<SuperString, SuperString::Error> build();
 
-        // inherited: std::size_t freeingCost() const;
+    private:
+        // not copyable
+        Builder(const SuperString::Builder &other);
 
-        std::size_t reconstructionCost(const StringSequence *sequence) const /*override*/;
+        SuperString::Builder &operator=(const SuperString::Builder &other);
 
-        void reconstruct(const StringSequence *sequence) const /*override*/;
+        /**
+         * Returns where to write [byteLength] more bytes, sealing the current
+         * chunk first if they do not fit in it.
+         */
+        SuperString::Byte *reserve(std::size_t byteLength);
 
-    protected:
-        void doDelete() const;
+        /**
+         * Turns the current chunk into a leaf appended to the pieces.
+         */
+        void seal();
 
-        bool isToBeDeleted() const;
+        /**
+         * Returns a balanced tree of concatenations of the [count] [pieces].
+         */
+        static const StringSequence *join(StringSequence *const *pieces, std::size_t count);
     };
 
-    inline static bool isWhiteSpace(int codeUnit);
-
-    //
-    class ASCII {
+    //*-- InternPool
+    /**
+     * Maps contents to canonical strings, so that a content seen many times,
+     * such as a field name, is stored once and interned strings compare equal
+     * by pointer. Entries are found by hash and confirmed by comparing the
+     * contents. A weak pool does not keep its strings alive: an entry leaves
+     * the pool with the last string holding it. The entries are spread over
+     * shards, each behind its own lock when thread safe; a weak pool shared by
+     * threads has to outlive the strings it interns. Strings short enough to be
+     * stored inline are returned inline and never enter the pool.
+     */
+    class InternPool {
     public:
-        static std::size_t length(const SuperString::Byte *bytes);
+        static const std::size_t ShardCount = 16;
 
-        static int codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
-
-        static void print(std::ostream &stream, const SuperString::Byte *bytes);
+    private:
+        // the spins on a held shard before yielding to the thread holding it
+        static const std::size_t SpinCount = 64;
+
+        struct Shard {
+            std::unordered_multimap<std::uint64_t, StringSequence *> _entries;
+#ifdef SUPERSTRING_THREAD_SAFE
+            mutable std::atomic_flag _lock;
+#endif
+        };
 
-        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
-                          std::size_t endIndex);
+        Shard _shards[ShardCount];
+        bool _isWeak;
 
-        static SuperString::Pair<std::size_t, std::size_t>
-        trim(const SuperString::Byte *bytes, std::size_t length);
+    public:
+        //*- Constructors
 
-        static std::size_t trimLeft(const SuperString::Byte *bytes);
+        /**
+         * Constructs a pool, holding its strings unless [isWeak].
+         */
+        InternPool(bool isWeak = false);
 
-        static std::size_t trimRight(const SuperString::Byte *bytes, std::size_t length);
-    };
+        //*- Destructor
 
-    class UTF8 {
-    public:
-        static std::size_t length(const SuperString::Byte *bytes);
+        ~InternPool();
 
-        static SuperString::Pair<std::size_t, std::size_t>
-        lengthAndMemoryLength(const SuperString::Byte *bytes);
+        //*- Getters
 
-        static SuperString::Result<int, SuperString::Error>
-        codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
+        /**
+         * Returns true if this pool does not keep its strings alive.
+         */
+        bool isWeak() const;
 
-        static void print(std::ostream &stream, const SuperString::Byte *bytes);
+        /**
+         * Returns the number of distinct contents interned.
+         */
+        std::size_t size() const;
 
-        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
-                          std::size_t endIndex);
+        /**
+         * Returns the keeping costs of the interned strings.
+         */
+        std::size_t memoryLength() const;
 
-        static SuperString::Result<SuperString::Pair<std::size_t, std::size_t>, SuperString::Error>
-        rangeIndexes(const SuperString::Byte *bytes, std::size_t startIndex, std::size_t endIndex);
+        //*- Methods
 
-        static SuperString::Pair<SuperString::Byte *, std::size_t> codeUnitToChar(int c);
+        /**
+         * Returns the canonical string equal to [string], making a flat copy of
+         * [string] canonical if none is interned yet. A flat [string] becomes
+         * canonical as it is.
+         */
+        SuperString intern(const SuperString &string);
 
-        // TODO: add customized trims methods
-    };
+        /**
+         * Removes every entry, releasing the strings held by a strong pool.
+         */
+        void clear();
 
-    class UTF16BE {
-    public:
-        static std::size_t length(const SuperString::Byte *bytes);
+    private:
+        // not copyable
+        InternPool(const SuperString::InternPool &other);
 
-        static SuperString::Pair<std::size_t, std::size_t>
-        lengthAndMemoryLength(const SuperString::Byte *bytes);
+        SuperString::InternPool &operator=(const SuperString::InternPool &other);
 
-        static SuperString::Result<int, SuperString::Error>
-        codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
+        Shard &shardOf(std::uint64_t hash);
 
-        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t length);
+        /**
+         * Returns the sequence of [shard] equal to [sequence] of [hash] with a
+         * reference added to it, NULL if none is held.
+         */
+        static StringSequence *find(const Shard &shard, std::uint64_t hash, const StringSequence *sequence);
 
-        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
-                          std::size_t endIndex);
+        /**
+         * Removes the entry of [sequence], which is being deleted; its shard is locked.
+         */
+        void remove(const StringSequence *sequence);
 
-        // TODO: add customized trims methods
-    };
+        static void lock(const Shard &shard);
 
-    class UTF32 {
-    public:
-        static std::size_t length(const SuperString::Byte *bytes);
+        static void unlock(const Shard &shard);
 
-        static SuperString::Pair<std::size_t, std::size_t>
-        lengthAndMemoryLength(const SuperString::Byte *bytes);
+        friend class StringSequence;
+    };
 
-        static int codeUnitAt(const SuperString::Byte *bytes, std::size_t index);
+private:
+    //*-- NodeAllocator (internal)
+    /**
+     * Allocates sequences from free lists kept per thread for blocks of up to
+     * 256 bytes in steps of 16, and from the heap. The word in front of every
+     * block holds its size class, 0 for blocks never cached. Built with
+     * SUPERSTRING_NO_NODE_CACHE, or under AddressSanitizer, every block comes
+     * from and goes back to the heap, where use after free is caught.
+     */
+    class NodeAllocator {
+    private:
+        static const std::size_t Granularity = 16;
+        static const std::size_t ClassCount = 17;
+        static const std::size_t CachedBlockCount = 1024;
 
-        static void print(std::ostream &stream, const SuperString::Byte *bytes);
+        struct FreeLists {
+            void *_heads[ClassCount];
+            std::size_t _lengths[ClassCount];
+            bool _isReleased;
 
-        static void print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
-                          std::size_t endIndex);
+            ~FreeLists();
+        };
 
-        static SuperString::Pair<std::size_t, std::size_t>
-        trim(const SuperString::Byte *bytes, std::size_t length);
+        static thread_local FreeLists _freeLists;
 
-        static std::size_t trimLeft(const SuperString::Byte *bytes);
+    public:
+        static void *allocate(std::size_t size);
 
-        static std::size_t trimRight(const SuperString::Byte *bytes, std::size_t length);
+        static void release(void *pointer);
     };
 };
 
@@ -1301,174 +3146,134 @@ std::ostream &operator<<(std::ostream &stream, const SuperString &string);
 //*-- SuperString::Result<T, E>
 template<class T, class E>
 SuperString::Result<T, E>::Result()
-        : _ok(NULL),
-          _err(NULL) {
+        : _state(State::None) {
     // nothing go here
 }
 
 template<class T, class E>
 SuperString::Result<T, E>::Result(T ok)
-        : _ok(NULL),
-          _err(NULL) {
-    this->_ok = new char[sizeof(T)];
-    new(this->_ok) T(ok);
+        : _state(State::Ok) {
+    new(&this->_storage) T(std::move(ok));
 }
 
 template<class T, class E>
 SuperString::Result<T, E>::Result(E err)
-        : _ok(NULL),
-          _err(NULL) {
-    this->_err = new char[sizeof(E)];
-    new(this->_err) E(err);
+        : _state(State::Err) {
+    new(&this->_storage) E(std::move(err));
 }
 
 template<class T, class E>
 SuperString::Result<T, E>::Result(const SuperString::Result<T, E> &other)
-        : _ok(NULL),
-          _err(NULL) /*copy*/ {
-    if(other._ok != NULL) {
-        this->_ok = new char[sizeof(T)];
-        new(this->_ok) T(*((T *) other._ok));
-    } else {
-        this->_err = new char[sizeof(E)];
-        new(this->_err) E(*((E *) other._err));
+        : _state(other._state) /*copy*/ {
+    if(isTrivial()) {
+        this->_storage = other._storage;
+    } else if(other._state == State::Ok) {
+        new(&this->_storage) T(*((const T *) &other._storage));
+    } else if(other._state == State::Err) {
+        new(&this->_storage) E(*((const E *) &other._storage));
     }
 }
 
 template<class T, class E>
-SuperString::Result<T, E>::~Result() {
-    if(this->_ok != NULL) {
-        ((T *) (this->_ok))->~T();
-        delete this->_ok;
-        this->_ok = NULL;
-    }
-    if(this->_err != NULL) {
-        ((E *) (this->_err))->~E();
-        delete this->_err;
-        this->_err = NULL;
+SuperString::Result<T, E>::Result(SuperString::Result<T, E> &&other)
+        : _state(other._state) /*move*/ {
+    if(isTrivial()) {
+        this->_storage = other._storage;
+    } else if(other._state == State::Ok) {
+        new(&this->_storage) T(std::move(*((T *) &other._storage)));
+    } else if(other._state == State::Err) {
+        new(&this->_storage) E(std::move(*((E *) &other._storage)));
     }
 }
 
+template<class T, class E>
+SuperString::Result<T, E>::~Result() {
+    this->_clear();
+}
+
 template<class T, class E>
 E SuperString::Result<T, E>::err() const {
-    return *((E *) this->_err);
+    return *((const E *) &this->_storage);
 }
 
 template<class T, class E>
 bool SuperString::Result<T, E>::isErr() const {
-    return this->_err != NULL;
+    return this->_state == State::Err;
 }
 
 template<class T, class E>
 bool SuperString::Result<T, E>::isOk() const {
-    return this->_ok != NULL;
+    return this->_state == State::Ok;
 }
 
 template<class T, class E>
 T SuperString::Result<T, E>::ok() const {
-    return *((T *) this->_ok);
+    return *((const T *) &this->_storage);
 }
 
 template<class T, class E>
 void SuperString::Result<T, E>::err(E err) {
-    this->~Result();
-    this->_err = new char[sizeof(E)];
-    new(this->_err) E(err);
+    this->_clear();
+    new(&this->_storage) E(std::move(err));
+    this->_state = State::Err;
 }
 
 template<class T, class E>
 void SuperString::Result<T, E>::ok(T ok) {
-    this->~Result();
-    this->_ok = new char[sizeof(T)];
-    new(this->_ok) T(ok);
+    this->_clear();
+    new(&this->_storage) T(std::move(ok));
+    this->_state = State::Ok;
 }
 
 template<class T, class E>
 SuperString::Result<T, E> &SuperString::Result<T, E>::operator=(const SuperString::Result<T, E> &other) {
     if(this != &other) {
-        if(other.isOk()) {
-            this->ok(other.ok());
+        if(isTrivial()) {
+            this->_storage = other._storage;
+            this->_state = other._state;
+        } else if(other.isOk()) {
+            this->ok(*((const T *) &other._storage));
+        } else if(other.isErr()) {
+            this->err(*((const E *) &other._storage));
         } else {
-            this->err(other.err());
+            this->_clear();
         }
     }
     return *this;
 }
 
-//*-- SuperString::SingleLinkedList<E> (internal)
-template<class E>
-SuperString::SingleLinkedList<E>::SingleLinkedList()
-        : _head(NULL),
-          _tail(NULL) {
-    // nothing go here
-}
-
-template<class E>
-SuperString::SingleLinkedList<E>::~SingleLinkedList() {
-    Node<E> *node = this->_head;
-    while(node != NULL) {
-        Node<E> *tmp = node;
-        node = node->_next;
-        delete tmp;
-    }
-    this->_head = NULL;
-    this->_tail = NULL;
-}
-
-template<class E>
-std::size_t SuperString::SingleLinkedList<E>::length() const {
-    std::size_t length = 0;
-    Node<E> *node = this->_head;
-    while(node != NULL) {
-        length++;
-        node = node->_next;
+template<class T, class E>
+SuperString::Result<T, E> &SuperString::Result<T, E>::operator=(SuperString::Result<T, E> &&other) {
+    if(this != &other) {
+        if(isTrivial()) {
+            this->_storage = other._storage;
+            this->_state = other._state;
+        } else if(other.isOk()) {
+            this->ok(std::move(*((T *) &other._storage)));
+        } else if(other.isErr()) {
+            this->err(std::move(*((E *) &other._storage)));
+        } else {
+            this->_clear();
+        }
     }
-    return length;
+    return *this;
 }
 
-template<class E>
-void SuperString::SingleLinkedList<E>::push(E value) {
-    Node<E> *node = new Node<E>(value);
-    if(this->_tail == NULL) {
-        this->_head = node;
-        this->_tail = node;
-    } else {
-        this->_tail->_next = node;
-        this->_tail = node;
-    }
+template<class T, class E>
+constexpr bool SuperString::Result<T, E>::isTrivial() {
+    return std::is_trivially_copyable<T>::value && std::is_trivially_copyable<E>::value;
 }
 
-template<class E>
-void SuperString::SingleLinkedList<E>::remove(E value) {
-    Node<E> *prev = NULL;
-    Node<E> *node = this->_head;
-    while(node != NULL) {
-        if(node->_data == value) {
-            break;
-        }
-        prev = node;
-        node = node->_next;
-    }
-    if(node != NULL) {
-        if(prev == NULL) {
-            this->_head = node->_next;
-        } else {
-            prev->_next = node->_next;
-        }
-        if(node->_next == NULL) {
-            this->_tail = prev;
+template<class T, class E>
+void SuperString::Result<T, E>::_clear() {
+    if(!isTrivial()) {
+        if(this->_state == State::Ok) {
+            ((T *) &this->_storage)->~T();
+        } else if(this->_state == State::Err) {
+            ((E *) &this->_storage)->~E();
         }
-        delete node;
     }
-}
-
-//*-- SuperString::SingleLinkedList<E>::Node<Ei> (internal)
-template<class E>
-template<class Ei>
-SuperString::SingleLinkedList<E>::Node<Ei>::Node(E data)
-        : _data(data),
-          _next(NULL) {
-    // nothing go here
+    this->_state = State::None;
 }
 
 //*-- SuperString::Pair<T, U>
@@ -1515,5 +3320,23 @@ bool SuperString::isWhiteSpace(int codeUnit) {
     return (codeUnit == 0x85) || (codeUnit == 0xA0); // NEL, NBSP.
 }
 
+//*-- SuperString (inline storage)
+bool SuperString::isInline() const {
+    return this->_inline[InlineCapacity] != 0;
+}
+
+std::size_t SuperString::inlineByteLength() const {
+    return (this->_inline[InlineCapacity] & ~InlineASCII) - 1;
+}
+
+//*-- std::hash<SuperString>
+namespace std {
+    template<>
+    struct hash<SuperString> {
+        std::size_t operator()(const SuperString &string) const {
+            return string.hash();
+        }
+    };
+}
 
 #endif // BOUTGLAY_SUPERSTRING_HEADER
@@ -4,30 +4,80 @@
 // std
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
+
+#ifdef SUPERSTRING_THREAD_SAFE
+#include <thread>
+#endif
+
+// freed sequences go back to the heap at once, where AddressSanitizer sees them used after free
+#if defined(__SANITIZE_ADDRESS__) && !defined(SUPERSTRING_NO_NODE_CACHE)
+#define SUPERSTRING_NO_NODE_CACHE
+#endif
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) && !defined(SUPERSTRING_NO_NODE_CACHE)
+#define SUPERSTRING_NO_NODE_CACHE
+#endif
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SUPERSTRING_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SUPERSTRING_MAPPED_FILES
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /*-- definitions --*/
 
 //*-- SuperString
+std::size_t SuperString::_offsetIndexStride = 128;
+
+SuperString::Counters SuperString::_counters;
+
+SuperString::RetentionPolicy::CostBased SuperString::_costBasedPolicy;
+
+SuperString::RetentionPolicy *SuperString::_retentionPolicy = &SuperString::_costBasedPolicy;
+
+bool SuperString::_isReconstructionDeferred = false;
+
+std::vector<SuperString::StringSequence *> SuperString::_deferred;
+
 SuperString::SuperString()
         : _sequence(NULL) {
-    // nothing go here
+    this->_inline[InlineCapacity] = 0;
 }
 
 SuperString::SuperString(const SuperString &other) /*copy*/ {
-    this->_sequence = other._sequence;
-    this->_sequence->refAdd();
+    std::memcpy(this->_inline, other._inline, sizeof(this->_inline));
+    if(!this->isInline() && this->_sequence != NULL) {
+        this->_sequence->refAdd();
+    }
+}
+
+SuperString::SuperString(SuperString &&other) /*move*/ {
+    std::memcpy(this->_inline, other._inline, sizeof(this->_inline));
+    other._sequence = NULL;
+    other._inline[InlineCapacity] = 0;
 }
 
 SuperString::SuperString(SuperString::StringSequence *sequence)
         : _sequence(sequence) {
+    this->_inline[InlineCapacity] = 0;
     this->_sequence->refAdd();
 }
 
 SuperString::~SuperString() {
-    if(this->_sequence != NULL && this->_sequence->refRelease() == 0 && this->freeingCost() < this->keepingCost()) {
-        this->_sequence->doDelete();
+    if(!this->isInline() && this->_sequence != NULL) {
+        this->_sequence->release();
     }
 }
 
@@ -40,24 +90,54 @@ bool SuperString::isNotEmpty() const {
 }
 
 std::size_t SuperString::length() const {
+    if(this->isInline()) {
+        return this->inlineLength();
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->length();
     }
     return 0;
 }
 
+SuperString::Iterator SuperString::begin() const {
+    if(this->isInline()) {
+        return Iterator(this->_inline, this->inlineLength(), 0);
+    }
+    return Iterator(this->_sequence, 0);
+}
+
+SuperString::Iterator SuperString::end() const {
+    if(this->isInline()) {
+        std::size_t length = this->inlineLength();
+        return Iterator(this->_inline, length, length);
+    }
+    return Iterator(this->_sequence, this->length());
+}
+
 int SuperString::compareTo(const SuperString &other) const {
+    bool isInline = this->isInline();
+    bool isOtherInline = other.isInline();
+    if(isInline && isOtherInline) {
+        // the byte order of UTF-8 is the order of its code units
+        std::size_t byteLength = this->inlineByteLength();
+        std::size_t otherByteLength = other.inlineByteLength();
+        int comparison = std::memcmp(this->_inline, other._inline, std::min(byteLength, otherByteLength));
+        if(comparison != 0) {
+            return comparison < 0 ? -1 : 1;
+        }
+        return byteLength < otherByteLength ? -1 : (byteLength > otherByteLength ? 1 : 0);
+    }
+    if(!isInline && !isOtherInline && this->_sequence == other._sequence) {
+        return 0;
+    }
     std::size_t thisLength = this->length();
     std::size_t otherLength = other.length();
     std::size_t len = (thisLength < otherLength) ? thisLength : otherLength;
-    for(int i = 0; i < len; i++) {
-        int thisCodeUnit = this->codeUnitAt(i).ok();
-        int otherCodeUnit = other.codeUnitAt(i).ok();
-        if(thisCodeUnit < otherCodeUnit) {
-            return -1;
-        }
-        if(thisCodeUnit > otherCodeUnit) {
-            return 1;
+    if(len != 0) {
+        int comparison = SuperString::compareSequences(isInline ? NULL : this->_sequence, this->_inline,
+                                                       isOtherInline ? NULL : other._sequence, other._inline, len);
+        if(comparison != 0) {
+            return comparison;
         }
     }
     if(thisLength < otherLength) return -1;
@@ -65,21 +145,175 @@ int SuperString::compareTo(const SuperString &other) const {
     return 0;
 }
 
+int SuperString::compareSequences(const StringSequence *sequence, const Byte *bytes, const StringSequence *other,
+                                  const Byte *otherBytes, std::size_t length) {
+    Cursor cursor, otherCursor;
+    std::size_t index = 0;
+    while(index < length) {
+        bool isRun = SuperString::cursorAt(sequence, bytes, index, length, cursor);
+        bool isOtherRun = SuperString::cursorAt(other, otherBytes, index, length, otherCursor);
+        if(!isRun || !isOtherRun) {
+            // no storage to point at, a code unit at a time
+            const Byte *pointer = cursor._bytes;
+            const Byte *otherPointer = otherCursor._bytes;
+            int codeUnit = isRun ? SuperString::nextCodeUnit(pointer, cursor._encoding)
+                                 : sequence->codeUnitAt(index).ok();
+            int otherCodeUnit = isOtherRun ? SuperString::nextCodeUnit(otherPointer, otherCursor._encoding)
+                                           : other->codeUnitAt(index).ok();
+            if(codeUnit != otherCodeUnit) {
+                return codeUnit < otherCodeUnit ? -1 : 1;
+            }
+            index++;
+            continue;
+        }
+        std::size_t end = std::min(std::min(cursor._endIndex, otherCursor._endIndex), length);
+        int comparison = SuperString::compareUnits(cursor._bytes, cursor._encoding, otherCursor._bytes,
+                                                   otherCursor._encoding, end - index);
+        if(comparison != 0) {
+            return comparison;
+        }
+        index = end;
+    }
+    return 0;
+}
+
+bool SuperString::cursorAt(const StringSequence *sequence, const Byte *bytes, std::size_t index, std::size_t length,
+                           Cursor &cursor) {
+    if(sequence != NULL) {
+        return sequence->cursorAt(index, cursor);
+    }
+    cursor._bytes = bytes + SuperString::UTF8::offset(bytes, index).ok();
+    cursor._encoding = Encoding::UTF8;
+    cursor._startIndex = 0;
+    cursor._endIndex = length;
+    return true;
+}
+
+int SuperString::compareUnits(const Byte *bytes, Encoding encoding, const Byte *otherBytes, Encoding otherEncoding,
+                              std::size_t length) {
+    if(encoding == otherEncoding) {
+        std::size_t byteLength = length;
+        std::size_t otherByteLength = length;
+        switch(encoding) {
+            case Encoding::ASCII:
+            case Encoding::Latin1:
+                break;
+            case Encoding::UTF8:
+                byteLength = SuperString::UTF8::offset(bytes, length).ok();
+                otherByteLength = SuperString::UTF8::offset(otherBytes, length).ok();
+                break;
+            case Encoding::UTF16BE:
+                byteLength = SuperString::UTF16BE::offset(bytes, length).ok();
+                otherByteLength = SuperString::UTF16BE::offset(otherBytes, length).ok();
+                break;
+            case Encoding::UTF32:
+                byteLength = otherByteLength = length * sizeof(int);
+                break;
+            case Encoding::UTF16LE:
+                break; // never stored, swapped into UTF16BE
+        }
+        int comparison = std::memcmp(bytes, otherBytes, std::min(byteLength, otherByteLength));
+        if(comparison == 0 && byteLength == otherByteLength) {
+            return 0;
+        }
+        if(comparison != 0 && (encoding == Encoding::ASCII || encoding == Encoding::UTF8)) {
+            // the byte order of these encodings is the order of their code units
+            return comparison < 0 ? -1 : 1;
+        }
+    } else if((encoding == Encoding::ASCII && otherEncoding == Encoding::UTF32) ||
+              (encoding == Encoding::UTF32 && otherEncoding == Encoding::ASCII)) {
+        const Byte *narrow = (encoding == Encoding::ASCII) ? bytes : otherBytes;
+        const int *wide = (const int *) ((encoding == Encoding::ASCII) ? otherBytes : bytes);
+        // a plain widening loop over blocks, simple enough for the compiler to
+        // vectorize; only the block with a difference is decoded below
+        std::size_t skipped = 0;
+        while(skipped < length) {
+            std::size_t end = std::min(skipped + 64, length);
+            int difference = 0;
+            for(std::size_t i = skipped; i < end; i++) {
+                difference |= narrow[i] ^ wide[i];
+            }
+            if(difference != 0) {
+                break;
+            }
+            skipped = end;
+        }
+        if(skipped == length) {
+            return 0;
+        }
+        bytes += (encoding == Encoding::ASCII) ? skipped : skipped * sizeof(int);
+        otherBytes += (otherEncoding == Encoding::ASCII) ? skipped : skipped * sizeof(int);
+        length -= skipped;
+    }
+    for(std::size_t i = 0; i < length; i++) {
+        int codeUnit = SuperString::nextCodeUnit(bytes, encoding);
+        int otherCodeUnit = SuperString::nextCodeUnit(otherBytes, otherEncoding);
+        if(codeUnit != otherCodeUnit) {
+            return codeUnit < otherCodeUnit ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+int SuperString::nextCodeUnit(const Byte *&pointer, Encoding encoding) {
+    int codeUnit = 0;
+    switch(encoding) {
+        case Encoding::ASCII:
+        case Encoding::Latin1:
+            codeUnit = *pointer;
+            pointer += 1;
+            break;
+        case Encoding::UTF8:
+            codeUnit = SuperString::UTF8::decode(pointer);
+            pointer += SuperString::UTF8::width(pointer);
+            break;
+        case Encoding::UTF16BE:
+            codeUnit = SuperString::UTF16BE::decode(pointer);
+            pointer += SuperString::UTF16BE::width(pointer);
+            break;
+        case Encoding::UTF32:
+            codeUnit = *((const int *) pointer);
+            pointer += sizeof(int);
+            break;
+        case Encoding::UTF16LE:
+            break; // never stored, swapped into UTF16BE
+    }
+    return codeUnit;
+}
+
 SuperString::Result<std::size_t, SuperString::Error> SuperString::indexOf(SuperString other) const {
+    if(this->isInline()) {
+        return this->searchInline(other, false);
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->indexOf(other);
     }
+    if(other.isEmpty()) {
+        return Result<std::size_t, Error>(0);
+    }
     return Result<std::size_t, Error>(Error::NotFound);
 }
 
 SuperString::Result<std::size_t, SuperString::Error> SuperString::lastIndexOf(SuperString other) const {
+    if(this->isInline()) {
+        return this->searchInline(other, true);
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->lastIndexOf(other);
     }
+    if(other.isEmpty()) {
+        return Result<std::size_t, Error>(0);
+    }
     return Result<std::size_t, Error>(Error::NotFound);
 }
 
 SuperString::Result<int, SuperString::Error> SuperString::codeUnitAt(std::size_t index) const {
+    if(this->isInline()) {
+        if(index < this->inlineLength()) {
+            return Result<int, Error>(SuperString::UTF8::decode(this->_inline + this->inlineOffset(index)));
+        }
+        return Result<int, Error>(Error::RangeError);
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->codeUnitAt(index);
     }
@@ -88,7 +322,23 @@ SuperString::Result<int, SuperString::Error> SuperString::codeUnitAt(std::size_t
 
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::substring(std::size_t startIndex, std::size_t endIndex) const {
+    if(this->isInline()) {
+        if(endIndex < startIndex || this->inlineLength() < endIndex) {
+            return Result<SuperString, Error>(Error::RangeError);
+        }
+        SuperString string;
+        std::size_t startOffset = this->inlineOffset(startIndex);
+        string.storeInline(this->_inline + startOffset, this->inlineOffset(endIndex) - startOffset);
+        return Result<SuperString, Error>(string);
+    }
     if(this->_sequence != NULL) {
+        // short ranges are copied out rather than referenced
+        SuperString string;
+        if(startIndex <= endIndex && endIndex - startIndex <= InlineCapacity &&
+           endIndex <= this->_sequence->length() && this->_sequence->isValid() &&
+           SuperString::Inline(this->_sequence, startIndex, endIndex, string)) {
+            return Result<SuperString, Error>(string);
+        }
         return this->_sequence->substring(startIndex, endIndex);
     }
     return Result<SuperString, Error>(Error::RangeError);
@@ -111,6 +361,10 @@ SuperString SuperString::substr(std::size_t pos) const {
 }
 
 bool SuperString::print(std::ostream &stream) const {
+    if(this->isInline()) {
+        stream.write((const char *) this->_inline, (std::streamsize) this->inlineByteLength());
+        return true;
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->print(stream);
     }
@@ -118,13 +372,251 @@ bool SuperString::print(std::ostream &stream) const {
 }
 
 bool SuperString::print(std::ostream &stream, std::size_t startIndex, std::size_t endIndex) const {
+    if(this->isInline()) {
+        if(endIndex < startIndex || this->inlineLength() < endIndex) {
+            return false;
+        }
+        std::size_t startOffset = this->inlineOffset(startIndex);
+        stream.write((const char *) this->_inline + startOffset,
+                     (std::streamsize) (this->inlineOffset(endIndex) - startOffset));
+        return true;
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->print(stream, startIndex, endIndex);
     }
     return true;
 }
 
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::copyTo(Byte *buffer, std::size_t startIndex, std::size_t endIndex, Encoding encoding) const {
+    if(endIndex < startIndex || this->length() < endIndex) {
+        return Result<std::size_t, Error>(Error::RangeError);
+    }
+    if(!this->isInline() && this->_sequence != NULL && !this->_sequence->isValid()) {
+        return Result<std::size_t, Error>(Error::InvalidByteSequence);
+    }
+    if(startIndex == endIndex) {
+        return Result<std::size_t, Error>(0);
+    }
+    if(encoding == Encoding::Latin1) {
+        encoding = Encoding::ASCII;
+    }
+    CopyContext context = {buffer, 0, encoding, Error::Unexpected};
+    if(!this->visitChunks(startIndex, endIndex, SuperString::copyVisitor, &context)) {
+        return Result<std::size_t, Error>(context._error);
+    }
+    return Result<std::size_t, Error>(context._size);
+}
+
+bool SuperString::copyVisitor(const Chunk &chunk, void *context) {
+    CopyContext *copy = (CopyContext *) context;
+    Result<std::size_t, Error> written = SuperString::copyChunk(chunk, copy->_buffer != NULL ? copy->_buffer + copy->_size
+                                                                                            : NULL, copy->_encoding);
+    if(written.isErr()) {
+        copy->_error = written.err();
+        return false;
+    }
+    copy->_size += written.ok();
+    return true;
+}
+
+SuperString::Result<SuperString, SuperString::Error> SuperString::flatten(Encoding encoding) const {
+    if(!this->isInline() && this->_sequence == NULL) {
+        return Result<SuperString, Error>(SuperString());
+    }
+    if(!this->isInline() && !this->_sequence->isValid()) {
+        return Result<SuperString, Error>(Error::InvalidByteSequence);
+    }
+    if(encoding == Encoding::UTF16LE) {
+        return Result<SuperString, Error>(Error::Unimplemented);
+    }
+    if(encoding == Encoding::Latin1) {
+        encoding = Encoding::ASCII;
+    }
+    std::size_t length = this->length();
+    std::size_t size;
+    // fixed widths are known without measuring
+    if(encoding == Encoding::ASCII) {
+        size = length;
+    } else if(encoding == Encoding::UTF32) {
+        size = length * sizeof(int);
+    } else {
+        Result<std::size_t, Error> measured = this->copyTo(NULL, 0, length, encoding);
+        if(measured.isErr()) {
+            return Result<SuperString, Error>(measured.err());
+        }
+        size = measured.ok();
+    }
+    StringSequence *sequence;
+    if(encoding == Encoding::UTF32) {
+        int *data = new int[length + 1];
+        this->copyTo((Byte *) data, 0, length, encoding);
+        data[length] = 0;
+        sequence = new CopyUTF32Sequence(data, length);
+    } else {
+        std::size_t terminator = encoding == Encoding::UTF16BE ? 2 : 1;
+        Byte *data = new Byte[size + terminator];
+        Result<std::size_t, Error> written = this->copyTo(data, 0, length, encoding);
+        if(written.isErr()) {
+            delete[] data;
+            return Result<SuperString, Error>(written.err());
+        }
+        std::fill_n(data + size, terminator, 0x00);
+        switch(encoding) {
+            case Encoding::ASCII:
+                sequence = new CopyASCIISequence(data, length, size + terminator);
+                break;
+            case Encoding::UTF8:
+                sequence = new CopyUTF8Sequence(data, length, size + terminator, size + terminator);
+                break;
+            default:
+                sequence = new CopyUTF16BESequence(data, length, size + terminator);
+                break;
+        }
+    }
+    return Result<SuperString, Error>(SuperString(sequence));
+}
+
+SuperString SuperString::compact(std::size_t threshold) const {
+    if(this->isInline()) {
+        return *this;
+    }
+    if(this->_sequence == NULL) {
+        return SuperString();
+    }
+    return this->_sequence->compact(threshold);
+}
+
+std::string SuperString::toStdString() const {
+    std::size_t length = this->length();
+    Result<std::size_t, Error> size = this->copyTo(NULL, 0, length, Encoding::UTF8);
+    if(size.isErr() || size.ok() == 0) {
+        return std::string();
+    }
+    std::string string(size.ok(), '\0');
+    this->copyTo((Byte *) &string[0], 0, length, Encoding::UTF8);
+    return string;
+}
+
+SuperString::Result<bool, SuperString::Error>
+SuperString::forEachChunk(std::size_t startIndex, std::size_t endIndex,
+                          const std::function<bool(const SuperString::Chunk &chunk)> &callback) const {
+    if(endIndex < startIndex || this->length() < endIndex) {
+        return Result<bool, Error>(Error::RangeError);
+    }
+    if(startIndex == endIndex) {
+        return Result<bool, Error>(true);
+    }
+    return Result<bool, Error>(this->visitChunks(startIndex, endIndex, SuperString::forEachVisitor,
+                                                 (void *) &callback));
+}
+
+bool SuperString::forEachVisitor(const Chunk &chunk, void *context) {
+    return (*((const std::function<bool(const Chunk &chunk)> *) context))(chunk);
+}
+
+bool SuperString::visitChunks(std::size_t startIndex, std::size_t endIndex, ChunkVisitor visitor,
+                              void *context) const {
+    if(this->isInline()) {
+        std::size_t startOffset = this->inlineOffset(startIndex);
+        std::size_t endOffset = this->inlineOffset(endIndex);
+        Encoding encoding = (this->_inline[InlineCapacity] & InlineASCII) != 0 ? Encoding::ASCII : Encoding::UTF8;
+        return visitor(Chunk(this->_inline + startOffset, endOffset - startOffset, endIndex - startIndex, encoding),
+                       context);
+    }
+    return this->_sequence->visitChunks(startIndex, endIndex, visitor, context);
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::copyChunk(const Chunk &chunk, Byte *buffer, Encoding encoding) {
+    // Latin-1 bytes above 0x7f take two bytes in UTF-8, and are transcoded below
+    if(chunk.encoding() == encoding ||
+       (chunk.encoding() == Encoding::ASCII && encoding == Encoding::UTF8 &&
+        SuperString::ASCII::isSevenBit(chunk.bytes(), chunk.byteLength())) ||
+       (chunk.encoding() == Encoding::UTF8 && encoding == Encoding::ASCII && chunk.byteLength() == chunk.length())) {
+        if(buffer != NULL) {
+            std::memcpy(buffer, chunk.bytes(), chunk.byteLength());
+        }
+        return Result<std::size_t, Error>(chunk.byteLength());
+    }
+    if(chunk.encoding() == Encoding::ASCII && encoding == Encoding::UTF32) {
+        // a plain widening loop, simple enough for the compiler to vectorize
+        if(buffer != NULL) {
+            int *codeUnits = (int *) buffer;
+            for(std::size_t i = 0; i < chunk.length(); i++) {
+                codeUnits[i] = chunk.bytes()[i];
+            }
+        }
+        return Result<std::size_t, Error>(chunk.length() * sizeof(int));
+    }
+    if(chunk.encoding() == Encoding::UTF16BE && encoding == Encoding::UTF16LE) {
+        if(buffer != NULL) {
+            std::memcpy(buffer, chunk.bytes(), chunk.byteLength());
+            SuperString::UTF16LE::swap(buffer, chunk.byteLength());
+        }
+        return Result<std::size_t, Error>(chunk.byteLength());
+    }
+    const Byte *pointer = chunk.bytes();
+    Byte scratch[4];
+    std::size_t size = 0;
+    for(std::size_t i = 0; i < chunk.length(); i++) {
+        int codeUnit = 0;
+        switch(chunk.encoding()) {
+            case Encoding::ASCII:
+            case Encoding::Latin1:
+                codeUnit = *pointer;
+                pointer += 1;
+                break;
+            case Encoding::UTF8:
+                codeUnit = SuperString::UTF8::decode(pointer);
+                pointer += SuperString::UTF8::width(pointer);
+                break;
+            case Encoding::UTF16BE:
+                codeUnit = SuperString::UTF16BE::decode(pointer);
+                pointer += SuperString::UTF16BE::width(pointer);
+                break;
+            case Encoding::UTF32:
+                codeUnit = *((const int *) pointer);
+                pointer += sizeof(int);
+                break;
+            case Encoding::UTF16LE:
+                break; // never stored, swapped into UTF16BE
+        }
+        Byte *target = buffer != NULL ? buffer + size : scratch;
+        std::size_t width = 0;
+        switch(encoding) {
+            case Encoding::ASCII:
+                width = SuperString::ASCII::encode(codeUnit, target);
+                break;
+            case Encoding::UTF8:
+                width = SuperString::UTF8::encode(codeUnit, target);
+                break;
+            case Encoding::UTF16BE:
+                width = SuperString::UTF16BE::encode(codeUnit, target);
+                break;
+            case Encoding::UTF32:
+                width = SuperString::UTF32::encode(codeUnit, target);
+                break;
+            case Encoding::Latin1:
+                width = SuperString::ASCII::encode(codeUnit, target);
+                break;
+            case Encoding::UTF16LE:
+                width = SuperString::UTF16BE::encode(codeUnit, target);
+                SuperString::UTF16LE::swap(target, width);
+                break;
+        }
+        if(width == 0) {
+            return Result<std::size_t, Error>(Error::Unencodable);
+        }
+        size += width;
+    }
+    return Result<std::size_t, Error>(size);
+}
+
 SuperString SuperString::trim() const {
+    if(this->isInline()) {
+        return this->trimInline(true, true);
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->trim();
     }
@@ -132,6 +624,9 @@ SuperString SuperString::trim() const {
 }
 
 SuperString SuperString::trimLeft() const {
+    if(this->isInline()) {
+        return this->trimInline(true, false);
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->trimLeft();
     }
@@ -139,6 +634,9 @@ SuperString SuperString::trimLeft() const {
 }
 
 SuperString SuperString::trimRight() const {
+    if(this->isInline()) {
+        return this->trimInline(false, true);
+    }
     if(this->_sequence != NULL) {
         return this->_sequence->trimRight();
     }
@@ -147,42 +645,201 @@ SuperString SuperString::trimRight() const {
 
 // TODO: delete this two methods
 std::size_t SuperString::freeingCost() const {
+    if(this->isInline()) {
+        return 0;
+    }
     return this->_sequence->freeingCost();
 }
 
+void SuperString::retentionPolicy(SuperString::RetentionPolicy *policy) {
+    if(!this->isInline() && this->_sequence != NULL) {
+        this->_sequence->retentionPolicy(policy);
+    }
+}
+
 std::size_t SuperString::keepingCost() const {
+    if(this->isInline()) {
+        return 0;
+    }
     return this->_sequence->keepingCost();
 }
 
-SuperString SuperString::operator+(const SuperString &other) const {
-    ConcatenationSequence *sequence = new ConcatenationSequence(this->_sequence, other._sequence);
-    return SuperString(sequence);
+SuperString SuperString::operator+(const SuperString &other) const & {
+    bool isInline = this->isInline();
+    bool isOtherInline = other.isInline();
+    if(isInline && isOtherInline && this->inlineByteLength() + other.inlineByteLength() <= InlineCapacity) {
+        SuperString string(*this);
+        string += other;
+        return string;
+    }
+    if(this->isEmpty()) {
+        return other;
+    }
+    if(other.isEmpty()) {
+        return *this;
+    }
+    if(isInline && isOtherInline) {
+        // too long to stay inline, both are copied to a single leaf
+        return this->materialize(other);
+    }
+    if(isInline || isOtherInline) {
+        // joined to a rope as a leaf of its own
+        return (isInline ? this->materialize() : *this) + (isOtherInline ? other.materialize() : other);
+    }
+    const StringSequence *sequence = ConcatenationSequence::concatenate(this->_sequence, other._sequence);
+    return SuperString((StringSequence *) ((std::size_t) sequence));
+}
+
+SuperString SuperString::operator+(const SuperString &other) && {
+    *this += other;
+    return std::move(*this);
+}
+
+SuperString &SuperString::operator+=(const SuperString &other) {
+    if(other.isEmpty()) {
+        return *this;
+    }
+    if(this->isInline() && other.isInline()) {
+        std::size_t byteLength = this->inlineByteLength();
+        std::size_t otherByteLength = other.inlineByteLength();
+        if(byteLength + otherByteLength <= InlineCapacity) {
+            Byte ascii = this->_inline[InlineCapacity] & other._inline[InlineCapacity] & InlineASCII;
+            std::memcpy(this->_inline + byteLength, other._inline, otherByteLength);
+            this->_inline[InlineCapacity] = (Byte) ((byteLength + otherByteLength + 1) | ascii);
+            return *this;
+        }
+    }
+    // appending a string to itself would read the buffer being grown
+    if(!this->isInline() && this->_sequence != NULL && (other.isInline() || this->_sequence != other._sequence) &&
+       other.length() <= ConcatenationSequence::MergeLength && this->_sequence->isUnique()) {
+        if(other.isInline()) {
+            SuperString materialized = other.materialize();
+            if(this->_sequence->append(materialized._sequence)) {
+                return *this;
+            }
+        } else if(this->_sequence->append(other._sequence)) {
+            return *this;
+        }
+    }
+    return *this = *this + other;
 }
 
 SuperString SuperString::operator*(std::size_t times) const {
+    if(this->isInline()) {
+        std::size_t byteLength = this->inlineByteLength();
+        if(byteLength != 0 && InlineCapacity / byteLength < times) {
+            return this->materialize() * times;
+        }
+        Byte bytes[InlineCapacity];
+        for(std::size_t i = 0; i < times && byteLength != 0; i++) {
+            std::memcpy(bytes + i * byteLength, this->_inline, byteLength);
+        }
+        SuperString string;
+        string.storeInline(bytes, byteLength != 0 ? byteLength * times : 0);
+        return string;
+    }
     MultipleSequence *sequence = new MultipleSequence(this->_sequence, times);
     return SuperString(sequence);
 }
 
 SuperString &SuperString::operator=(const SuperString &other) {
     if(this != &other) {
-        if(this->_sequence->refRelease() == 0) {
-            this->_sequence->doDelete();
+        // taken first, [other] may only be held through this string
+        if(!other.isInline() && other._sequence != NULL) {
+            other._sequence->refAdd();
         }
-        this->_sequence = other._sequence;
-        this->_sequence->refAdd();
+        if(!this->isInline() && this->_sequence != NULL) {
+            this->_sequence->release();
+        }
+        std::memcpy(this->_inline, other._inline, sizeof(this->_inline));
+    }
+    return *this;
+}
+
+SuperString &SuperString::operator=(SuperString &&other) {
+    if(this != &other) {
+        Byte taken[InlineCapacity + 1];
+        std::memcpy(taken, other._inline, sizeof(taken));
+        other._sequence = NULL;
+        other._inline[InlineCapacity] = 0;
+        if(!this->isInline() && this->_sequence != NULL) {
+            this->_sequence->release();
+        }
+        std::memcpy(this->_inline, taken, sizeof(taken));
     }
     return *this;
 }
 
 bool SuperString::operator==(const SuperString &other) const {
+    bool isInline = this->isInline();
+    bool isOtherInline = other.isInline();
+    if(isInline && isOtherInline) {
+        return this->_inline[InlineCapacity] == other._inline[InlineCapacity] &&
+               std::memcmp(this->_inline, other._inline, this->inlineByteLength()) == 0;
+    }
+    if(!isInline && !isOtherInline && this->_sequence == other._sequence) {
+        return true;
+    }
+    if(this->length() != other.length()) {
+        return false;
+    }
+    if(!isInline && !isOtherInline && this->_sequence != NULL && other._sequence != NULL) {
+        // only hashes already cached are compared, computing one reads the string
+        std::uint64_t hash = this->_sequence->_hash;
+        std::uint64_t otherHash = other._sequence->_hash;
+        if(hash != StringSequence::HashNotComputed && otherHash != StringSequence::HashNotComputed &&
+           hash != otherHash) {
+            return false;
+        }
+    }
     return this->compareTo(other) == 0;
 }
 
+bool SuperString::operator!=(const SuperString &other) const {
+    return !(*this == other);
+}
+
+bool SuperString::operator<(const SuperString &other) const {
+    return this->compareTo(other) < 0;
+}
+
+bool SuperString::operator<=(const SuperString &other) const {
+    return this->compareTo(other) <= 0;
+}
+
+bool SuperString::operator>(const SuperString &other) const {
+    return this->compareTo(other) > 0;
+}
+
+bool SuperString::operator>=(const SuperString &other) const {
+    return this->compareTo(other) >= 0;
+}
+
+std::size_t SuperString::hash() const {
+    if(this->isInline()) {
+        Hash::State state = {0, 0, NULL};
+        this->visitChunks(0, this->inlineLength(), Hash::visit, &state);
+        return (std::size_t) state._hash;
+    }
+    if(this->_sequence == NULL) {
+        return 0;
+    }
+    return (std::size_t) this->_sequence->hash();
+}
+
 SuperString SuperString::Const(const char *chars, SuperString::Encoding encoding) {
+    if(encoding == Encoding::UTF16LE) {
+        // no sequence reads UTF-16LE in place
+        return SuperString::Copy(chars, encoding);
+    }
+    SuperString string;
+    if(SuperString::Inline((const Byte *) chars, encoding, string)) {
+        return string;
+    }
     StringSequence *sequence = NULL;
     switch(encoding) {
         case Encoding::ASCII:
+        case Encoding::Latin1:
             sequence = new SuperString::ConstASCIISequence((Byte *) chars);
             break;
         case Encoding::UTF8:
@@ -194,6 +851,8 @@ SuperString SuperString::Const(const char *chars, SuperString::Encoding encoding
         case Encoding::UTF32:
             sequence = new SuperString::ConstUTF32Sequence((Byte *) chars);
             break;
+        case Encoding::UTF16LE:
+            break; // never stored, swapped into UTF16BE
     }
     return SuperString(sequence);
 }
@@ -207,9 +866,20 @@ SuperString SuperString::Const(const SuperString::Byte *bytes, SuperString::Enco
 }
 
 SuperString SuperString::Copy(const char *chars, Encoding encoding) {
+    if(encoding == Encoding::UTF16LE) {
+        Byte *swapped = SuperString::UTF16LE::toBigEndian((const Byte *) chars);
+        SuperString copy = SuperString::Copy(swapped, Encoding::UTF16BE);
+        delete[] swapped;
+        return copy;
+    }
+    SuperString string;
+    if(SuperString::Inline((const Byte *) chars, encoding, string)) {
+        return string;
+    }
     StringSequence *sequence = NULL;
     switch(encoding) {
         case Encoding::ASCII:
+        case Encoding::Latin1:
             sequence = new SuperString::CopyASCIISequence((Byte *) chars);
             break;
         case Encoding::UTF8:
@@ -221,6 +891,8 @@ SuperString SuperString::Copy(const char *chars, Encoding encoding) {
         case Encoding::UTF32:
             sequence = new SuperString::CopyUTF32Sequence((Byte *) chars);
             break;
+        case Encoding::UTF16LE:
+            break; // never stored, swapped into UTF16BE
     }
     return SuperString(sequence);
 }
@@ -233,114 +905,2067 @@ SuperString SuperString::Copy(const SuperString::Byte *bytes, Encoding encoding)
     return SuperString::Copy((const char *) bytes, encoding);
 }
 
-//*-- SuperString::StringSequence (abstract|internal)
-SuperString::StringSequence::StringSequence()
-        : _refCount(0) {
-    // nothing go here
+SuperString::Result<SuperString, SuperString::Error>
+SuperString::MapFile(const char *path, SuperString::Encoding encoding, SuperString::Access access) {
+#ifdef SUPERSTRING_MAPPED_FILES
+    if(encoding == Encoding::UTF16LE) {
+        return Result<SuperString, Error>(Error::Unimplemented);
+    }
+    int descriptor = open(path, O_RDONLY);
+    if(descriptor < 0) {
+        return Result<SuperString, Error>(Error::IOError);
+    }
+    struct stat status;
+    if(fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(descriptor);
+        return Result<SuperString, Error>(Error::IOError);
+    }
+    std::size_t fileLength = (std::size_t) status.st_size;
+    std::size_t pageLength = (std::size_t) sysconf(_SC_PAGESIZE);
+    // a page of zeros past the last page of the file terminates the string in every encoding
+    std::size_t regionLength = (fileLength + pageLength - 1) / pageLength * pageLength + pageLength;
+    void *region = mmap(NULL, regionLength, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED) {
+        close(descriptor);
+        return Result<SuperString, Error>(Error::IOError);
+    }
+    if(fileLength != 0 &&
+       mmap(region, fileLength, PROT_READ, MAP_PRIVATE | MAP_FIXED, descriptor, 0) == MAP_FAILED) {
+        munmap(region, regionLength);
+        close(descriptor);
+        return Result<SuperString, Error>(Error::IOError);
+    }
+    close(descriptor); // the mapping keeps the file open
+    switch(access) {
+        case Access::Normal:
+            break;
+        case Access::Sequential:
+            madvise(region, fileLength, MADV_SEQUENTIAL);
+            break;
+        case Access::Random:
+            madvise(region, fileLength, MADV_RANDOM);
+            break;
+    }
+    StringSequence *sequence = NULL;
+    switch(encoding) {
+        case Encoding::ASCII:
+        case Encoding::Latin1:
+            sequence = new SuperString::MappedSequence<ConstASCIISequence>((Byte *) region, regionLength);
+            break;
+        case Encoding::UTF8:
+            sequence = new SuperString::MappedSequence<ConstUTF8Sequence>((Byte *) region, regionLength);
+            break;
+        case Encoding::UTF16BE:
+            sequence = new SuperString::MappedSequence<ConstUTF16BESequence>((Byte *) region, regionLength);
+            break;
+        case Encoding::UTF32:
+            sequence = new SuperString::MappedSequence<ConstUTF32Sequence>((Byte *) region, regionLength);
+            break;
+        case Encoding::UTF16LE:
+            break; // never stored, swapped into UTF16BE
+    }
+    return Result<SuperString, Error>(SuperString(sequence));
+#else
+    return Result<SuperString, Error>(Error::Unimplemented);
+#endif
+}
+
+std::size_t SuperString::offsetIndexStride() {
+    return SuperString::_offsetIndexStride;
+}
+
+void SuperString::offsetIndexStride(std::size_t stride) {
+    SuperString::_offsetIndexStride = stride;
+}
+
+SuperString::Stats SuperString::stats() {
+    return Stats(SuperString::_counters._sequenceCount, SuperString::_counters._referencerCount,
+                 SuperString::_counters._freeingCost, SuperString::_counters._retainedBytes,
+                 SuperString::_deferred.size(), SuperString::_counters._retentionCount,
+                 SuperString::_counters._reconstructionCount, SuperString::_counters._reconstructedBytes);
+}
+
+SuperString::RetentionPolicy &SuperString::retentionPolicy() {
+    return *SuperString::_retentionPolicy;
+}
+
+void SuperString::retentionPolicy(SuperString::RetentionPolicy &policy) {
+    SuperString::_retentionPolicy = &policy;
+}
+
+bool SuperString::deferredReconstruction() {
+    return SuperString::_isReconstructionDeferred;
+}
+
+void SuperString::deferredReconstruction(bool isDeferred) {
+    SuperString::_isReconstructionDeferred = isDeferred;
+}
+
+std::size_t SuperString::collect(std::size_t budget) {
+    std::size_t count = 0;
+    std::size_t cost = 0;
+    // freeing a sequence may defer the ones it cascades into, which are taken in turn
+    while(!SuperString::_deferred.empty() && cost < budget) {
+        StringSequence *sequence = SuperString::_deferred.back();
+        SuperString::_deferred.pop_back();
+        cost += sequence->freeingCost();
+        sequence->release(false);
+        count++;
+    }
+    return count;
+}
+
+void SuperString::countUp(Counter &counter, std::size_t delta) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    counter.fetch_add(delta, std::memory_order_relaxed);
+#else
+    counter += delta;
+#endif
+}
+
+void SuperString::countDown(Counter &counter, std::size_t delta) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    counter.fetch_sub(delta, std::memory_order_relaxed);
+#else
+    counter -= delta;
+#endif
+}
+
+std::size_t SuperString::inlineLength() const {
+    std::size_t byteLength = this->inlineByteLength();
+    if((this->_inline[InlineCapacity] & InlineASCII) != 0) {
+        return byteLength;
+    }
+    return SuperString::UTF8::length(this->_inline, byteLength);
+}
+
+std::size_t SuperString::inlineOffset(std::size_t index) const {
+    if((this->_inline[InlineCapacity] & InlineASCII) != 0) {
+        return index;
+    }
+    return SuperString::UTF8::offset(this->_inline, index).ok();
+}
+
+void SuperString::storeInline(const Byte *bytes, std::size_t byteLength) {
+    Byte ascii = InlineASCII;
+    for(std::size_t i = 0; i < byteLength; i++) {
+        this->_inline[i] = bytes[i];
+        if(bytes[i] >= 0x80) {
+            ascii = 0;
+        }
+    }
+    this->_inline[InlineCapacity] = (Byte) ((byteLength + 1) | ascii);
+}
+
+SuperString SuperString::materialize() const {
+    std::size_t byteLength = this->inlineByteLength();
+    Byte *data = new Byte[byteLength + 1];
+    std::memcpy(data, this->_inline, byteLength);
+    data[byteLength] = 0x00;
+    if((this->_inline[InlineCapacity] & InlineASCII) != 0) {
+        return SuperString(new CopyASCIISequence(data, byteLength, byteLength + 1));
+    }
+    return SuperString(new CopyUTF8Sequence(data, this->inlineLength(), byteLength + 1, byteLength + 1));
+}
+
+SuperString SuperString::materialize(const SuperString &other) const {
+    std::size_t byteLength = this->inlineByteLength();
+    std::size_t otherByteLength = other.inlineByteLength();
+    Byte *data = new Byte[byteLength + otherByteLength + 1];
+    std::memcpy(data, this->_inline, byteLength);
+    std::memcpy(data + byteLength, other._inline, otherByteLength);
+    data[byteLength + otherByteLength] = 0x00;
+    if((this->_inline[InlineCapacity] & other._inline[InlineCapacity] & InlineASCII) != 0) {
+        return SuperString(new CopyASCIISequence(data, byteLength + otherByteLength, byteLength + otherByteLength + 1));
+    }
+    return SuperString(new CopyUTF8Sequence(data, this->inlineLength() + other.inlineLength(),
+                                            byteLength + otherByteLength + 1, byteLength + otherByteLength + 1));
+}
+
+SuperString SuperString::trimInline(bool isLeft, bool isRight) const {
+    std::size_t startIndex = 0;
+    std::size_t endIndex = this->inlineLength();
+    while(isLeft && startIndex < endIndex && SuperString::isWhiteSpace(this->codeUnitAt(startIndex).ok())) {
+        startIndex++;
+    }
+    while(isRight && startIndex < endIndex && SuperString::isWhiteSpace(this->codeUnitAt(endIndex - 1).ok())) {
+        endIndex--;
+    }
+    return this->substring(startIndex, endIndex).ok();
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::searchInline(const SuperString &other, bool isReverse) const {
+    std::size_t length = this->inlineLength();
+    std::size_t otherLength = other.length();
+    if(otherLength == 0) {
+        return Result<std::size_t, Error>(isReverse ? length : 0);
+    }
+    if(length < otherLength) {
+        return Result<std::size_t, Error>(Error::NotFound);
+    }
+    // a few code units at most, compared naively
+    int codeUnits[InlineCapacity];
+    int pattern[InlineCapacity];
+    this->copyTo((Byte *) codeUnits, 0, length, Encoding::UTF32);
+    other.copyTo((Byte *) pattern, 0, otherLength, Encoding::UTF32);
+    for(std::size_t i = 0; i <= length - otherLength; i++) {
+        std::size_t index = isReverse ? length - otherLength - i : i;
+        if(std::equal(pattern, pattern + otherLength, codeUnits + index)) {
+            return Result<std::size_t, Error>(index);
+        }
+    }
+    return Result<std::size_t, Error>(Error::NotFound);
+}
+
+bool SuperString::Inline(const Byte *bytes, Encoding encoding, SuperString &string) {
+    Byte buffer[InlineCapacity + 4];
+    std::size_t size = 0;
+    const Byte *pointer = bytes;
+    while(true) {
+        int codeUnit = 0;
+        std::size_t width = 1;
+        switch(encoding) {
+            case Encoding::ASCII:
+            case Encoding::Latin1:
+                codeUnit = *pointer;
+                if(codeUnit >= 0x80) {
+                    return false; // kept as it is by the sequence
+                }
+                break;
+            case Encoding::UTF8:
+                if(*pointer >= 0x80) {
+                    // the continuation bytes are checked first, not to read past the NUL
+                    width = SuperString::UTF8::width(pointer);
+                    for(std::size_t i = 1; i < width; i++) {
+                        if((pointer[i] & 0xc0) != 0x80) {
+                            return false;
+                        }
+                    }
+                    if(SuperString::UTF8::check(pointer) != width) {
+                        return false;
+                    }
+                }
+                codeUnit = SuperString::UTF8::decode(pointer);
+                break;
+            case Encoding::UTF16BE:
+                width = (pointer[0] & 0xfc) == 0xd8 ? 4 : 2;
+                if(width == 4 && (pointer[2] & 0xfc) != 0xdc) {
+                    return false;
+                }
+                codeUnit = SuperString::UTF16BE::decode(pointer);
+                break;
+            case Encoding::UTF32:
+                std::memcpy(&codeUnit, pointer, sizeof(int));
+                width = sizeof(int);
+                break;
+            case Encoding::UTF16LE:
+                break; // never stored, swapped into UTF16BE
+        }
+        if(codeUnit == 0) {
+            break;
+        }
+        std::size_t written = SuperString::UTF8::encode(codeUnit, buffer + size);
+        if(written == 0 || InlineCapacity < size + written) {
+            return false;
+        }
+        size += written;
+        pointer += width;
+    }
+    string.storeInline(buffer, size);
+    return true;
+}
+
+bool SuperString::Inline(const StringSequence *sequence, std::size_t startIndex, std::size_t endIndex,
+                         SuperString &string) {
+    if(startIndex == endIndex) {
+        string.storeInline(NULL, 0);
+        return true;
+    }
+    // at most 4 bytes per code unit
+    Byte buffer[InlineCapacity * 4];
+    CopyContext context = {buffer, 0, Encoding::UTF8, Error::Unexpected};
+    if(!sequence->visitChunks(startIndex, endIndex, SuperString::copyVisitor, &context) ||
+       InlineCapacity < context._size ||
+       SuperString::UTF8::length(buffer, context._size) != endIndex - startIndex) {
+        return false;
+    }
+    string.storeInline(buffer, context._size);
+    return true;
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::validate(const char *chars, SuperString::Encoding encoding, std::size_t *errorOffset) {
+    const Byte *bytes = (const Byte *) chars;
+    const Byte *pointer = bytes;
+    std::size_t length = 0;
+    switch(encoding) {
+        case Encoding::ASCII:
+            pointer = SuperString::UTF8::skipASCII(bytes);
+            if(*pointer == 0x00) {
+                return Result<std::size_t, Error>((std::size_t) (pointer - bytes));
+            }
+            break;
+        case Encoding::UTF8: {
+            Result<Pair<std::size_t, std::size_t>, Error> result = SuperString::UTF8::validate(bytes, errorOffset);
+            if(result.isOk()) {
+                return Result<std::size_t, Error>(result.ok().first());
+            }
+            return Result<std::size_t, Error>(result.err());
+        }
+        case Encoding::UTF16BE:
+            while(*pointer != 0x00 || *(pointer + 1) != 0x00) {
+                if((*pointer & 0xfc) == 0xdc) {
+                    break; // unpaired low surrogate
+                }
+                if((*pointer & 0xfc) == 0xd8) {
+                    if((*(pointer + 2) & 0xfc) != 0xdc) {
+                        break; // unpaired high surrogate
+                    }
+                    pointer += 2;
+                }
+                pointer += 2;
+                length++;
+            }
+            if(*pointer == 0x00 && *(pointer + 1) == 0x00) {
+                return Result<std::size_t, Error>(length);
+            }
+            break;
+        case Encoding::UTF32:
+            while(*((const int *) pointer) != 0x00) {
+                int codeUnit = *((const int *) pointer);
+                if(codeUnit < 0 || codeUnit > 0x10ffff || (codeUnit >= 0xd800 && codeUnit <= 0xdfff)) {
+                    break;
+                }
+                pointer += 4;
+                length++;
+            }
+            if(*((const int *) pointer) == 0x00) {
+                return Result<std::size_t, Error>(length);
+            }
+            break;
+        case Encoding::Latin1:
+            // every byte is a code unit
+            return Result<std::size_t, Error>(std::strlen(chars));
+        case Encoding::UTF16LE: {
+            // the same bytes are ill-formed at the same offsets in either byte order
+            Byte *swapped = SuperString::UTF16LE::toBigEndian(bytes);
+            Result<std::size_t, Error> result = SuperString::validate((const char *) swapped, Encoding::UTF16BE,
+                                                                      errorOffset);
+            delete[] swapped;
+            return result;
+        }
+    }
+    if(errorOffset != NULL) {
+        *errorOffset = (std::size_t) (pointer - bytes);
+    }
+    return Result<std::size_t, Error>(Error::InvalidByteSequence);
+}
+
+//*-- SuperString::Chunk
+SuperString::Chunk::Chunk(const Byte *bytes, std::size_t byteLength, std::size_t length, Encoding encoding)
+        : _bytes(bytes),
+          _byteLength(byteLength),
+          _length(length),
+          _encoding(encoding) {
+    // nothing go here
+}
+
+const SuperString::Byte *SuperString::Chunk::bytes() const {
+    return this->_bytes;
+}
+
+std::size_t SuperString::Chunk::byteLength() const {
+    return this->_byteLength;
+}
+
+std::size_t SuperString::Chunk::length() const {
+    return this->_length;
+}
+
+SuperString::Encoding SuperString::Chunk::encoding() const {
+    return this->_encoding;
+}
+
+//*-- SuperString::Stats
+SuperString::Stats::Stats(std::size_t sequenceCount, std::size_t referencerCount, std::size_t freeingCost,
+                          std::size_t retainedBytes, std::size_t deferredCount, std::size_t retentionCount,
+                          std::size_t reconstructionCount, std::size_t reconstructedBytes)
+        : _sequenceCount(sequenceCount), _referencerCount(referencerCount), _freeingCost(freeingCost),
+          _retainedBytes(retainedBytes), _deferredCount(deferredCount), _retentionCount(retentionCount),
+          _reconstructionCount(reconstructionCount), _reconstructedBytes(reconstructedBytes) {
+    // nothing go here
+}
+
+std::size_t SuperString::Stats::sequenceCount() const {
+    return this->_sequenceCount;
+}
+
+std::size_t SuperString::Stats::referencerCount() const {
+    return this->_referencerCount;
+}
+
+std::size_t SuperString::Stats::freeingCost() const {
+    return this->_freeingCost;
+}
+
+std::size_t SuperString::Stats::retainedBytes() const {
+    return this->_retainedBytes;
+}
+
+std::size_t SuperString::Stats::deferredCount() const {
+    return this->_deferredCount;
+}
+
+std::size_t SuperString::Stats::retentionCount() const {
+    return this->_retentionCount;
+}
+
+std::size_t SuperString::Stats::reconstructionCount() const {
+    return this->_reconstructionCount;
+}
+
+std::size_t SuperString::Stats::reconstructedBytes() const {
+    return this->_reconstructedBytes;
+}
+
+//*-- SuperString::RetentionPolicy
+SuperString::RetentionPolicy::~RetentionPolicy() {
+    // nothing go here
+}
+
+//*-- SuperString::RetentionPolicy::CostBased
+bool SuperString::RetentionPolicy::CostBased::isToBeFreed(std::size_t keepingCost,
+                                                          std::size_t freeingCost) const /*override*/ {
+    return freeingCost < keepingCost;
+}
+
+//*-- SuperString::RetentionPolicy::AlwaysKeep
+bool SuperString::RetentionPolicy::AlwaysKeep::isToBeFreed(std::size_t /*keepingCost*/,
+                                                           std::size_t /*freeingCost*/) const /*override*/ {
+    return false;
+}
+
+//*-- SuperString::RetentionPolicy::Threshold
+SuperString::RetentionPolicy::Threshold::Threshold(std::size_t threshold)
+        : _threshold(threshold) {
+    // nothing go here
+}
+
+bool SuperString::RetentionPolicy::Threshold::isToBeFreed(std::size_t /*keepingCost*/,
+                                                          std::size_t freeingCost) const /*override*/ {
+    return freeingCost <= this->_threshold;
+}
+
+//*-- SuperString::RetentionPolicy::MemoryBudget
+SuperString::RetentionPolicy::MemoryBudget::MemoryBudget(std::size_t budget)
+        : _budget(budget) {
+    // nothing go here
+}
+
+bool SuperString::RetentionPolicy::MemoryBudget::isToBeFreed(std::size_t keepingCost,
+                                                             std::size_t freeingCost) const /*override*/ {
+    return freeingCost < keepingCost || SuperString::_counters._retainedBytes + keepingCost > this->_budget;
+}
+
+//*-- SuperString::Iterator
+SuperString::Iterator::Iterator()
+        : _sequence(NULL),
+          _bytes(NULL),
+          _index(0),
+          _length(0) {
+    this->_cursor._bytes = NULL;
+}
+
+SuperString::Iterator::Iterator(const StringSequence *sequence, std::size_t index)
+        : _sequence(sequence),
+          _bytes(NULL),
+          _index(index),
+          _length(sequence != NULL ? sequence->length() : 0) {
+    this->_cursor._bytes = NULL;
+    if(this->_index < this->_length) {
+        this->seek();
+    }
+}
+
+SuperString::Iterator::Iterator(const Byte *bytes, std::size_t length, std::size_t index)
+        : _sequence(NULL),
+          _bytes(bytes),
+          _index(index),
+          _length(length) {
+    this->_cursor._bytes = NULL;
+    if(this->_index < this->_length) {
+        this->seek();
+    }
+}
+
+std::size_t SuperString::Iterator::index() const {
+    return this->_index;
+}
+
+int SuperString::Iterator::operator*() const {
+    const Byte *pointer = this->_cursor._bytes;
+    switch(this->_cursor._encoding) {
+        case Encoding::ASCII:
+        case Encoding::Latin1:
+            return *pointer;
+        case Encoding::UTF8:
+            return SuperString::UTF8::decode(pointer);
+        case Encoding::UTF16BE:
+            return SuperString::UTF16BE::decode(pointer);
+        case Encoding::UTF32:
+            return *((const int *) pointer);
+        case Encoding::UTF16LE:
+            break; // never stored, swapped into UTF16BE
+    }
+    return 0;
+}
+
+SuperString::Iterator &SuperString::Iterator::operator++() {
+    this->_index++;
+    if(this->_cursor._bytes != NULL && this->_index < this->_cursor._endIndex) {
+        this->_cursor._bytes += width(this->_cursor);
+    } else if(this->_index < this->_length) {
+        this->seek();
+    }
+    return *this;
+}
+
+SuperString::Iterator SuperString::Iterator::operator++(int) {
+    Iterator previous = *this;
+    ++(*this);
+    return previous;
+}
+
+SuperString::Iterator &SuperString::Iterator::operator--() {
+    if(this->_cursor._bytes != NULL && this->_cursor._startIndex < this->_index &&
+       this->_index < this->_cursor._endIndex) {
+        const Byte *pointer = this->_cursor._bytes;
+        switch(this->_cursor._encoding) {
+            case Encoding::ASCII:
+            case Encoding::Latin1:
+                pointer--;
+                break;
+            case Encoding::UTF8:
+                do {
+                    pointer--;
+                } while((*pointer & 0xc0) == 0x80);
+                break;
+            case Encoding::UTF16BE:
+                pointer -= 2;
+                if((*pointer & 0xfc) == 0xdc) {
+                    pointer -= 2;
+                }
+                break;
+            case Encoding::UTF32:
+                pointer -= 4;
+                break;
+            case Encoding::UTF16LE:
+                break; // never stored, swapped into UTF16BE
+        }
+        this->_cursor._bytes = pointer;
+        this->_index--;
+    } else {
+        this->_index--;
+        this->seek();
+    }
+    return *this;
+}
+
+SuperString::Iterator SuperString::Iterator::operator--(int) {
+    Iterator previous = *this;
+    --(*this);
+    return previous;
+}
+
+bool SuperString::Iterator::operator==(const SuperString::Iterator &other) const {
+    return this->_sequence == other._sequence && this->_bytes == other._bytes && this->_index == other._index;
+}
+
+bool SuperString::Iterator::operator!=(const SuperString::Iterator &other) const {
+    return !(*this == other);
+}
+
+void SuperString::Iterator::seek() {
+    if(!SuperString::cursorAt(this->_sequence, this->_bytes, this->_index, this->_length, this->_cursor)) {
+        this->_cursor._bytes = NULL;
+    }
+}
+
+std::size_t SuperString::Iterator::width(const SuperString::Cursor &cursor) {
+    switch(cursor._encoding) {
+        case Encoding::ASCII:
+        case Encoding::Latin1:
+            return 1;
+        case Encoding::UTF8:
+            return SuperString::UTF8::width(cursor._bytes);
+        case Encoding::UTF16BE:
+            return SuperString::UTF16BE::width(cursor._bytes);
+        case Encoding::UTF32:
+            return 4;
+        case Encoding::UTF16LE:
+            break; // never stored, swapped into UTF16BE
+    }
+    return 1;
+}
+
+//*-- SuperString::Builder
+SuperString::Builder::Builder(std::size_t chunkCapacity)
+        : _chunk(NULL),
+          _chunkCapacity(chunkCapacity < 4 ? 4 : chunkCapacity),
+          _chunkByteLength(0),
+          _chunkLength(0),
+          _isChunkASCII(true),
+          _pendingLength(0),
+          _length(0) {
+    // nothing go here
+}
+
+SuperString::Builder::~Builder() {
+    for(StringSequence *sequence : this->_pieces) {
+        sequence->release();
+    }
+    delete[] this->_chunk;
+}
+
+std::size_t SuperString::Builder::length() const {
+    return this->_length;
+}
+
+SuperString::Result<bool, SuperString::Error>
+SuperString::Builder::append(const char *bytes, std::size_t byteLength) {
+    return this->append((const Byte *) bytes, byteLength);
+}
+
+SuperString::Result<bool, SuperString::Error>
+SuperString::Builder::append(const SuperString::Byte *bytes, std::size_t byteLength) {
+    const Byte *pointer = bytes;
+    const Byte *end = bytes + byteLength;
+    // first completes the sequence cut by the previous append
+    while(this->_pendingLength != 0 && pointer < end) {
+        this->_pending[this->_pendingLength++] = *pointer++;
+        std::size_t width = SuperString::UTF8::width(this->_pending);
+        if(this->_pendingLength == width || (this->_pending[this->_pendingLength - 1] & 0xc0) != 0x80) {
+            this->_pendingLength = 0;
+            if(SuperString::UTF8::check(this->_pending) != width) {
+                return Result<bool, Error>(Error::InvalidByteSequence);
+            }
+            std::copy_n(this->_pending, width, this->reserve(width));
+            this->_chunkByteLength += width;
+            this->_chunkLength++;
+            this->_length++;
+            this->_isChunkASCII = false;
+        }
+    }
+    while(pointer < end) {
+        Byte *output = this->reserve(1);
+        std::size_t room = std::min((std::size_t) (end - pointer), this->_chunkCapacity - this->_chunkByteLength);
+        std::size_t i = 0;
+        std::size_t length = 0;
+        bool isValid = true;
+        while(i < room) {
+            // ASCII is copied a word at a time, until a non-ASCII or a NUL byte
+            std::size_t runStart = i;
+            for(; i + 8 <= room; i += 8) {
+                unsigned long long word;
+                std::memcpy(&word, pointer + i, 8);
+                if(((word | ((word - 0x0101010101010101ULL) & ~word)) & 0x8080808080808080ULL) != 0) {
+                    break;
+                }
+                std::memcpy(output + i, &word, 8);
+            }
+            for(; i < room && pointer[i] != 0x00 && pointer[i] < 0x80; i++) {
+                output[i] = pointer[i];
+            }
+            length += i - runStart;
+            if(i == room) {
+                break;
+            }
+            std::size_t width = SuperString::UTF8::width(pointer + i);
+            if(pointer[i] == 0x00 || (i + width <= room && SuperString::UTF8::check(pointer + i) != width)) {
+                isValid = false;
+                break;
+            }
+            if(i + width > room) {
+                break; // cut by the end of the input or of the chunk
+            }
+            std::copy_n(pointer + i, width, output + i);
+            i += width;
+            length++;
+            this->_isChunkASCII = false;
+        }
+        this->_chunkByteLength += i;
+        this->_chunkLength += length;
+        this->_length += length;
+        pointer += i;
+        if(!isValid) {
+            return Result<bool, Error>(Error::InvalidByteSequence);
+        }
+        if(i < room) {
+            if((std::size_t) (end - pointer) < SuperString::UTF8::width(pointer)) {
+                // kept until the next append completes it
+                this->_pendingLength = (std::size_t) (end - pointer);
+                std::copy_n(pointer, this->_pendingLength, this->_pending);
+                break;
+            }
+            this->seal();
+        }
+    }
+    return Result<bool, Error>(true);
+}
+
+SuperString::Result<bool, SuperString::Error> SuperString::Builder::append(const SuperString &string) {
+    if(this->_pendingLength != 0) {
+        return Result<bool, Error>(Error::InvalidByteSequence);
+    }
+    if(string.isInline()) {
+        return this->append(string._inline, string.inlineByteLength());
+    }
+    if(string.isNotEmpty()) {
+        this->seal();
+        string._sequence->refAdd();
+        this->_pieces.push_back(string._sequence);
+        this->_length += string.length();
+    }
+    return Result<bool, Error>(true);
+}
+
+SuperString::Result<bool, SuperString::Error> SuperString::Builder::appendCodeUnit(int codeUnit) {
+    if(this->_pendingLength != 0) {
+        return Result<bool, Error>(Error::InvalidByteSequence);
+    }
+    Byte bytes[4];
+    std::size_t width = SuperString::UTF8::encode(codeUnit, bytes);
+    if(width == 0 || codeUnit == 0x00) {
+        return Result<bool, Error>(Error::Unencodable);
+    }
+    std::copy_n(bytes, width, this->reserve(width));
+    this->_chunkByteLength += width;
+    this->_chunkLength++;
+    this->_length++;
+    this->_isChunkASCII = this->_isChunkASCII && width == 1;
+    return Result<bool, Error>(true);
+}
+
+SuperString::Result<SuperString, SuperString::Error> SuperString::Builder::build() {
+    if(this->_pendingLength != 0) {
+        return Result<SuperString, Error>(Error::InvalidByteSequence);
+    }
+    this->seal();
+    if(this->_pieces.empty()) {
+        return Result<SuperString, Error>(SuperString::Const("", Encoding::ASCII));
+    }
+    const StringSequence *sequence = SuperString::Builder::join(&this->_pieces[0], this->_pieces.size());
+    SuperString string((StringSequence *) ((std::size_t) sequence));
+    // the nodes are linked directly, never through handles, so that none of them is flattened
+    // into its parent on release; the pieces are now held by the tree alone
+    for(StringSequence *piece : this->_pieces) {
+        piece->refRelease();
+    }
+    this->_pieces.clear();
+    this->_length = 0;
+    return Result<SuperString, Error>(string);
+}
+
+SuperString::Byte *SuperString::Builder::reserve(std::size_t byteLength) {
+    if(this->_chunk != NULL && this->_chunkCapacity - this->_chunkByteLength < byteLength) {
+        this->seal();
+    }
+    if(this->_chunk == NULL) {
+        this->_chunk = new Byte[this->_chunkCapacity + 1];
+    }
+    return this->_chunk + this->_chunkByteLength;
+}
+
+void SuperString::Builder::seal() {
+    if(this->_chunkByteLength == 0) {
+        return;
+    }
+    std::size_t capacity = this->_chunkCapacity + 1;
+    if(this->_chunkByteLength < this->_chunkCapacity / 2) {
+        // a partial chunk, when building or before a whole string, is shrunk to fit
+        capacity = this->_chunkByteLength + 1;
+        Byte *data = new Byte[capacity];
+        std::copy_n(this->_chunk, this->_chunkByteLength, data);
+        delete[] this->_chunk;
+        this->_chunk = data;
+    }
+    this->_chunk[this->_chunkByteLength] = 0x00;
+    StringSequence *sequence;
+    if(this->_isChunkASCII) {
+        sequence = new CopyASCIISequence(this->_chunk, this->_chunkLength, capacity);
+    } else {
+        sequence = new CopyUTF8Sequence(this->_chunk, this->_chunkLength, this->_chunkByteLength + 1, capacity);
+    }
+    sequence->refAdd();
+    this->_pieces.push_back(sequence);
+    this->_chunk = NULL;
+    this->_chunkByteLength = 0;
+    this->_chunkLength = 0;
+    this->_isChunkASCII = true;
+}
+
+const SuperString::StringSequence *SuperString::Builder::join(StringSequence *const *pieces, std::size_t count) {
+    if(count == 1) {
+        return pieces[0];
+    }
+    std::size_t half = count / 2;
+    return new ConcatenationSequence(SuperString::Builder::join(pieces, half),
+                                     SuperString::Builder::join(pieces + half, count - half));
+}
+
+//*-- SuperString::InternPool
+SuperString::InternPool::InternPool(bool isWeak)
+        : _isWeak(isWeak) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    for(std::size_t i = 0; i < InternPool::ShardCount; i++) {
+        this->_shards[i]._lock.clear();
+    }
+#endif
+}
+
+SuperString::InternPool::~InternPool() {
+    this->clear();
+}
+
+bool SuperString::InternPool::isWeak() const {
+    return this->_isWeak;
+}
+
+std::size_t SuperString::InternPool::size() const {
+    std::size_t size = 0;
+    for(std::size_t i = 0; i < InternPool::ShardCount; i++) {
+        InternPool::lock(this->_shards[i]);
+        size += this->_shards[i]._entries.size();
+        InternPool::unlock(this->_shards[i]);
+    }
+    return size;
+}
+
+std::size_t SuperString::InternPool::memoryLength() const {
+    std::size_t length = 0;
+    for(std::size_t i = 0; i < InternPool::ShardCount; i++) {
+        const Shard &shard = this->_shards[i];
+        InternPool::lock(shard);
+        for(std::unordered_multimap<std::uint64_t, StringSequence *>::const_iterator it = shard._entries.begin();
+            it != shard._entries.end(); ++it) {
+            length += it->second->keepingCost();
+        }
+        InternPool::unlock(shard);
+    }
+    return length;
+}
+
+SuperString SuperString::InternPool::intern(const SuperString &string) {
+    if(string.isInline() || string._sequence == NULL) {
+        return string;
+    }
+    const StringSequence *sequence = string._sequence;
+    SuperString inlined;
+    if(sequence->length() <= InlineCapacity && SuperString::Inline(sequence, 0, sequence->length(), inlined)) {
+        return inlined;
+    }
+    std::uint64_t hash = sequence->hash();
+    Shard &shard = this->shardOf(hash);
+    InternPool::lock(shard);
+    StringSequence *canonical = InternPool::find(shard, hash, sequence);
+    if(canonical != NULL) {
+        SuperString interned(canonical);
+        canonical->refRelease();
+        InternPool::unlock(shard);
+        return interned;
+    }
+    InternPool::unlock(shard);
+    // copied out of the lock, another thread may intern the same content meanwhile
+    SuperString created = sequence->compact(sequence->length());
+    if(created._sequence->depth() != 0 || created._sequence->isBorrowed() ||
+       (this->_isWeak && created._sequence->_internPool != NULL)) {
+        // not flat, borrowed from the caller's buffer, or weakly held by another pool
+        Result<SuperString, Error> flat = created.flatten(Encoding::UTF8);
+        created = flat.isOk() ? flat.ok() : created.flatten(Encoding::UTF32).ok();
+    }
+    created._sequence->_hash = hash;
+    InternPool::lock(shard);
+    canonical = InternPool::find(shard, hash, sequence);
+    if(canonical != NULL) {
+        SuperString interned(canonical);
+        canonical->refRelease();
+        InternPool::unlock(shard);
+        return interned;
+    }
+    canonical = created._sequence;
+    shard._entries.insert(std::make_pair(hash, canonical));
+    if(this->_isWeak) {
+        canonical->_internPool = this;
+    } else {
+        canonical->refAdd();
+    }
+    InternPool::unlock(shard);
+    return created;
+}
+
+void SuperString::InternPool::clear() {
+    std::vector<StringSequence *> held;
+    for(std::size_t i = 0; i < InternPool::ShardCount; i++) {
+        Shard &shard = this->_shards[i];
+        InternPool::lock(shard);
+        for(std::unordered_multimap<std::uint64_t, StringSequence *>::iterator it = shard._entries.begin();
+            it != shard._entries.end(); ++it) {
+            if(this->_isWeak) {
+                it->second->_internPool = NULL;
+            } else {
+                held.push_back(it->second);
+            }
+        }
+        shard._entries.clear();
+        InternPool::unlock(shard);
+    }
+    // released out of the locks, deleting a sequence may take them
+    for(std::size_t i = 0; i < held.size(); i++) {
+        held[i]->release();
+    }
+}
+
+SuperString::InternPool::Shard &SuperString::InternPool::shardOf(std::uint64_t hash) {
+    return this->_shards[hash % InternPool::ShardCount];
+}
+
+SuperString::StringSequence *
+SuperString::InternPool::find(const Shard &shard, std::uint64_t hash, const StringSequence *sequence) {
+    std::size_t length = sequence->length();
+    std::pair<std::unordered_multimap<std::uint64_t, StringSequence *>::const_iterator,
+              std::unordered_multimap<std::uint64_t, StringSequence *>::const_iterator> range =
+            shard._entries.equal_range(hash);
+    for(std::unordered_multimap<std::uint64_t, StringSequence *>::const_iterator it = range.first;
+        it != range.second; ++it) {
+        StringSequence *candidate = it->second;
+        // a candidate cannot be deleted while the shard is locked, but one released by every string is not
+        // revived when thread safe: it is left to the thread deleting it, and the content interned anew
+        if((candidate == sequence || (candidate->length() == length &&
+                                      SuperString::compareSequences(candidate, NULL, sequence, NULL, length) == 0)) &&
+           candidate->refAddIfHeld()) {
+            return candidate;
+        }
+    }
+    return NULL;
+}
+
+void SuperString::InternPool::remove(const StringSequence *sequence) {
+    Shard &shard = this->shardOf(sequence->_hash);
+    std::pair<std::unordered_multimap<std::uint64_t, StringSequence *>::iterator,
+              std::unordered_multimap<std::uint64_t, StringSequence *>::iterator> range =
+            shard._entries.equal_range(sequence->_hash);
+    for(std::unordered_multimap<std::uint64_t, StringSequence *>::iterator it = range.first;
+        it != range.second; ++it) {
+        if(it->second == sequence) {
+            shard._entries.erase(it);
+            break;
+        }
+    }
+}
+
+#ifdef SUPERSTRING_THREAD_SAFE
+void SuperString::InternPool::lock(const Shard &shard) {
+    for(std::size_t spins = 0; shard._lock.test_and_set(std::memory_order_acquire); spins++) {
+        // held for a lookup or an insertion, the lookup comparing whole strings of equal hash
+        if(spins >= InternPool::SpinCount) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void SuperString::InternPool::unlock(const Shard &shard) {
+    shard._lock.clear(std::memory_order_release);
+}
+#else
+void SuperString::InternPool::lock(const Shard & /*shard*/) {
+    // nothing go here
+}
+
+void SuperString::InternPool::unlock(const Shard & /*shard*/) {
+    // nothing go here
+}
+#endif
+
+//*-- SuperString::NodeAllocator (internal)
+thread_local SuperString::NodeAllocator::FreeLists SuperString::NodeAllocator::_freeLists;
+
+SuperString::NodeAllocator::FreeLists::~FreeLists() {
+    for(std::size_t i = 0; i < NodeAllocator::ClassCount; i++) {
+        while(this->_heads[i] != NULL) {
+            void *next = *(void **) this->_heads[i];
+            ::operator delete(this->_heads[i]);
+            this->_heads[i] = next;
+        }
+        this->_lengths[i] = 0;
+    }
+    this->_isReleased = true;
+}
+
+void *SuperString::NodeAllocator::allocate(std::size_t size) {
+    std::size_t sizeClass = (size + sizeof(std::size_t) + NodeAllocator::Granularity - 1) / NodeAllocator::Granularity;
+    std::size_t *header;
+#ifdef SUPERSTRING_NO_NODE_CACHE
+    sizeClass = 0;
+#endif
+    if(sizeClass == 0 || sizeClass >= NodeAllocator::ClassCount) {
+        // too large to be cached, or not caching
+        header = (std::size_t *) ::operator new(size + sizeof(std::size_t));
+        *header = 0;
+        return header + 1;
+    }
+    FreeLists &freeLists = NodeAllocator::_freeLists;
+    void *head = freeLists._heads[sizeClass];
+    if(head != NULL) {
+        freeLists._heads[sizeClass] = *(void **) head;
+        freeLists._lengths[sizeClass]--;
+        header = (std::size_t *) head;
+    } else {
+        header = (std::size_t *) ::operator new(sizeClass * NodeAllocator::Granularity);
+    }
+    *header = sizeClass;
+    return header + 1;
+}
+
+void SuperString::NodeAllocator::release(void *pointer) {
+    if(pointer == NULL) {
+        return;
+    }
+    std::size_t *header = ((std::size_t *) pointer) - 1;
+    std::size_t sizeClass = *header;
+    FreeLists &freeLists = NodeAllocator::_freeLists;
+    if(sizeClass == 0 || freeLists._isReleased || freeLists._lengths[sizeClass] >= NodeAllocator::CachedBlockCount) {
+        ::operator delete(header);
+        return;
+    }
+    *(void **) header = freeLists._heads[sizeClass];
+    freeLists._heads[sizeClass] = header;
+    freeLists._lengths[sizeClass]++;
+}
+
+//*-- SuperString::ReferencerSet (internal)
+SuperString::ReferencerSet::ReferencerSet()
+        : _capacity(0), _length(0), _cost(0) {
+    // nothing go here
+}
+
+SuperString::ReferencerSet::~ReferencerSet() {
+    SuperString::countDown(SuperString::_counters._referencerCount, this->_length);
+    SuperString::countDown(SuperString::_counters._freeingCost, this->_cost);
+    if(this->_capacity != 0) {
+        delete[] this->_table;
+    }
+}
+
+std::size_t SuperString::ReferencerSet::length() const {
+    return this->_length;
+}
+
+std::size_t SuperString::ReferencerSet::cost() const {
+    return this->_cost;
+}
+
+std::size_t SuperString::ReferencerSet::slotCount() const {
+    return this->_capacity != 0 ? this->_capacity : this->_length;
+}
+
+SuperString::ReferenceStringSequence *SuperString::ReferencerSet::at(std::size_t slot) const {
+    return this->_capacity != 0 ? this->_table[slot]._sequence : this->_inline[slot]._sequence;
+}
+
+bool SuperString::ReferencerSet::contains(const ReferenceStringSequence *sequence) const {
+    if(this->_capacity == 0) {
+        for(std::size_t i = 0; i < this->_length; i++) {
+            if(this->_inline[i]._sequence == sequence) {
+                return true;
+            }
+        }
+        return false;
+    }
+    std::size_t mask = this->_capacity - 1;
+    for(std::size_t slot = this->home(sequence); this->_table[slot]._sequence != NULL; slot = (slot + 1) & mask) {
+        if(this->_table[slot]._sequence == sequence) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SuperString::ReferencerSet::add(ReferenceStringSequence *sequence, std::size_t cost) {
+    if(this->_capacity == 0 && this->_length < ReferencerSet::InlineCount) {
+        this->_inline[this->_length]._sequence = sequence;
+        this->_inline[this->_length]._cost = cost;
+    } else {
+        if(2 * (this->_length + 1) > this->_capacity) {
+            this->grow();
+        }
+        std::size_t mask = this->_capacity - 1;
+        std::size_t slot = this->home(sequence);
+        while(this->_table[slot]._sequence != NULL) {
+            slot = (slot + 1) & mask;
+        }
+        this->_table[slot]._sequence = sequence;
+        this->_table[slot]._cost = cost;
+    }
+    this->_length++;
+    this->_cost += cost;
+    SuperString::countUp(SuperString::_counters._referencerCount, 1);
+    SuperString::countUp(SuperString::_counters._freeingCost, cost);
+}
+
+void SuperString::ReferencerSet::remove(ReferenceStringSequence *sequence) {
+    if(this->_capacity == 0) {
+        for(std::size_t i = 0; i < this->_length; i++) {
+            if(this->_inline[i]._sequence == sequence) {
+                this->_cost -= this->_inline[i]._cost;
+                SuperString::countDown(SuperString::_counters._referencerCount, 1);
+                SuperString::countDown(SuperString::_counters._freeingCost, this->_inline[i]._cost);
+                this->_inline[i] = this->_inline[--this->_length];
+                return;
+            }
+        }
+        return;
+    }
+    std::size_t mask = this->_capacity - 1;
+    std::size_t slot = this->home(sequence);
+    while(this->_table[slot]._sequence != sequence) {
+        if(this->_table[slot]._sequence == NULL) {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    this->_cost -= this->_table[slot]._cost;
+    this->_length--;
+    SuperString::countDown(SuperString::_counters._referencerCount, 1);
+    SuperString::countDown(SuperString::_counters._freeingCost, this->_table[slot]._cost);
+    if(this->_length == 0) {
+        delete[] this->_table;
+        this->_capacity = 0;
+        return;
+    }
+    // shifts back the entries of the run that follows, so that no probe stops at the hole
+    std::size_t hole = slot;
+    for(std::size_t next = (hole + 1) & mask; this->_table[next]._sequence != NULL; next = (next + 1) & mask) {
+        std::size_t wanted = this->home(this->_table[next]._sequence);
+        if(((next - wanted) & mask) >= ((next - hole) & mask)) {
+            this->_table[hole] = this->_table[next];
+            hole = next;
+        }
+    }
+    this->_table[hole]._sequence = NULL;
+}
+
+void SuperString::ReferencerSet::refresh(const StringSequence *owner) {
+    std::size_t cost = 0;
+    Entry *entries = this->_capacity != 0 ? this->_table : this->_inline;
+    for(std::size_t i = 0, count = this->slotCount(); i < count; i++) {
+        if(entries[i]._sequence != NULL) {
+            entries[i]._cost = entries[i]._sequence->reconstructionCost(owner);
+            cost += entries[i]._cost;
+        }
+    }
+    SuperString::countDown(SuperString::_counters._freeingCost, this->_cost);
+    SuperString::countUp(SuperString::_counters._freeingCost, cost);
+    this->_cost = cost;
+}
+
+void SuperString::ReferencerSet::swap(SuperString::ReferencerSet &other) {
+    Entry entries[ReferencerSet::InlineCount];
+    std::copy_n(this->_inline, ReferencerSet::InlineCount, entries);
+    std::copy_n(other._inline, ReferencerSet::InlineCount, this->_inline);
+    std::copy_n(entries, ReferencerSet::InlineCount, other._inline);
+    std::swap(this->_capacity, other._capacity);
+    std::swap(this->_length, other._length);
+    std::swap(this->_cost, other._cost);
+}
+
+std::size_t SuperString::ReferencerSet::home(const ReferenceStringSequence *sequence) const {
+    std::size_t hash = ((std::size_t) sequence >> 4) * (std::size_t) 0x9e3779b97f4a7c15ULL;
+    return (hash ^ (hash >> (sizeof(std::size_t) * 4))) & (this->_capacity - 1);
+}
+
+void SuperString::ReferencerSet::grow() {
+    std::size_t count = this->slotCount();
+    Entry *entries = this->_capacity != 0 ? this->_table : this->_inline;
+    Entry moved[ReferencerSet::InlineCount];
+    if(this->_capacity == 0) {
+        // the inline entries share their storage with the table pointer
+        std::copy_n(this->_inline, count, moved);
+        entries = moved;
+    }
+    std::size_t capacity = this->_capacity != 0 ? 2 * this->_capacity : ReferencerSet::MinimumCapacity;
+    Entry *table = new Entry[capacity];
+    for(std::size_t i = 0; i < capacity; i++) {
+        table[i]._sequence = NULL;
+    }
+    bool isSpilled = this->_capacity != 0;
+    this->_table = table;
+    this->_capacity = capacity;
+    std::size_t mask = capacity - 1;
+    for(std::size_t i = 0; i < count; i++) {
+        if(entries[i]._sequence != NULL) {
+            std::size_t slot = this->home(entries[i]._sequence);
+            while(table[slot]._sequence != NULL) {
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = entries[i];
+        }
+    }
+    if(isSpilled) {
+        delete[] entries;
+    }
+}
+
+//*-- SuperString::OffsetIndex (internal)
+SuperString::OffsetIndex::OffsetIndex()
+        : _offsets(NULL) {
+    // nothing go here
+}
+
+SuperString::OffsetIndex::~OffsetIndex() {
+    delete[] this->_offsets;
+}
+
+std::size_t SuperString::OffsetIndex::memoryLength() const {
+    const std::size_t *offsets = this->_offsets;
+    if(offsets == NULL) {
+        return 0;
+    }
+    return (offsets[1] + 2) * sizeof(std::size_t);
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::OffsetIndex::offset(const StringSequence *owner, const Byte *bytes, SuperString::Encoding encoding,
+                                 std::size_t length, std::size_t index) {
+    const std::size_t *offsets = this->_offsets;
+    if(offsets == NULL) {
+        std::size_t stride = SuperString::offsetIndexStride();
+        if(stride != 0 && stride <= index && index <= length) {
+            std::size_t *built = OffsetIndex::build(bytes, encoding, length, stride);
+#ifdef SUPERSTRING_THREAD_SAFE
+            // threads racing to index the same sequence all build it, the first one publishes its index
+            std::size_t *expected = NULL;
+            if(this->_offsets.compare_exchange_strong(expected, built)) {
+                owner->keepingCostChanged();
+            } else {
+                delete[] built;
+            }
+            offsets = this->_offsets;
+#else
+            this->_offsets = built;
+            owner->keepingCostChanged();
+            offsets = built;
+#endif
+        }
+    }
+    std::size_t base = 0;
+    std::size_t baseOffset = 0;
+    if(offsets != NULL) {
+        std::size_t stride = offsets[0];
+        std::size_t sample = std::min(index / stride, offsets[1] - 1);
+        base = sample * stride;
+        baseOffset = offsets[2 + sample];
+    }
+    Result<std::size_t, Error> offset = (encoding == Encoding::UTF16BE)
+                                        ? SuperString::UTF16BE::offset(bytes + baseOffset, index - base)
+                                        : SuperString::UTF8::offset(bytes + baseOffset, index - base);
+    if(offset.isOk()) {
+        return Result<std::size_t, Error>(baseOffset + offset.ok());
+    }
+    return offset;
+}
+
+void SuperString::OffsetIndex::reset() {
+    std::size_t *offsets = this->_offsets;
+    this->_offsets = NULL;
+    delete[] offsets;
+}
+
+std::size_t *SuperString::OffsetIndex::build(const Byte *bytes, SuperString::Encoding encoding, std::size_t length,
+                                             std::size_t stride) {
+    std::size_t count = length / stride + 1;
+    std::size_t *offsets = new std::size_t[count + 2];
+    offsets[0] = stride;
+    offsets[1] = count;
+    const Byte *pointer = bytes;
+    for(std::size_t i = 0; i <= length; i++) {
+        if(i % stride == 0) {
+            offsets[2 + i / stride] = (std::size_t) (pointer - bytes);
+        }
+        if(i < length) {
+            pointer += (encoding == Encoding::UTF16BE) ? SuperString::UTF16BE::width(pointer)
+                                                       : SuperString::UTF8::width(pointer);
+        }
+    }
+    return offsets;
+}
+
+//*-- SuperString::HashIndex (internal)
+SuperString::HashIndex::HashIndex()
+        : _hashes(NULL) {
+    // nothing go here
+}
+
+SuperString::HashIndex::~HashIndex() {
+    delete[] this->_hashes;
+}
+
+std::size_t SuperString::HashIndex::memoryLength() const {
+    const std::uint64_t *hashes = this->_hashes;
+    if(hashes == NULL) {
+        return 0;
+    }
+    return (hashes[0] + 1) * sizeof(std::uint64_t);
+}
+
+std::uint64_t SuperString::HashIndex::hashOf(const StringSequence *owner, std::size_t startIndex,
+                                             std::size_t endIndex) {
+    const std::uint64_t *hashes = this->_hashes;
+    if(hashes == NULL) {
+        std::size_t length = owner->length();
+        std::size_t rangeLength = endIndex - startIndex;
+        if(rangeLength == length || rangeLength < 2 * Stride || rangeLength < length / 8) {
+            // scanning the range costs no more than looking it up would
+            return Hash::scan(owner, startIndex, endIndex);
+        }
+        std::uint64_t *built = HashIndex::build(owner);
+#ifdef SUPERSTRING_THREAD_SAFE
+        // threads racing to index the same sequence all build it, the first one publishes its index
+        std::uint64_t *expected = NULL;
+        if(this->_hashes.compare_exchange_strong(expected, built)) {
+            owner->keepingCostChanged();
+        } else {
+            delete[] built;
+        }
+        hashes = this->_hashes;
+#else
+        this->_hashes = built;
+        owner->keepingCostChanged();
+        hashes = built;
+#endif
+    }
+    return Hash::subtract(this->prefix(owner, hashes, endIndex),
+                          Hash::multiply(this->prefix(owner, hashes, startIndex), Hash::power(endIndex - startIndex)));
+}
+
+void SuperString::HashIndex::reset() {
+    std::uint64_t *hashes = this->_hashes;
+    this->_hashes = NULL;
+    delete[] hashes;
+}
+
+std::uint64_t SuperString::HashIndex::prefix(const StringSequence *owner, const std::uint64_t *hashes,
+                                             std::size_t index) const {
+    std::size_t sample = index / Stride;
+    Hash::State state = {hashes[1 + sample], sample * Stride, NULL};
+    if(state._index < index) {
+        owner->visitChunks(state._index, index, Hash::visit, &state);
+    }
+    return state._hash;
+}
+
+std::uint64_t *SuperString::HashIndex::build(const StringSequence *owner) {
+    std::size_t length = owner->length();
+    std::size_t count = length / Stride + 1;
+    std::uint64_t *hashes = new std::uint64_t[count + 1];
+    hashes[0] = count;
+    Hash::State state = {0, 0, hashes + 1};
+    owner->visitChunks(0, length, Hash::visit, &state);
+    if(length % Stride == 0) {
+        hashes[1 + length / Stride] = state._hash;
+    }
+    return hashes;
+}
+
+//*-- SuperString::StringSequence (abstract|internal)
+SuperString::StringSequence::StringSequence()
+        : _refCount(0), _retentionPolicy(NULL), _internPool(NULL), _hash(HashNotComputed) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    this->_referencersLock.clear();
+#else
+    this->_retainedCost = 0;
+#endif
+    SuperString::countUp(SuperString::_counters._sequenceCount, 1);
+}
+
+SuperString::StringSequence::~StringSequence() {
+    SuperString::countDown(SuperString::_counters._sequenceCount, 1);
+#ifndef SUPERSTRING_THREAD_SAFE
+    SuperString::countDown(SuperString::_counters._retainedBytes, this->_retainedCost);
+#endif
+}
+
+void *SuperString::StringSequence::operator new(std::size_t size) {
+    return NodeAllocator::allocate(size);
+}
+
+void SuperString::StringSequence::operator delete(void *pointer) {
+    NodeAllocator::release(pointer);
+}
+
+bool SuperString::StringSequence::isEmpty() const {
+    return this->length() == 0;
+}
+
+bool SuperString::StringSequence::isNotEmpty() const {
+    return this->length() > 0;
+}
+
+std::size_t SuperString::StringSequence::depth() const {
+    return 0;
+}
+
+std::size_t SuperString::StringSequence::packedWidth() const {
+    return sizeof(int);
+}
+
+bool SuperString::StringSequence::isBorrowed() const {
+    return false;
+}
+
+bool SuperString::StringSequence::isValid() const {
+    return true;
+}
+
+SuperString::Result<std::size_t, SuperString::Error> SuperString::StringSequence::indexOf(SuperString other) const {
+    std::size_t otherLength = other.length();
+    if(otherLength == 0) {
+        return Result<std::size_t, Error>(0);
+    }
+    if(this->length() < otherLength) {
+        return Result<std::size_t, Error>(Error::NotFound);
+    }
+    return this->_search(other, false);
+}
+
+SuperString::Result<std::size_t, SuperString::Error> SuperString::StringSequence::lastIndexOf(SuperString other) const {
+    std::size_t otherLength = other.length();
+    if(otherLength == 0) {
+        return Result<std::size_t, Error>(this->length());
+    }
+    if(this->length() < otherLength) {
+        return Result<std::size_t, Error>(Error::NotFound);
+    }
+    return this->_search(other, true);
+}
+
+void SuperString::StringSequence::refAdd() const {
+    StringSequence *self = (StringSequence *) (unsigned long) this;
+#ifdef SUPERSTRING_THREAD_SAFE
+    self->_refCount.fetch_add(1, std::memory_order_relaxed);
+#else
+    if(self->_retainedCost != 0) {
+        // held again, no longer retained
+        SuperString::countDown(SuperString::_counters._retainedBytes, self->_retainedCost);
+        self->_retainedCost = 0;
+    }
+    self->_refCount++;
+#endif
+}
+
+bool SuperString::StringSequence::refAddIfHeld() const {
+#ifdef SUPERSTRING_THREAD_SAFE
+    StringSequence *self = (StringSequence *) (unsigned long) this;
+    std::size_t count = self->_refCount.load();
+    while(count != 0 && count != (std::size_t) -1 && !self->_refCount.compare_exchange_weak(count, count + 1)) {
+        // [count] was reloaded, try again
+    }
+    return count != 0 && count != (std::size_t) -1;
+#else
+    this->refAdd();
+    return true;
+#endif
+}
+
+std::size_t SuperString::StringSequence::refRelease() const {
+    StringSequence *self = (StringSequence *) (unsigned long) this;
+#ifdef SUPERSTRING_THREAD_SAFE
+    std::size_t count = self->_refCount.load();
+    while(count != 0 && !self->_refCount.compare_exchange_weak(count, count - 1)) {
+        // [count] was reloaded, try again
+    }
+    return count == 0 ? 0 : count - 1;
+#else
+    if(self->_refCount == 0) {
+        return 0;
+    }
+    return --self->_refCount;
+#endif
+}
+
+std::size_t SuperString::StringSequence::refCount() const {
+    return this->_refCount;
+}
+
+void SuperString::StringSequence::release(bool isDeferrable) const {
+#ifdef SUPERSTRING_THREAD_SAFE
+    (void) isDeferrable; // nothing is deferred in the thread-safe build
+    this->lockReferencers();
+    bool isClaimed = this->refRelease() == 0 && this->claim();
+    this->unlockReferencers();
+    if(isClaimed) {
+        this->deleteClaimed();
+    }
+#else
+    if(this->refRelease() == 0) {
+        this->tryDelete(isDeferrable);
+    }
+#endif
+}
+
+void SuperString::StringSequence::dropReferencer(SuperString::ReferenceStringSequence *sequence) const {
+    this->refAdd();
+    this->removeReferencer(sequence);
+    this->release();
+}
+
+bool SuperString::StringSequence::isUnique() const {
+    this->lockReferencers();
+    bool isUnique = this->refCount() == 1 && this->_referencers.length() == 0 && this->_internPool == NULL;
+    this->unlockReferencers();
+    return isUnique;
+}
+
+bool SuperString::StringSequence::isOwnedBy(const ReferenceStringSequence *sequence) const {
+    this->lockReferencers();
+    bool isOwned = this->refCount() == 0 && this->_referencers.length() == 1 && this->_referencers.contains(sequence);
+    this->unlockReferencers();
+    return isOwned;
+}
+
+bool SuperString::StringSequence::append(const StringSequence * /*other*/) {
+    return false;
+}
+
+SuperString SuperString::StringSequence::compact(std::size_t threshold) const {
+    SuperString string((StringSequence *) ((std::size_t) this));
+    if(this->depth() == 0 || threshold < this->length()) {
+        return string;
+    }
+    std::size_t length = this->length();
+    Result<std::size_t, Error> size = string.copyTo(NULL, 0, length, Encoding::UTF8);
+    Result<SuperString, Error> flat = string.flatten(size.isOk() && size.ok() == length ? Encoding::ASCII
+                                                                                       : Encoding::UTF8);
+    // code units that UTF-8 cannot hold stay where they are
+    return flat.isOk() ? flat.ok() : string;
+}
+
+const SuperString::StringSequence *
+SuperString::StringSequence::slice(std::size_t startIndex, std::size_t endIndex) const {
+    if(startIndex == 0 && endIndex == this->length()) {
+        return this;
+    }
+    return new SubstringSequence(this, startIndex, endIndex);
+}
+
+std::uint64_t SuperString::StringSequence::hash() const {
+    std::uint64_t hash = this->_hash;
+    if(hash == HashNotComputed) {
+        StringSequence *self = ((StringSequence *) ((std::size_t) this)); // to keep this method `const`
+        std::size_t length = this->length();
+        hash = length == 0 ? 0 : this->hashOf(0, length);
+        self->_hash = hash;
+    }
+    return hash;
+}
+
+std::uint64_t SuperString::StringSequence::hash(std::size_t startIndex, std::size_t endIndex) const {
+    if(endIndex <= startIndex) {
+        return 0;
+    }
+    if(startIndex == 0 && endIndex == this->length()) {
+        return this->hash();
+    }
+    return this->hashOf(startIndex, endIndex);
+}
+
+std::uint64_t SuperString::StringSequence::hashOf(std::size_t startIndex, std::size_t endIndex) const {
+    StringSequence *self = ((StringSequence *) ((std::size_t) this)); // to keep this method `const`
+    return self->_hashIndex.hashOf(this, startIndex, endIndex);
+}
+
+void SuperString::StringSequence::hashChanged() {
+    this->_hash = HashNotComputed;
+    this->_hashIndex.reset();
+}
+
+void SuperString::StringSequence::discard(const StringSequence *sequence) {
+    sequence->lockReferencers();
+    bool isUnused = sequence->refCount() == 0 && sequence->_referencers.length() == 0;
+    sequence->unlockReferencers();
+    if(isUnused) {
+        sequence->tryDelete(false);
+    }
+}
+
+void SuperString::StringSequence::addReferencer(SuperString::ReferenceStringSequence *sequence) const {
+    StringSequence *self = (StringSequence *) (unsigned long) this;
+    this->lockReferencers();
+    self->_referencers.add(sequence, sequence->reconstructionCost(this));
+    this->unlockReferencers();
+}
+
+void SuperString::StringSequence::removeReferencer(SuperString::ReferenceStringSequence *sequence) const {
+    StringSequence *self = (StringSequence *) (unsigned long) this;
+    this->lockReferencers();
+    self->_referencers.remove(sequence);
+    this->unlockReferencers();
+}
+
+std::size_t SuperString::StringSequence::freeingCost() const {
+    this->lockReferencers();
+    std::size_t cost = this->_referencers.cost();
+    this->unlockReferencers();
+    return cost;
+}
+
+void SuperString::StringSequence::reconstructReferencers() {
+    // taken out first, `reconstruct` unlinks each referencer from a set that is empty by then
+    ReferencerSet referencers;
+    this->lockReferencers();
+    referencers.swap(this->_referencers);
+    this->unlockReferencers();
+    for(std::size_t i = 0, count = referencers.slotCount(); i < count; i++) {
+        ReferenceStringSequence *sequence = referencers.at(i);
+        if(sequence != NULL) {
+            sequence->reconstruct(this);
+        }
+    }
+}
+
+void SuperString::StringSequence::doDelete() const {
+    StringSequence *self = ((StringSequence *) (std::size_t) this);
+    if(!self->isToBeDeleted()) {
+        self->_refCount = (std::size_t) -1; // Just a trick, we don't want any more variable
+        if(self->_internPool != NULL) {
+            InternPool *pool = self->_internPool;
+            pool->remove(self);
+        }
+        delete self;
+    }
+}
+
+bool SuperString::StringSequence::isToBeDeleted() const {
+    return this->_refCount == (std::size_t) -1;
+}
+
+void SuperString::StringSequence::keepingCostChanged() const {
+    StringSequence *self = ((StringSequence *) (std::size_t) this);
+    // referencers lock their own set in turn, always from a sequence up to its referencers
+    this->lockReferencers();
+    self->_referencers.refresh(this);
+    for(std::size_t i = 0, count = this->_referencers.slotCount(); i < count; i++) {
+        ReferenceStringSequence *sequence = this->_referencers.at(i);
+        if(sequence != NULL) {
+            sequence->invalidateKeepingCost();
+        }
+    }
+    this->unlockReferencers();
+}
+
+void SuperString::StringSequence::reconstructionCostChanged() const {
+    StringSequence *self = ((StringSequence *) (std::size_t) this);
+    this->lockReferencers();
+    self->_referencers.refresh(this);
+    this->unlockReferencers();
+}
+
+void SuperString::StringSequence::tryDelete(bool isDeferrable) const {
+#ifdef SUPERSTRING_THREAD_SAFE
+    (void) isDeferrable; // nothing is deferred in the thread-safe build
+    this->lockReferencers();
+    bool isClaimed = this->claim();
+    this->unlockReferencers();
+    if(isClaimed) {
+        this->deleteClaimed();
+    }
+#else
+    if(this->refCount() == 0) {
+        StringSequence *self = ((StringSequence *) (std::size_t) this);
+        RetentionPolicy *policy = this->_retentionPolicy != NULL ? this->_retentionPolicy
+                                                                 : SuperString::_retentionPolicy;
+        std::size_t keepingCost = this->keepingCost();
+        // the retained bytes are counted without this sequence while deciding
+        SuperString::countDown(SuperString::_counters._retainedBytes, self->_retainedCost);
+        self->_retainedCost = 0;
+        if(this->_referencers.length() == 0) {
+            this->doDelete();
+        } else if(policy->isToBeFreed(keepingCost, this->freeingCost())) {
+            if(isDeferrable && SuperString::_isReconstructionDeferred) {
+                // held by the queue meanwhile
+                self->refAdd();
+                SuperString::_deferred.push_back(self);
+            } else {
+                this->doDelete();
+            }
+        } else {
+            self->_retainedCost = keepingCost;
+            SuperString::countUp(SuperString::_counters._retainedBytes, keepingCost);
+            SuperString::countUp(SuperString::_counters._retentionCount, 1);
+        }
+    }
+#endif
+}
+
+void SuperString::StringSequence::retentionPolicy(SuperString::RetentionPolicy *policy) {
+    this->_retentionPolicy = policy;
+}
+
+void SuperString::StringSequence::lockReferencers() const {
+#ifdef SUPERSTRING_THREAD_SAFE
+    StringSequence *self = ((StringSequence *) (std::size_t) this);
+    while(self->_referencersLock.test_and_set(std::memory_order_acquire)) {
+        // held for a few list operations at most
+    }
+#endif
+}
+
+void SuperString::StringSequence::unlockReferencers() const {
+#ifdef SUPERSTRING_THREAD_SAFE
+    StringSequence *self = ((StringSequence *) (std::size_t) this);
+    self->_referencersLock.clear(std::memory_order_release);
+#endif
+}
+
+#ifdef SUPERSTRING_THREAD_SAFE
+bool SuperString::StringSequence::claim() const {
+    StringSequence *self = ((StringSequence *) (std::size_t) this);
+    // swapping the count for the deletion mark lets a single thread delete the sequence, lookups in
+    // its intern pool take a reference only from a nonzero count and cannot revive it
+    std::size_t count = 0;
+    return self->_referencers.length() == 0 && self->_refCount.compare_exchange_strong(count, (std::size_t) -1);
+}
+
+void SuperString::StringSequence::deleteClaimed() const {
+    StringSequence *self = ((StringSequence *) (std::size_t) this);
+    InternPool *pool = self->_internPool;
+    if(pool != NULL) {
+        // lookups read the sequences of their shard under its lock
+        InternPool::Shard &shard = pool->shardOf(self->_hash);
+        InternPool::lock(shard);
+        pool->remove(self);
+        InternPool::unlock(shard);
+    }
+    delete self;
+}
+#endif
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::StringSequence::_search(SuperString other, bool isReverse) const {
+    std::size_t patternLength = 0;
+    Byte *pattern = StringSequence::_encode(other, Encoding::UTF8, patternLength);
+    std::size_t skips[256];
+    if(pattern != NULL) {
+        StringSequence::_skips(pattern, patternLength, true, skips);
+    }
+    // a flat 7-bit ASCII or UTF-8 buffer is searched in place, byte by byte, UTF-8 being self-synchronizing
+    Chunk chunk(NULL, 0, 0, Encoding::ASCII);
+    if(this->visitChunks(0, this->length(), StringSequence::_singleChunk, &chunk) && chunk.bytes() != NULL &&
+       (chunk.encoding() == Encoding::UTF8 || (chunk.encoding() == Encoding::ASCII &&
+                                               SuperString::ASCII::isSevenBit(chunk.bytes(), chunk.byteLength())))) {
+        Result<std::size_t, Error> result(Error::NotFound);
+        if(pattern != NULL) {
+            result = StringSequence::_searchBytes(chunk.bytes(), chunk.byteLength(), pattern, patternLength,
+                                                  isReverse, skips);
+        }
+        delete[] pattern;
+        return result;
+    }
+    if(pattern != NULL) {
+        Result<std::size_t, Error> result = this->_searchEncoded(other.length(), pattern, patternLength, isReverse,
+                                                                 skips);
+        delete[] pattern;
+        if(result.isOk() || result.err() != Error::Unencodable) {
+            return result;
+        }
+    }
+    return this->_searchCodeUnits(other, isReverse);
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::StringSequence::_searchEncoded(std::size_t otherLength, const SuperString::Byte *pattern,
+                                            std::size_t patternLength, bool isReverse,
+                                            const std::size_t *skips) const {
+    std::size_t candidates = this->length() - otherLength + 1;
+    std::size_t blockLength = otherLength < SearchBlockLength ? SearchBlockLength : otherLength;
+    std::size_t blockCount = (candidates + blockLength - 1) / blockLength;
+    // each block is copied out in UTF-8, that is a plain memcpy for UTF-8 and 7-bit ASCII leaves
+    Byte *text = new Byte[4 * (blockLength + otherLength - 1)];
+    Result<std::size_t, Error> result(Error::NotFound);
+    for(std::size_t block = 0; block < blockCount; block++) {
+        std::size_t startIndex = (isReverse ? blockCount - 1 - block : block) * blockLength;
+        std::size_t textLength = std::min(blockLength, candidates - startIndex) + otherLength - 1;
+        CopyContext context = {text, 0, Encoding::UTF8, Error::Unexpected};
+        if(!this->visitChunks(startIndex, startIndex + textLength, SuperString::copyVisitor, &context)) {
+            result = Result<std::size_t, Error>(context._error);
+            break;
+        }
+        Result<std::size_t, Error> index = StringSequence::_searchBytes(text, context._size, pattern, patternLength,
+                                                                        isReverse, skips);
+        if(index.isOk()) {
+            result = Result<std::size_t, Error>(startIndex + index.ok());
+            break;
+        }
+    }
+    delete[] text;
+    return result;
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::StringSequence::_searchCodeUnits(SuperString other, bool isReverse) const {
+    std::size_t otherLength = other.length();
+    int *pattern = new int[otherLength];
+    other.copyTo((Byte *) pattern, 0, otherLength, Encoding::UTF32);
+    std::size_t skips[256];
+    StringSequence::_skips(pattern, otherLength, isReverse, skips);
+    std::size_t candidates = this->length() - otherLength + 1;
+    std::size_t blockLength = otherLength < SearchBlockLength ? SearchBlockLength : otherLength;
+    std::size_t blockCount = (candidates + blockLength - 1) / blockLength;
+    int *codeUnits = new int[blockLength + otherLength - 1];
+    Result<std::size_t, Error> result(Error::NotFound);
+    for(std::size_t block = 0; block < blockCount; block++) {
+        std::size_t startIndex = (isReverse ? blockCount - 1 - block : block) * blockLength;
+        std::size_t textLength = std::min(blockLength, candidates - startIndex) + otherLength - 1;
+        this->_decode(startIndex, startIndex + textLength, codeUnits);
+        Result<std::size_t, Error> index = isReverse
+                                           ? StringSequence::_reverseHorspool(codeUnits, textLength, pattern,
+                                                                              otherLength, skips)
+                                           : StringSequence::_horspool(codeUnits, textLength, pattern, otherLength,
+                                                                       skips);
+        if(index.isOk()) {
+            result = Result<std::size_t, Error>(startIndex + index.ok());
+            break;
+        }
+    }
+    delete[] codeUnits;
+    delete[] pattern;
+    return result;
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::StringSequence::_searchBytes(const SuperString::Byte *text, std::size_t textLength,
+                                          const SuperString::Byte *pattern, std::size_t patternLength,
+                                          bool isReverse, const std::size_t *skips) {
+    Result<std::size_t, Error> offset = isReverse
+                                        ? StringSequence::_reverseHorspool(text, textLength, pattern, patternLength,
+                                                                           skips)
+                                        : StringSequence::_findBytes(text, textLength, pattern, patternLength);
+    if(offset.isErr()) {
+        return offset;
+    }
+    return Result<std::size_t, Error>(SuperString::UTF8::length(text, offset.ok()));
+}
+
+bool SuperString::StringSequence::_singleChunk(const SuperString::Chunk &chunk, void *context) {
+    Chunk *single = (Chunk *) context;
+    if(single->bytes() != NULL) {
+        *single = Chunk(NULL, 0, 0, Encoding::ASCII);
+        return false;
+    }
+    *single = chunk;
+    return true;
 }
 
-SuperString::StringSequence::~StringSequence() {
-    // nothing go here
+SuperString::Byte *SuperString::StringSequence::_encode(SuperString string, SuperString::Encoding encoding,
+                                                        std::size_t &byteLength) {
+    Result<std::size_t, Error> size = string.copyTo(NULL, 0, string.length(), encoding);
+    if(size.isErr()) {
+        return NULL;
+    }
+    Byte *bytes = new Byte[size.ok()];
+    string.copyTo(bytes, 0, string.length(), encoding);
+    byteLength = size.ok();
+    return bytes;
 }
 
-bool SuperString::StringSequence::isEmpty() const {
-    return this->length() == 0;
+void SuperString::StringSequence::_decode(std::size_t startIndex, std::size_t endIndex, int *codeUnits) const {
+    CopyContext context = {(Byte *) codeUnits, 0, Encoding::UTF32, Error::Unexpected};
+    this->visitChunks(startIndex, endIndex, SuperString::copyVisitor, &context);
 }
 
-bool SuperString::StringSequence::isNotEmpty() const {
-    return this->length() > 0;
+template<class T>
+void SuperString::StringSequence::_skips(const T *pattern, std::size_t patternLength, bool isReverse,
+                                         std::size_t *skips) {
+    // units sharing a low byte share the smallest of their shifts, which stays safe
+    std::fill_n(skips, 256, patternLength);
+    if(isReverse) {
+        for(std::size_t i = patternLength - 1; i > 0; i--) {
+            skips[pattern[i] & 0xff] = i;
+        }
+    } else {
+        for(std::size_t i = 0; i + 1 < patternLength; i++) {
+            skips[pattern[i] & 0xff] = patternLength - 1 - i;
+        }
+    }
 }
 
-SuperString::Result<std::size_t, SuperString::Error> SuperString::StringSequence::indexOf(SuperString other) const {
-    for(std::size_t i = 0, length = this->length(); i < (length - other.length()); i++) {
-        if(this->_substringMatches(i, other)) {
+template<class T>
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::StringSequence::_horspool(const T *text, std::size_t textLength, const T *pattern,
+                                       std::size_t patternLength, const std::size_t *skips) {
+    if(textLength < patternLength) {
+        return Result<std::size_t, Error>(Error::NotFound);
+    }
+    T last = pattern[patternLength - 1];
+    for(std::size_t i = 0; i + patternLength <= textLength;) {
+        T unit = text[i + patternLength - 1];
+        if(unit == last && std::equal(pattern, pattern + patternLength - 1, text + i)) {
             return Result<std::size_t, Error>(i);
         }
+        i += skips[unit & 0xff];
     }
     return Result<std::size_t, Error>(Error::NotFound);
 }
 
-SuperString::Result<std::size_t, SuperString::Error> SuperString::StringSequence::lastIndexOf(SuperString other) const {
-    for(std::size_t i = this->length() - other.length(); i > 0; i--) {
-        if(this->_substringMatches(i - 1, other)) {
+template<class T>
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::StringSequence::_reverseHorspool(const T *text, std::size_t textLength, const T *pattern,
+                                              std::size_t patternLength, const std::size_t *skips) {
+    if(textLength < patternLength) {
+        return Result<std::size_t, Error>(Error::NotFound);
+    }
+    T first = pattern[0];
+    for(std::size_t i = textLength - patternLength + 1; i > 0;) {
+        T unit = text[i - 1];
+        if(unit == first && std::equal(pattern + 1, pattern + patternLength, text + i)) {
             return Result<std::size_t, Error>(i - 1);
         }
+        i -= std::min(i, skips[unit & 0xff]);
     }
     return Result<std::size_t, Error>(Error::NotFound);
 }
 
-void SuperString::StringSequence::refAdd() const {
-    StringSequence *self = (StringSequence *) (unsigned long) this;
-    self->_refCount++;
-}
-
-std::size_t SuperString::StringSequence::refRelease() const {
-    StringSequence *self = (StringSequence *) (unsigned long) this;
-    if(self->_refCount == 0) {
-        return 0;
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::StringSequence::_findBytes(const SuperString::Byte *text, std::size_t textLength,
+                                        const SuperString::Byte *pattern, std::size_t patternLength) {
+    if(textLength < patternLength) {
+        return Result<std::size_t, Error>(Error::NotFound);
     }
-    return --self->_refCount;
+    const Byte *pointer = text;
+    const Byte *last = text + (textLength - patternLength);
+    while(pointer <= last) {
+        pointer = (const Byte *) std::memchr(pointer, pattern[0], last - pointer + 1);
+        if(pointer == NULL) {
+            break;
+        }
+        if(std::memcmp(pointer + 1, pattern + 1, patternLength - 1) == 0) {
+            return Result<std::size_t, Error>(pointer - text);
+        }
+        pointer++;
+    }
+    return Result<std::size_t, Error>(Error::NotFound);
 }
 
-std::size_t SuperString::StringSequence::refCount() const {
-    return this->_refCount;
-}
 
-void SuperString::StringSequence::addReferencer(SuperString::ReferenceStringSequence *sequence) const {
-    StringSequence *self = (StringSequence *) (unsigned long) this;
-    self->_referencers.push(sequence);
+//*-- SuperString::ReferenceStringSequence (abstract|internal)
+SuperString::ReferenceStringSequence::ReferenceStringSequence()
+        : _keepingCost(KeepingCostNotComputed) {
+    // nothing go here
 }
 
-void SuperString::StringSequence::removeReferencer(SuperString::ReferenceStringSequence *sequence) const {
-    StringSequence *self = (StringSequence *) (unsigned long) this;
-    self->_referencers.remove(sequence);
+SuperString::ReferenceStringSequence::~ReferenceStringSequence() {
+    // nothing go here
 }
 
-std::size_t SuperString::StringSequence::freeingCost() const {
-    std::size_t cost = 0;
-    SingleLinkedList<ReferenceStringSequence *>::Node<ReferenceStringSequence *> *node = this->_referencers._head;
-    while(node != NULL) {
-        cost += node->_data->reconstructionCost(this);
-        node = node->_next;
+void SuperString::ReferenceStringSequence::invalidateKeepingCost() const {
+    // a sequence whose cost is not computed has no referencer with a computed cost either
+    if(this->_keepingCost != KeepingCostNotComputed) {
+        ReferenceStringSequence *self = ((ReferenceStringSequence *) ((std::size_t) this));
+        self->_keepingCost = KeepingCostNotComputed;
+        self->keepingCostChanged();
+    }
+}
+
+SuperString::Byte *
+SuperString::ReferenceStringSequence::pack(const StringSequence *sequence, std::size_t startIndex,
+                                           std::size_t endIndex, SuperString::Encoding &encoding) {
+    // measured first: a byte per code unit in UTF-8 means ASCII, UTF-16BE refuses surrogates
+    std::size_t length = endIndex - startIndex;
+    CopyContext context = {NULL, 0, Encoding::UTF8, Error::Unexpected};
+    if(sequence->visitChunks(startIndex, endIndex, SuperString::copyVisitor, &context) && context._size == length) {
+        encoding = Encoding::ASCII;
+    } else {
+        context._size = 0;
+        context._encoding = Encoding::UTF16BE;
+        bool isNarrow = sequence->visitChunks(startIndex, endIndex, SuperString::copyVisitor, &context) &&
+                        context._size == 2 * length;
+        encoding = isNarrow ? Encoding::UTF16BE : Encoding::UTF32;
+    }
+    Byte *data = new Byte[length * ReferenceStringSequence::widthOf(encoding)];
+    context._buffer = data;
+    context._size = 0;
+    context._encoding = encoding;
+    sequence->visitChunks(startIndex, endIndex, SuperString::copyVisitor, &context);
+    SuperString::countUp(SuperString::_counters._reconstructionCount, 1);
+    SuperString::countUp(SuperString::_counters._reconstructedBytes,
+                         length * ReferenceStringSequence::widthOf(encoding));
+    return data;
+}
+
+std::size_t SuperString::ReferenceStringSequence::widthOf(SuperString::Encoding encoding) {
+    switch(encoding) {
+        case Encoding::ASCII:
+            return 1;
+        case Encoding::UTF16BE:
+            return 2;
+        default:
+            return sizeof(int);
     }
-    return cost;
 }
 
-void SuperString::StringSequence::reconstructReferencers() {
-    SingleLinkedList<ReferenceStringSequence *>::Node<ReferenceStringSequence *> *node = this->_referencers._head;
-    while(node != NULL) {
-        node->_data->reconstruct(this);
-        node = node->_next;
+int SuperString::ReferenceStringSequence::unpack(const SuperString::Byte *data, SuperString::Encoding encoding,
+                                                 std::size_t index) {
+    switch(encoding) {
+        case Encoding::ASCII:
+            return data[index];
+        case Encoding::UTF16BE:
+            return (data[2 * index] << 8) | data[2 * index + 1];
+        default:
+            return SuperString::UTF32::codeUnitAt(data, index);
     }
 }
 
-bool SuperString::StringSequence::_substringMatches(std::size_t startIndex,
-                                                                 SuperString other) const {
-    if(other.isEmpty()) {
+bool SuperString::ReferenceStringSequence::visitData(const SuperString::Byte *data, SuperString::Encoding encoding,
+                                                     std::size_t startIndex, std::size_t endIndex,
+                                                     SuperString::ChunkVisitor visitor, void *context) {
+    if(endIndex <= startIndex) {
         return true;
     }
-    std::size_t length = other.length();
-    if(startIndex + length > this->length()) {
-        return false;
-    }
-    for(int i = 0; i < length; i++) {
-        if(this->codeUnitAt(i + startIndex).ok() != other.codeUnitAt(i).ok()) {
-            return false;
-        }
-    }
-    return true;
+    std::size_t width = ReferenceStringSequence::widthOf(encoding);
+    std::size_t length = endIndex - startIndex;
+    return visitor(Chunk(data + startIndex * width, length * width, length, encoding), context);
 }
 
-//*-- SuperString::ReferenceStringSequence (abstract|internal)
-SuperString::ReferenceStringSequence::~ReferenceStringSequence() {
-    // nothing go here
+void SuperString::ReferenceStringSequence::printData(std::ostream &stream, const SuperString::Byte *data,
+                                                     SuperString::Encoding encoding, std::size_t startIndex,
+                                                     std::size_t endIndex) {
+    switch(encoding) {
+        case Encoding::ASCII:
+            SuperString::ASCII::print(stream, data, startIndex, endIndex);
+            break;
+        case Encoding::UTF16BE:
+            // without surrogates every code unit is a single pair of bytes
+            for(std::size_t i = startIndex; i < endIndex; i++) {
+                Byte bytes[4];
+                std::size_t width = SuperString::UTF8::encode(ReferenceStringSequence::unpack(data, encoding, i), bytes);
+                stream.write((const char *) bytes, width);
+            }
+            break;
+        default:
+            SuperString::UTF32::print(stream, data, startIndex, endIndex);
+            break;
+    }
 }
 
 //*-- SuperString::ConstASCIISequence (internal)
 SuperString::ConstASCIISequence::ConstASCIISequence(const Byte *bytes)
         : _bytes(bytes),
           _status(SuperString::ConstASCIISequence::Status::LengthNotComputed) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    this->length(); // measured up front, a sequence shared between threads is never written to
+#else
     // nothing go here
+#endif
 }
 
 SuperString::ConstASCIISequence::~ConstASCIISequence() {
@@ -356,6 +2981,14 @@ std::size_t SuperString::ConstASCIISequence::length() const /*override*/ {
     return this->_length;
 }
 
+bool SuperString::ConstASCIISequence::isBorrowed() const /*override*/ {
+    return true;
+}
+
+std::size_t SuperString::ConstASCIISequence::packedWidth() const /*override*/ {
+    return 1;
+}
+
 SuperString::Result<int, SuperString::Error>
 SuperString::ConstASCIISequence::codeUnitAt(std::size_t index) const {
     if(index < this->length()) {
@@ -364,6 +2997,26 @@ SuperString::ConstASCIISequence::codeUnitAt(std::size_t index) const {
     return Result<int, SuperString::Error>(Error::RangeError);
 }
 
+bool SuperString::ConstASCIISequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        cursor._bytes = this->_bytes + index;
+        cursor._encoding = Encoding::ASCII;
+        cursor._startIndex = 0;
+        cursor._endIndex = this->length();
+        return true;
+    }
+    return false;
+}
+
+bool SuperString::ConstASCIISequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                  SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    std::size_t length = endIndex - startIndex;
+    return visitor(Chunk(this->_bytes + startIndex, length, length, Encoding::ASCII), context);
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::ConstASCIISequence::substring(std::size_t startIndex,
                                            std::size_t endIndex) const {
@@ -403,43 +3056,44 @@ SuperString SuperString::ConstASCIISequence::trimRight() const {
 }
 
 std::size_t SuperString::ConstASCIISequence::keepingCost() const {
-    return sizeof(ConstASCIISequence);
-}
-
-void SuperString::ConstASCIISequence::doDelete() const {
-    ConstASCIISequence *self = ((ConstASCIISequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_status = Status::ToBeDestructed; // Just a trick, we don't want any more variable
-        delete self;
-    }
-}
-
-bool SuperString::ConstASCIISequence::isToBeDeleted() const {
-    return this->_status == Status::ToBeDestructed;
+    return sizeof(ConstASCIISequence) + this->_hashIndex.memoryLength();
 }
 
 //*-- SuperString::CopyASCIISequence (internal)
 SuperString::CopyASCIISequence::CopyASCIISequence(const SuperString::Byte *bytes) {
     this->_length = SuperString::ASCII::length(bytes);
+    this->_capacity = this->_length + 1;
     this->_data = new Byte[this->_length + 1];
     std::copy_n(bytes, this->_length + 1, this->_data);
 }
 
 SuperString::CopyASCIISequence::CopyASCIISequence(const SuperString::ConstASCIISequence *sequence) {
     this->_length = sequence->length();
+    this->_capacity = this->_length + 1;
     this->_data = new Byte[this->_length + 1];
     std::copy_n(sequence->_bytes, this->_length + 1, this->_data);
 }
 
+SuperString::CopyASCIISequence::CopyASCIISequence(SuperString::Byte *data, std::size_t length, std::size_t capacity)
+        : _data(data),
+          _length(length),
+          _capacity(capacity) {
+    // nothing go here
+}
+
 SuperString::CopyASCIISequence::~CopyASCIISequence() {
     this->reconstructReferencers();
-    delete this->_data;
+    delete[] this->_data;
 }
 
 std::size_t SuperString::CopyASCIISequence::length() const {
     return this->_length;
 }
 
+std::size_t SuperString::CopyASCIISequence::packedWidth() const /*override*/ {
+    return 1;
+}
+
 SuperString::Result<int, SuperString::Error> SuperString::CopyASCIISequence::codeUnitAt(
         std::size_t index) const {
     if(index < this->length()) {
@@ -448,6 +3102,26 @@ SuperString::Result<int, SuperString::Error> SuperString::CopyASCIISequence::cod
     return Result<int, SuperString::Error>(Error::RangeError);
 }
 
+bool SuperString::CopyASCIISequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        cursor._bytes = this->_data + index;
+        cursor._encoding = Encoding::ASCII;
+        cursor._startIndex = 0;
+        cursor._endIndex = this->length();
+        return true;
+    }
+    return false;
+}
+
+bool SuperString::CopyASCIISequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                 SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    std::size_t length = endIndex - startIndex;
+    return visitor(Chunk(this->_data + startIndex, length, length, Encoding::ASCII), context);
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::CopyASCIISequence::substring(std::size_t startIndex,
                                           std::size_t endIndex) const {
@@ -486,31 +3160,54 @@ SuperString SuperString::CopyASCIISequence::trimRight() const {
     return this->substring(0, SuperString::ASCII::trimRight(this->_data, this->length())).ok();
 }
 
-std::size_t SuperString::CopyASCIISequence::keepingCost() const {
-    std::size_t cost = sizeof(CopyASCIISequence);
-    if(this->_data != NULL) {
-        cost += this->length() + 1;
+bool SuperString::CopyASCIISequence::append(const StringSequence *other) {
+    // measured as UTF-8, [other] fits in ASCII if it takes a byte per code unit
+    std::size_t length = other->length();
+    CopyContext context = {NULL, 0, Encoding::UTF8, Error::Unexpected};
+    if(!other->visitChunks(0, length, SuperString::copyVisitor, &context) || context._size != length) {
+        return false;
     }
-    return cost;
-}
-
-void SuperString::CopyASCIISequence::doDelete() const {
-    CopyASCIISequence *self = ((CopyASCIISequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_length = 0; // Just a trick, we don't want any more variable
-        delete self;
+    if(this->_capacity < this->_length + length + 1) {
+        std::size_t capacity = std::max(this->_length + length + 1, 2 * this->_capacity);
+        Byte *data = new Byte[capacity];
+        std::copy_n(this->_data, this->_length, data);
+        delete[] this->_data;
+        this->_data = data;
+        this->_capacity = capacity;
+    }
+    Byte *end = this->_data + this->_length;
+    context._buffer = end;
+    context._size = 0;
+    other->visitChunks(0, length, SuperString::copyVisitor, &context);
+    if(std::memchr(end, 0x00, length) != NULL) {
+        // NUL terminates the copy, keep it out
+        *end = 0x00;
+        return false;
     }
+    end[length] = 0x00;
+    this->_length += length;
+    this->hashChanged();
+    this->keepingCostChanged();
+    return true;
 }
 
-bool SuperString::CopyASCIISequence::isToBeDeleted() const {
-    return this->_length == 0;
+std::size_t SuperString::CopyASCIISequence::keepingCost() const {
+    std::size_t cost = sizeof(CopyASCIISequence) + this->_hashIndex.memoryLength();
+    if(this->_data != NULL) {
+        cost += this->_capacity;
+    }
+    return cost;
 }
 
 //*-- SuperString::ConstUTF8Sequence (internal)
 SuperString::ConstUTF8Sequence::ConstUTF8Sequence(const Byte *bytes)
         : _bytes(bytes),
           _status(SuperString::ConstUTF8Sequence::Status::LengthNotComputed) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    this->length(); // measured up front, a sequence shared between threads is never written to
+#else
     // nothing go here
+#endif
 }
 
 SuperString::ConstUTF8Sequence::~ConstUTF8Sequence() {
@@ -520,14 +3217,65 @@ SuperString::ConstUTF8Sequence::~ConstUTF8Sequence() {
 std::size_t SuperString::ConstUTF8Sequence::length() const /*override*/ {
     if(this->_status == Status::LengthNotComputed) {
         ConstUTF8Sequence *self = ((ConstUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
-        self->_status = Status::LengthComputed;
-        self->_length = SuperString::UTF8::length(this->_bytes);
+        Result<std::size_t, Error> length = SuperString::UTF8::length(this->_bytes);
+        self->_status = length.isOk() ? Status::LengthComputed : Status::Invalid;
+        self->_length = length.isOk() ? length.ok() : 0;
     }
     return this->_length;
 }
 
+bool SuperString::ConstUTF8Sequence::isBorrowed() const /*override*/ {
+    return true;
+}
+
+bool SuperString::ConstUTF8Sequence::isValid() const /*override*/ {
+    this->length();
+    return this->_status != Status::Invalid;
+}
+
 SuperString::Result<int, SuperString::Error> SuperString::ConstUTF8Sequence::codeUnitAt(std::size_t index) const {
-    return SuperString::UTF8::codeUnitAt(this->_bytes, index);
+    if(index < this->length()) {
+        ConstUTF8Sequence *self = ((ConstUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF8,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            return Result<int, Error>(SuperString::UTF8::decode(this->_bytes + offset.ok()));
+        }
+        return Result<int, Error>(offset.err());
+    }
+    return Result<int, Error>(this->_status == Status::Invalid ? Error::InvalidByteSequence : Error::RangeError);
+}
+
+bool SuperString::ConstUTF8Sequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        ConstUTF8Sequence *self = ((ConstUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF8,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            cursor._bytes = this->_bytes + offset.ok();
+            cursor._encoding = Encoding::UTF8;
+            cursor._startIndex = 0;
+            cursor._endIndex = this->length();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SuperString::ConstUTF8Sequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                 SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    ConstUTF8Sequence *self = ((ConstUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF8,
+                                                                  this->_length, startIndex);
+    if(offset.isErr()) {
+        return false;
+    }
+    const Byte *bytes = this->_bytes + offset.ok();
+    std::size_t byteLength = SuperString::UTF8::offset(bytes, endIndex - startIndex).ok();
+    return visitor(Chunk(bytes, byteLength, endIndex - startIndex, Encoding::UTF8), context);
 }
 
 SuperString::Result<SuperString, SuperString::Error>
@@ -535,6 +3283,9 @@ SuperString::ConstUTF8Sequence::substring(std::size_t startIndex,
                                           std::size_t endIndex) const {
     // TODO: General code, specify + repeated * times
     std::size_t length = this->length();
+    if(this->_status == Status::Invalid) {
+        return Result<SuperString, Error>(Error::InvalidByteSequence);
+    }
     if(length < startIndex || length < endIndex) {
         return Result<SuperString, Error>(Error::RangeError);
     }
@@ -553,7 +3304,15 @@ bool SuperString::ConstUTF8Sequence::print(std::ostream &stream, std::size_t sta
     if(length < startIndex || length < endIndex) {
         return false;
     }
-    SuperString::UTF8::print(stream, this->_bytes, startIndex, endIndex);
+    ConstUTF8Sequence *self = ((ConstUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> startOffset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF8,
+                                                                       length, startIndex);
+    Result<std::size_t, Error> endOffset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF8,
+                                                                     length, endIndex);
+    if(startOffset.isErr() || endOffset.isErr()) {
+        return false;
+    }
+    stream.write((const char *) (this->_bytes + startOffset.ok()), endOffset.ok() - startOffset.ok());
     return true;
 }
 
@@ -593,57 +3352,118 @@ SuperString SuperString::ConstUTF8Sequence::trimRight() const {
 }
 
 std::size_t SuperString::ConstUTF8Sequence::keepingCost() const {
-    return sizeof(ConstUTF8Sequence);
-}
-
-void SuperString::ConstUTF8Sequence::doDelete() const {
-    ConstUTF8Sequence *self = ((ConstUTF8Sequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_status = Status::ToBeDestructed; // Just a trick, we don't want any more variable
-        delete self;
-    }
-}
-
-bool SuperString::ConstUTF8Sequence::isToBeDeleted() const {
-    return this->_status == Status::ToBeDestructed;
+    return sizeof(ConstUTF8Sequence) + this->_offsetIndex.memoryLength() + this->_hashIndex.memoryLength();
 }
 
 //*-- SuperString::CopyUTF8Sequence (internal)
 SuperString::CopyUTF8Sequence::CopyUTF8Sequence(const SuperString::Byte *bytes) {
-    Pair<std::size_t, std::size_t> lengthAndMemoryLength = SuperString::UTF8::lengthAndMemoryLength(bytes);
-    this->_length = lengthAndMemoryLength.first();
-    this->_memoryLength = lengthAndMemoryLength.second();
+    Result<Pair<std::size_t, std::size_t>, Error> lengthAndMemoryLength =
+            SuperString::UTF8::lengthAndMemoryLength(bytes);
+    // ill-formed input is kept as an empty string
+    this->_isValid = lengthAndMemoryLength.isOk();
+    this->_length = this->_isValid ? lengthAndMemoryLength.ok().first() : 0;
+    this->_memoryLength = this->_isValid ? lengthAndMemoryLength.ok().second() : 1;
+    this->_capacity = this->_memoryLength;
     this->_data = new Byte[this->_memoryLength];
-    std::copy_n(bytes, this->_memoryLength, this->_data);
+    std::copy_n(bytes, this->_memoryLength - 1, this->_data);
+    this->_data[this->_memoryLength - 1] = 0x00;
 }
 
 SuperString::CopyUTF8Sequence::CopyUTF8Sequence(const SuperString::ConstUTF8Sequence *sequence) {
-    Pair<std::size_t, std::size_t> lengthAndMemoryLength = SuperString::UTF8::lengthAndMemoryLength(sequence->_bytes);
-    this->_length = lengthAndMemoryLength.first();
-    this->_memoryLength = lengthAndMemoryLength.second();
+    Result<Pair<std::size_t, std::size_t>, Error> lengthAndMemoryLength =
+            SuperString::UTF8::lengthAndMemoryLength(sequence->_bytes);
+    // ill-formed input is kept as an empty string
+    this->_isValid = lengthAndMemoryLength.isOk();
+    this->_length = this->_isValid ? lengthAndMemoryLength.ok().first() : 0;
+    this->_memoryLength = this->_isValid ? lengthAndMemoryLength.ok().second() : 1;
+    this->_capacity = this->_memoryLength;
     this->_data = new Byte[this->_memoryLength];
-    std::copy_n(sequence->_bytes, this->_memoryLength, this->_data);
+    std::copy_n(sequence->_bytes, this->_memoryLength - 1, this->_data);
+    this->_data[this->_memoryLength - 1] = 0x00;
+}
+
+SuperString::CopyUTF8Sequence::CopyUTF8Sequence(SuperString::Byte *data, std::size_t length,
+                                                std::size_t memoryLength, std::size_t capacity)
+        : _data(data),
+          _length(length),
+          _memoryLength(memoryLength),
+          _capacity(capacity),
+          _isValid(true) {
+    // nothing go here
 }
 
 SuperString::CopyUTF8Sequence::~CopyUTF8Sequence() {
     this->reconstructReferencers();
-    delete this->_data;
+    delete[] this->_data;
 }
 
 std::size_t SuperString::CopyUTF8Sequence::length() const {
     return this->_length;
 }
 
+std::size_t SuperString::CopyUTF8Sequence::packedWidth() const /*override*/ {
+    // only ASCII takes a byte per code unit, anything else may need up to four
+    return this->_memoryLength - 1 == this->_length ? 1 : sizeof(int);
+}
+
+bool SuperString::CopyUTF8Sequence::isValid() const /*override*/ {
+    return this->_isValid;
+}
+
 SuperString::Result<int, SuperString::Error> SuperString::CopyUTF8Sequence::codeUnitAt(std::size_t index) const {
     if(index < this->length()) {
-        return Result<int, Error>(SuperString::UTF8::codeUnitAt(this->_data, index));
+        CopyUTF8Sequence *self = ((CopyUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF8,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            return Result<int, Error>(SuperString::UTF8::decode(this->_data + offset.ok()));
+        }
+        return Result<int, Error>(offset.err());
     }
-    return Result<int, SuperString::Error>(Error::RangeError);
+    return Result<int, SuperString::Error>(this->_isValid ? Error::RangeError : Error::InvalidByteSequence);
+}
+
+bool SuperString::CopyUTF8Sequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        CopyUTF8Sequence *self = ((CopyUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF8,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            cursor._bytes = this->_data + offset.ok();
+            cursor._encoding = Encoding::UTF8;
+            cursor._startIndex = 0;
+            cursor._endIndex = this->length();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SuperString::CopyUTF8Sequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    CopyUTF8Sequence *self = ((CopyUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF8,
+                                                                  this->_length, startIndex);
+    if(offset.isErr()) {
+        return false;
+    }
+    const Byte *bytes = this->_data + offset.ok();
+    // the byte length of a suffix is known from the terminator, do not walk it
+    std::size_t byteLength = (endIndex == this->_length)
+                             ? this->_memoryLength - 1 - offset.ok()
+                             : SuperString::UTF8::offset(bytes, endIndex - startIndex).ok();
+    return visitor(Chunk(bytes, byteLength, endIndex - startIndex, Encoding::UTF8), context);
 }
 
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::CopyUTF8Sequence::substring(std::size_t startIndex, std::size_t endIndex) const {
     // TODO: General code, specify + repeated * times
+    if(!this->_isValid) {
+        return Result<SuperString, Error>(Error::InvalidByteSequence);
+    }
     if(this->length() < startIndex || this->length() < endIndex) {
         return Result<SuperString, Error>(Error::RangeError);
     }
@@ -662,7 +3482,15 @@ bool SuperString::CopyUTF8Sequence::print(std::ostream &stream, std::size_t star
     if(length < startIndex || length < endIndex) {
         return false;
     }
-    SuperString::UTF8::print(stream, this->_data, startIndex, endIndex);
+    CopyUTF8Sequence *self = ((CopyUTF8Sequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> startOffset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF8,
+                                                                       length, startIndex);
+    Result<std::size_t, Error> endOffset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF8,
+                                                                     length, endIndex);
+    if(startOffset.isErr() || endOffset.isErr()) {
+        return false;
+    }
+    stream.write((const char *) (this->_data + startOffset.ok()), endOffset.ok() - startOffset.ok());
     return true;
 }
 
@@ -701,28 +3529,57 @@ SuperString SuperString::CopyUTF8Sequence::trimRight() const {
     return this->substring(0, endIndex).ok();
 }
 
-std::size_t SuperString::CopyUTF8Sequence::keepingCost() const {
-    std::size_t cost = sizeof(CopyUTF8Sequence) + this->_memoryLength;
-    return cost;
-}
-
-void SuperString::CopyUTF8Sequence::doDelete() const {
-    CopyUTF8Sequence *self = ((CopyUTF8Sequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_length = 0; // Just a trick, we don't want any more variable
-        delete self;
+bool SuperString::CopyUTF8Sequence::append(const StringSequence *other) {
+    if(!this->_isValid) {
+        return false;
+    }
+    std::size_t length = other->length();
+    CopyContext context = {NULL, 0, Encoding::UTF8, Error::Unexpected};
+    if(!other->visitChunks(0, length, SuperString::copyVisitor, &context)) {
+        return false;
+    }
+    std::size_t size = context._size;
+    if(this->_capacity < this->_memoryLength + size) {
+        std::size_t capacity = std::max(this->_memoryLength + size, 2 * this->_capacity);
+        Byte *data = new Byte[capacity];
+        std::copy_n(this->_data, this->_memoryLength - 1, data);
+        delete[] this->_data;
+        this->_data = data;
+        this->_capacity = capacity;
+    }
+    Byte *end = this->_data + this->_memoryLength - 1;
+    context._buffer = end;
+    context._size = 0;
+    other->visitChunks(0, length, SuperString::copyVisitor, &context);
+    if(std::memchr(end, 0x00, size) != NULL) {
+        // NUL terminates the copy, keep it out
+        *end = 0x00;
+        return false;
     }
+    end[size] = 0x00;
+    this->_length += length;
+    this->_memoryLength += size;
+    this->_offsetIndex.reset();
+    this->hashChanged();
+    this->keepingCostChanged();
+    return true;
 }
 
-bool SuperString::CopyUTF8Sequence::isToBeDeleted() const {
-    return this->_length == 0;
+std::size_t SuperString::CopyUTF8Sequence::keepingCost() const {
+    std::size_t cost = sizeof(CopyUTF8Sequence) + this->_capacity + this->_offsetIndex.memoryLength() +
+                       this->_hashIndex.memoryLength();
+    return cost;
 }
 
 //*-- ConstUTF16BESequence (internal)
 SuperString::ConstUTF16BESequence::ConstUTF16BESequence(const SuperString::Byte *bytes)
         : _bytes(bytes),
           _status(SuperString::ConstUTF16BESequence::Status::LengthNotComputed) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    this->length(); // measured up front, a sequence shared between threads is never written to
+#else
     // nothing go here
+#endif
 }
 
 SuperString::ConstUTF16BESequence::~ConstUTF16BESequence() {
@@ -738,14 +3595,56 @@ std::size_t SuperString::ConstUTF16BESequence::length() const /*override*/ {
     return this->_length;
 }
 
+bool SuperString::ConstUTF16BESequence::isBorrowed() const /*override*/ {
+    return true;
+}
+
 SuperString::Result<int, SuperString::Error> SuperString::ConstUTF16BESequence::codeUnitAt(
         std::size_t index) const {
     if(index < this->length()) {
-        return SuperString::UTF16BE::codeUnitAt(this->_bytes, index);
+        ConstUTF16BESequence *self = ((ConstUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF16BE,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            return Result<int, Error>(SuperString::UTF16BE::decode(this->_bytes + offset.ok()));
+        }
+        return Result<int, Error>(offset.err());
     }
     return Result<int, SuperString::Error>(Error::RangeError);
 }
 
+bool SuperString::ConstUTF16BESequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        ConstUTF16BESequence *self = ((ConstUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF16BE,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            cursor._bytes = this->_bytes + offset.ok();
+            cursor._encoding = Encoding::UTF16BE;
+            cursor._startIndex = 0;
+            cursor._endIndex = this->length();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SuperString::ConstUTF16BESequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                    SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    ConstUTF16BESequence *self = ((ConstUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF16BE,
+                                                                  this->_length, startIndex);
+    if(offset.isErr()) {
+        return false;
+    }
+    const Byte *bytes = this->_bytes + offset.ok();
+    std::size_t byteLength = SuperString::UTF16BE::offset(bytes, endIndex - startIndex).ok();
+    return visitor(Chunk(bytes, byteLength, endIndex - startIndex, Encoding::UTF16BE), context);
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::ConstUTF16BESequence::substring(std::size_t startIndex,
                                              std::size_t endIndex) const {
@@ -768,7 +3667,13 @@ bool SuperString::ConstUTF16BESequence::print(std::ostream &stream, std::size_t
     if(length < startIndex || length < endIndex) {
         return false;
     }
-    SuperString::UTF16BE::print(stream, this->_bytes, startIndex, endIndex);
+    ConstUTF16BESequence *self = ((ConstUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> startOffset = self->_offsetIndex.offset(self, this->_bytes, Encoding::UTF16BE,
+                                                                       length, startIndex);
+    if(startOffset.isErr()) {
+        return false;
+    }
+    SuperString::UTF16BE::print(stream, this->_bytes + startOffset.ok(), 0, endIndex - startIndex);
     return true;
 }
 
@@ -808,19 +3713,7 @@ SuperString SuperString::ConstUTF16BESequence::trimRight() const {
 }
 
 std::size_t SuperString::ConstUTF16BESequence::keepingCost() const {
-    return sizeof(ConstUTF16BESequence);
-}
-
-void SuperString::ConstUTF16BESequence::doDelete() const {
-    ConstUTF16BESequence *self = ((ConstUTF16BESequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_status = Status::ToBeDestructed; // Just a trick, we don't want any more variable
-        delete self;
-    }
-}
-
-bool SuperString::ConstUTF16BESequence::isToBeDeleted() const {
-    return this->_status == Status::ToBeDestructed;
+    return sizeof(ConstUTF16BESequence) + this->_offsetIndex.memoryLength() + this->_hashIndex.memoryLength();
 }
 
 //*-- SuperString::CopyUTF16BESequence (internal)
@@ -840,9 +3733,15 @@ SuperString::CopyUTF16BESequence::CopyUTF16BESequence(const SuperString::ConstUT
     std::copy_n(sequence->_bytes, this->_memoryLength, this->_data);
 }
 
+SuperString::CopyUTF16BESequence::CopyUTF16BESequence(SuperString::Byte *data, std::size_t length,
+                                                      std::size_t memoryLength)
+        : _data(data), _length(length), _memoryLength(memoryLength) {
+    // nothing go here
+}
+
 SuperString::CopyUTF16BESequence::~CopyUTF16BESequence() {
     this->reconstructReferencers();
-    delete this->_data;
+    delete[] this->_data;
 }
 
 std::size_t SuperString::CopyUTF16BESequence::length() const {
@@ -852,11 +3751,52 @@ std::size_t SuperString::CopyUTF16BESequence::length() const {
 SuperString::Result<int, SuperString::Error>
 SuperString::CopyUTF16BESequence::codeUnitAt(std::size_t index) const {
     if(index < this->length()) {
-        return SuperString::UTF16BE::codeUnitAt(this->_data, index);
+        CopyUTF16BESequence *self = ((CopyUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF16BE,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            return Result<int, Error>(SuperString::UTF16BE::decode(this->_data + offset.ok()));
+        }
+        return Result<int, Error>(offset.err());
     }
     return Result<int, SuperString::Error>(Error::RangeError);
 }
 
+bool SuperString::CopyUTF16BESequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        CopyUTF16BESequence *self = ((CopyUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+        Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF16BE,
+                                                                      this->_length, index);
+        if(offset.isOk()) {
+            cursor._bytes = this->_data + offset.ok();
+            cursor._encoding = Encoding::UTF16BE;
+            cursor._startIndex = 0;
+            cursor._endIndex = this->length();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SuperString::CopyUTF16BESequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                   SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    CopyUTF16BESequence *self = ((CopyUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> offset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF16BE,
+                                                                  this->_length, startIndex);
+    if(offset.isErr()) {
+        return false;
+    }
+    const Byte *bytes = this->_data + offset.ok();
+    // the byte length of a suffix is known from the terminator, do not walk it
+    std::size_t byteLength = (endIndex == this->_length)
+                             ? this->_memoryLength - 2 - offset.ok()
+                             : SuperString::UTF16BE::offset(bytes, endIndex - startIndex).ok();
+    return visitor(Chunk(bytes, byteLength, endIndex - startIndex, Encoding::UTF16BE), context);
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::CopyUTF16BESequence::substring(std::size_t startIndex, std::size_t endIndex) const {
     // TODO: General code, specify + repeated * times
@@ -878,7 +3818,13 @@ bool SuperString::CopyUTF16BESequence::print(std::ostream &stream, std::size_t s
     if(length < startIndex || length < endIndex) {
         return false;
     }
-    SuperString::UTF16BE::print(stream, this->_data, startIndex, endIndex);
+    CopyUTF16BESequence *self = ((CopyUTF16BESequence *) ((std::size_t) this)); // to keep this method `const`
+    Result<std::size_t, Error> startOffset = self->_offsetIndex.offset(self, this->_data, Encoding::UTF16BE,
+                                                                       length, startIndex);
+    if(startOffset.isErr()) {
+        return false;
+    }
+    SuperString::UTF16BE::print(stream, this->_data + startOffset.ok(), 0, endIndex - startIndex);
     return true;
 }
 
@@ -912,33 +3858,26 @@ SuperString SuperString::CopyUTF16BESequence::trimRight() const {
     std::size_t endIndex = this->length();
     Result<int, Error> result = this->codeUnitAt(endIndex - 1);
     while(result.isOk() && SuperString::isWhiteSpace(result.ok())) {
-        result = this->codeUnitAt(--endIndex - 1);
-    }
-    return this->substring(0, endIndex).ok();
-}
-
-std::size_t SuperString::CopyUTF16BESequence::keepingCost() const {
-    std::size_t cost = sizeof(CopyUTF16BESequence) + this->_memoryLength;
-    return cost;
-}
-
-void SuperString::CopyUTF16BESequence::doDelete() const {
-    CopyUTF16BESequence *self = ((CopyUTF16BESequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_length = 0; // Just a trick, we don't want any more variable
-        delete self;
+        result = this->codeUnitAt(--endIndex - 1);
     }
+    return this->substring(0, endIndex).ok();
 }
 
-bool SuperString::CopyUTF16BESequence::isToBeDeleted() const {
-    return this->_length == 0;
+std::size_t SuperString::CopyUTF16BESequence::keepingCost() const {
+    std::size_t cost = sizeof(CopyUTF16BESequence) + this->_memoryLength + this->_offsetIndex.memoryLength() +
+                       this->_hashIndex.memoryLength();
+    return cost;
 }
 
 //*-- SuperString::ConstUTF32Sequence (internal)
 SuperString::ConstUTF32Sequence::ConstUTF32Sequence(const SuperString::Byte *bytes)
         : _bytes(((const int *) bytes)),
           _status(SuperString::ConstUTF32Sequence::Status::LengthNotComputed) {
+#ifdef SUPERSTRING_THREAD_SAFE
+    this->length(); // measured up front, a sequence shared between threads is never written to
+#else
     // nothing go here
+#endif
 }
 
 SuperString::ConstUTF32Sequence::~ConstUTF32Sequence() {
@@ -954,6 +3893,10 @@ std::size_t SuperString::ConstUTF32Sequence::length() const /*override*/ {
     return this->_length;
 }
 
+bool SuperString::ConstUTF32Sequence::isBorrowed() const /*override*/ {
+    return true;
+}
+
 SuperString::Result<int, SuperString::Error>
 SuperString::ConstUTF32Sequence::codeUnitAt(std::size_t index) const {
     if(index < this->length()) {
@@ -962,6 +3905,27 @@ SuperString::ConstUTF32Sequence::codeUnitAt(std::size_t index) const {
     return Result<int, SuperString::Error>(Error::RangeError);
 }
 
+bool SuperString::ConstUTF32Sequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        cursor._bytes = (const Byte *) (this->_bytes + index);
+        cursor._encoding = Encoding::UTF32;
+        cursor._startIndex = 0;
+        cursor._endIndex = this->length();
+        return true;
+    }
+    return false;
+}
+
+bool SuperString::ConstUTF32Sequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                  SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    std::size_t length = endIndex - startIndex;
+    return visitor(Chunk((const Byte *) (this->_bytes + startIndex),
+                         length * sizeof(int), length, Encoding::UTF32), context);
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::ConstUTF32Sequence::substring(std::size_t startIndex,
                                            std::size_t endIndex) const {
@@ -1001,26 +3965,14 @@ SuperString SuperString::ConstUTF32Sequence::trimRight() const {
 }
 
 std::size_t SuperString::ConstUTF32Sequence::keepingCost() const {
-    return sizeof(ConstUTF32Sequence);
-}
-
-void SuperString::ConstUTF32Sequence::doDelete() const {
-    ConstUTF32Sequence *self = ((ConstUTF32Sequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_status = Status::ToBeDestructed; // Just a trick, we don't want any more variable
-        delete self;
-    }
-}
-
-bool SuperString::ConstUTF32Sequence::isToBeDeleted() const {
-    return this->_status == Status::ToBeDestructed;
+    return sizeof(ConstUTF32Sequence) + this->_hashIndex.memoryLength();
 }
 
 //*-- SuperString::CopyUTF32Sequence (internal)
 SuperString::CopyUTF32Sequence::CopyUTF32Sequence(const SuperString::Byte *bytes) {
     this->_length = SuperString::UTF32::length(bytes);
     this->_data = new int[this->_length + 1];
-    std::copy_n(bytes, this->_length + 1, this->_data);
+    std::copy_n((const int *) bytes, this->_length + 1, this->_data);
 }
 
 SuperString::CopyUTF32Sequence::CopyUTF32Sequence(const SuperString::ConstUTF32Sequence *sequence) {
@@ -1029,9 +3981,14 @@ SuperString::CopyUTF32Sequence::CopyUTF32Sequence(const SuperString::ConstUTF32S
     std::copy_n(sequence->_bytes, this->_length + 1, this->_data);
 }
 
+SuperString::CopyUTF32Sequence::CopyUTF32Sequence(int *data, std::size_t length)
+        : _data(data), _length(length) {
+    // nothing go here
+}
+
 SuperString::CopyUTF32Sequence::~CopyUTF32Sequence() {
     this->reconstructReferencers();
-    delete this->_data;
+    delete[] this->_data;
 }
 
 std::size_t SuperString::CopyUTF32Sequence::length() const {
@@ -1046,6 +4003,27 @@ SuperString::Result<int, SuperString::Error> SuperString::CopyUTF32Sequence::cod
     return Result<int, SuperString::Error>(Error::RangeError);
 }
 
+bool SuperString::CopyUTF32Sequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        cursor._bytes = (const Byte *) (this->_data + index);
+        cursor._encoding = Encoding::UTF32;
+        cursor._startIndex = 0;
+        cursor._endIndex = this->length();
+        return true;
+    }
+    return false;
+}
+
+bool SuperString::CopyUTF32Sequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                 SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    std::size_t length = endIndex - startIndex;
+    return visitor(Chunk((const Byte *) (this->_data + startIndex),
+                         length * sizeof(int), length, Encoding::UTF32), context);
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::CopyUTF32Sequence::substring(std::size_t startIndex,
                                           std::size_t endIndex) const {
@@ -1085,24 +4063,35 @@ SuperString SuperString::CopyUTF32Sequence::trimRight() const {
 }
 
 std::size_t SuperString::CopyUTF32Sequence::keepingCost() const {
-    std::size_t cost = sizeof(CopyASCIISequence);
+    std::size_t cost = sizeof(CopyUTF32Sequence) + this->_hashIndex.memoryLength();
     if(this->_data != NULL) {
-        cost += this->length() + 1;
+        cost += (this->length() + 1) * sizeof(int);
     }
     return cost;
 }
 
-void SuperString::CopyUTF32Sequence::doDelete() const {
-    CopyUTF32Sequence *self = ((CopyUTF32Sequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_length = 0; // Just a trick, we don't want any more variable
-        delete self;
-    }
+//*-- SuperString::MappedSequence<T> (internal)
+#ifdef SUPERSTRING_MAPPED_FILES
+template<class T>
+SuperString::MappedSequence<T>::MappedSequence(SuperString::Byte *region, std::size_t regionLength)
+        : T(region),
+          _region(region),
+          _regionLength(regionLength) {
+    // nothing go here
 }
 
-bool SuperString::CopyUTF32Sequence::isToBeDeleted() const {
-    return this->_length == 0;
+template<class T>
+SuperString::MappedSequence<T>::~MappedSequence() {
+    // referencers copy their data out while the region is still mapped
+    this->reconstructReferencers();
+    munmap(this->_region, this->_regionLength);
+}
+
+template<class T>
+std::size_t SuperString::MappedSequence<T>::keepingCost() const /*override*/ {
+    return T::keepingCost() + this->_regionLength;
 }
+#endif
 
 //*-- SuperString::SubstringSequence (internal)
 SuperString::SubstringSequence::SubstringSequence(const StringSequence *sequence, std::size_t startIndex,
@@ -1115,23 +4104,19 @@ SuperString::SubstringSequence::SubstringSequence(const StringSequence *sequence
 }
 
 SuperString::SubstringSequence::~SubstringSequence() {
+    this->reconstructReferencers();
     switch(this->kind()) {
         case Kind::SUBSTRING:
-            this->_container._substring._sequence->removeReferencer(this);
-            if(this->_container._substring._sequence->refCount() == 0 &&
-               this->_container._substring._sequence->freeingCost() <
-               this->_container._substring._sequence->keepingCost()) {
-                this->_container._substring._sequence->doDelete();
-            }
+            this->_container._substring._sequence->dropReferencer(this);
             break;
         case Kind::RECONSTRUCTED:
-            delete this->_container._reconstructed._data;
+            delete[] this->_container._reconstructed._data;
             break;
     }
 }
 
 SuperString::SubstringSequence::Kind SuperString::SubstringSequence::kind() const {
-    return (Kind) (((char) this->_kind) & 0b01111111);
+    return this->_kind;
 }
 
 std::size_t SuperString::SubstringSequence::length() const /*override*/ {
@@ -1141,6 +4126,27 @@ std::size_t SuperString::SubstringSequence::length() const /*override*/ {
         case Kind::RECONSTRUCTED:
             return this->_container._reconstructed._length;
     }
+    return 0;
+}
+
+std::size_t SuperString::SubstringSequence::depth() const /*override*/ {
+    switch(this->kind()) {
+        case Kind::SUBSTRING:
+            return this->_container._substring._sequence->depth() + 1;
+        case Kind::RECONSTRUCTED:
+            return 0;
+    }
+    return 0;
+}
+
+std::size_t SuperString::SubstringSequence::packedWidth() const /*override*/ {
+    switch(this->kind()) {
+        case Kind::SUBSTRING:
+            return this->_container._substring._sequence->packedWidth();
+        case Kind::RECONSTRUCTED:
+            return ReferenceStringSequence::widthOf(this->_container._reconstructed._encoding);
+    }
+    return 0;
 }
 
 SuperString::Result<int, SuperString::Error> SuperString::SubstringSequence::codeUnitAt(
@@ -1151,37 +4157,61 @@ SuperString::Result<int, SuperString::Error> SuperString::SubstringSequence::cod
                 return this->_container._substring._sequence->codeUnitAt(
                         this->_container._substring._startIndex + index);
             case Kind::RECONSTRUCTED:
-                return Result<int, SuperString::Error>(*(this->_container._reconstructed._data + index));
+                return Result<int, SuperString::Error>(
+                        ReferenceStringSequence::unpack(this->_container._reconstructed._data,
+                                                        this->_container._reconstructed._encoding, index));
         }
     }
     return Result<int, SuperString::Error>(Error::RangeError);
 }
 
-SuperString::Result<SuperString, SuperString::Error>
-SuperString::SubstringSequence::substring(std::size_t startIndex, std::size_t endIndex) const {
+bool SuperString::SubstringSequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        switch(this->kind()) {
+            case Kind::SUBSTRING:
+                if(this->_container._substring._sequence->cursorAt(this->_container._substring._startIndex + index,
+                                                                   cursor)) {
+                    cursor._startIndex = std::max(cursor._startIndex, this->_container._substring._startIndex) -
+                                         this->_container._substring._startIndex;
+                    cursor._endIndex = std::min(cursor._endIndex, this->_container._substring._endIndex) -
+                                       this->_container._substring._startIndex;
+                    return true;
+                }
+                break;
+            case Kind::RECONSTRUCTED:
+                cursor._bytes = this->_container._reconstructed._data +
+                                index * ReferenceStringSequence::widthOf(this->_container._reconstructed._encoding);
+                cursor._encoding = this->_container._reconstructed._encoding;
+                cursor._startIndex = 0;
+                cursor._endIndex = this->_container._reconstructed._length;
+                return true;
+        }
+    }
+    return false;
+}
+
+bool SuperString::SubstringSequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                 SuperString::ChunkVisitor visitor, void *context) const {
     switch(this->kind()) {
         case Kind::SUBSTRING:
-            if((this->_container._substring._sequence->length() <
-                (this->_container._substring._startIndex + startIndex)) ||
-               (this->_container._substring._sequence->length() <
-                (this->_container._substring._startIndex + endIndex))) {
-                return Result<SuperString, Error>(Error::RangeError);
-            } else {
-                return Result<SuperString, Error>(
-                        SuperString(new SubstringSequence(this->_container._substring._sequence,
-                                                          this->_container._substring._startIndex +
-                                                          startIndex,
-                                                          this->_container._substring._startIndex +
-                                                          endIndex)));
-            }
+            return this->_container._substring._sequence->visitChunks(
+                    this->_container._substring._startIndex + startIndex,
+                    this->_container._substring._startIndex + endIndex, visitor, context);
         case Kind::RECONSTRUCTED:
-            // TODO: General code, specify + repeated * times
-            if(this->length() < startIndex || this->length() < endIndex) {
-                return Result<SuperString, Error>(Error::RangeError);
-            }
-            SubstringSequence *sequence = new SubstringSequence(this, startIndex, endIndex);
-            return Result<SuperString, Error>(SuperString(sequence));
+            return ReferenceStringSequence::visitData(this->_container._reconstructed._data,
+                                                      this->_container._reconstructed._encoding, startIndex, endIndex,
+                                                      visitor, context);
+    }
+    return false;
+}
+
+SuperString::Result<SuperString, SuperString::Error>
+SuperString::SubstringSequence::substring(std::size_t startIndex, std::size_t endIndex) const {
+    if(this->length() < startIndex || this->length() < endIndex) {
+        return Result<SuperString, Error>(Error::RangeError);
     }
+    return Result<SuperString, Error>(
+            SuperString((StringSequence *) ((std::size_t) this->slice(startIndex, endIndex))));
 }
 
 bool SuperString::SubstringSequence::print(std::ostream &stream) const {
@@ -1190,9 +4220,12 @@ bool SuperString::SubstringSequence::print(std::ostream &stream) const {
             return this->_container._substring._sequence->print(stream, this->_container._substring._startIndex,
                                                                 this->_container._substring._endIndex);
         case Kind::RECONSTRUCTED:
-            SuperString::UTF32::print(stream, ((Byte *) this->_container._reconstructed._data));
+            ReferenceStringSequence::printData(stream, this->_container._reconstructed._data,
+                                               this->_container._reconstructed._encoding, 0,
+                                               this->_container._reconstructed._length);
             return true;
     }
+    return false;
 }
 
 bool SuperString::SubstringSequence::print(std::ostream &stream, std::size_t startIndex,
@@ -1203,9 +4236,11 @@ bool SuperString::SubstringSequence::print(std::ostream &stream, std::size_t sta
                                                                 this->_container._substring._startIndex + startIndex,
                                                                 this->_container._substring._startIndex + endIndex);
         case Kind::RECONSTRUCTED:
-            SuperString::UTF32::print(stream, ((Byte *) this->_container._reconstructed._data), startIndex, endIndex);
+            ReferenceStringSequence::printData(stream, this->_container._reconstructed._data,
+                                               this->_container._reconstructed._encoding, startIndex, endIndex);
             return true;
     }
+    return false;
 }
 
 SuperString SuperString::SubstringSequence::trim() const {
@@ -1243,19 +4278,46 @@ SuperString SuperString::SubstringSequence::trimRight() const {
     return this->substring(0, endIndex).ok();
 }
 
+const SuperString::StringSequence *
+SuperString::SubstringSequence::slice(std::size_t startIndex, std::size_t endIndex) const {
+    if(this->kind() != Kind::SUBSTRING || (startIndex == 0 && endIndex == this->length())) {
+        return StringSequence::slice(startIndex, endIndex);
+    }
+    // sliced from the underlying sequence, substrings never nest
+    return this->_container._substring._sequence->slice(this->_container._substring._startIndex + startIndex,
+                                                        this->_container._substring._startIndex + endIndex);
+}
+
+std::uint64_t SuperString::SubstringSequence::hashOf(std::size_t startIndex, std::size_t endIndex) const {
+    if(this->kind() == Kind::SUBSTRING) {
+        return this->_container._substring._sequence->hash(this->_container._substring._startIndex + startIndex,
+                                                           this->_container._substring._startIndex + endIndex);
+    }
+    return Hash::scan(this, startIndex, endIndex);
+}
+
 std::size_t SuperString::SubstringSequence::keepingCost() const {
-    switch(this->kind()) {
-        case Kind::SUBSTRING:
-            return sizeof(SubstringSequence) + this->_container._substring._sequence->keepingCost();
-        case Kind::RECONSTRUCTED:
-            return sizeof(SubstringSequence) + this->_container._reconstructed._length * sizeof(int);
+    if(this->_keepingCost == KeepingCostNotComputed) {
+        SubstringSequence *self = ((SubstringSequence *) ((std::size_t) this)); // to keep this method `const`
+        switch(this->kind()) {
+            case Kind::SUBSTRING:
+                self->_keepingCost = sizeof(SubstringSequence) + this->_container._substring._sequence->keepingCost();
+                break;
+            case Kind::RECONSTRUCTED:
+                self->_keepingCost = sizeof(SubstringSequence) +
+                                     this->_container._reconstructed._length *
+                                     ReferenceStringSequence::widthOf(this->_container._reconstructed._encoding);
+                break;
+        }
     }
+    return this->_keepingCost;
 }
 
 std::size_t SuperString::SubstringSequence::reconstructionCost(const StringSequence *sequence) const {
     if(this->kind() == Kind::SUBSTRING) {
         return sizeof(SubstringSequence) +
-               (this->_container._substring._endIndex - this->_container._substring._startIndex) * sizeof(int);
+               (this->_container._substring._endIndex - this->_container._substring._startIndex) *
+               sequence->packedWidth();
     }
     return 0;
 }
@@ -1266,37 +4328,25 @@ void SuperString::SubstringSequence::reconstruct(const StringSequence *sequence)
         struct SubstringMetaInfo old = self->_container._substring;
         struct ReconstructedMetaInfo nw;
         nw._length = old._endIndex - old._startIndex;
-        nw._data = new int[nw._length];
-        for(std::size_t i = 0; i < nw._length; i++) {
-            nw._data[i] = old._sequence->codeUnitAt(old._startIndex + i).ok();
-        }
+        nw._data = ReferenceStringSequence::pack(old._sequence, old._startIndex, old._endIndex, nw._encoding);
         old._sequence->removeReferencer(self);
-        if(old._sequence->refCount() == 0 && old._sequence->freeingCost() < old._sequence->keepingCost()) {
-            old._sequence->doDelete();
-        }
+        old._sequence->tryDelete();
         self->_kind = Kind::RECONSTRUCTED;
         self->_container._reconstructed = nw;
+        self->invalidateKeepingCost();
+        self->reconstructionCostChanged();
     }
 }
 
-void SuperString::SubstringSequence::doDelete() const {
-    SubstringSequence *self = ((SubstringSequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_kind = (Kind) (((char) self->kind()) + 0b10000000); // Just a trick, we don't want any more variable
-        delete self;
-    }
-}
-
-bool SuperString::SubstringSequence::isToBeDeleted() const {
-    return (((char) this->_kind) & 0b10000000) == 0b10000000;
-}
-
 //*-- SuperString::ConcatenationSequence (internal)
 SuperString::ConcatenationSequence::ConcatenationSequence(const StringSequence *leftSequence,
                                                           const StringSequence *rightSequence) {
     this->_kind = Kind::CONCATENATION;
     this->_container._concatenation._left = leftSequence;
     this->_container._concatenation._right = rightSequence;
+    this->_length = leftSequence->length() + rightSequence->length();
+    this->_depth = std::max(leftSequence->depth(), rightSequence->depth()) + 1;
+    this->_packedWidth = std::max(leftSequence->packedWidth(), rightSequence->packedWidth());
     this->_container._concatenation._left->addReferencer(this);
     this->_container._concatenation._right->addReferencer(this);
 }
@@ -1304,60 +4354,42 @@ SuperString::ConcatenationSequence::ConcatenationSequence(const StringSequence *
 SuperString::ConcatenationSequence::~ConcatenationSequence() {
     this->reconstructReferencers();
     switch(this->kind()) {
-        case Kind::CONCATENATION:
-            this->_container._concatenation._left->removeReferencer(this);
-            if(this->_container._concatenation._left->refCount() == 0 &&
-               this->_container._concatenation._left->freeingCost() <
-               this->_container._concatenation._left->keepingCost()) {
-                this->_container._concatenation._left->doDelete();
-            }
-            this->_container._concatenation._right->removeReferencer(this);
-            if(this->_container._concatenation._right->refCount() == 0 &&
-               this->_container._concatenation._right->freeingCost() <
-               this->_container._concatenation._right->keepingCost()) {
-                this->_container._concatenation._right->doDelete();
-            }
+        case Kind::CONCATENATION: {
+            const StringSequence *left = this->_container._concatenation._left;
+            const StringSequence *right = this->_container._concatenation._right;
+            right->refAdd(); // deleting [left] may cascade into [right], keep it alive meanwhile
+            right->removeReferencer(this);
+            left->dropReferencer(this);
+            right->release();
             break;
+        }
         case Kind::LEFTRECONSTRUCTED:
-            delete this->_container._leftReconstructed._leftData;
-            this->_container._leftReconstructed._right->removeReferencer(this);
-            if(this->_container._leftReconstructed._right->refCount() == 0 &&
-               this->_container._leftReconstructed._right->freeingCost() <
-               this->_container._leftReconstructed._right->keepingCost()) {
-                this->_container._leftReconstructed._right->doDelete();
-            }
+            delete[] this->_container._leftReconstructed._leftData;
+            this->_container._leftReconstructed._right->dropReferencer(this);
             break;
         case Kind::RIGHTRECONSTRUCTED:
-            delete this->_container._rightReconstructed._rightData;
-            this->_container._rightReconstructed._left->removeReferencer(this);
-            if(this->_container._rightReconstructed._left->refCount() == 0 &&
-               this->_container._rightReconstructed._left->freeingCost() <
-               this->_container._rightReconstructed._left->keepingCost()) {
-                this->_container._rightReconstructed._left->doDelete();
-            }
+            delete[] this->_container._rightReconstructed._rightData;
+            this->_container._rightReconstructed._left->dropReferencer(this);
             break;
         case Kind::RECONSTRUCTED:
-            delete this->_container._reconstructed._data;
+            delete[] this->_container._reconstructed._data;
     }
 }
 
 SuperString::ConcatenationSequence::Kind SuperString::ConcatenationSequence::kind() const {
-    return (Kind) (((char) this->_kind) & 0b01111111);
+    return this->_kind;
 }
 
 std::size_t SuperString::ConcatenationSequence::length() const {
-    switch(this->kind()) {
-        case Kind::CONCATENATION:
-            return this->_container._concatenation._left->length() + this->_container._concatenation._right->length();
-        case Kind::LEFTRECONSTRUCTED:
-            return this->_container._leftReconstructed._leftLength +
-                   this->_container._leftReconstructed._right->length();
-        case Kind::RIGHTRECONSTRUCTED:
-            return this->_container._rightReconstructed._rightLength +
-                   this->_container._rightReconstructed._left->length();
-        case Kind::RECONSTRUCTED:
-            return this->_container._reconstructed._length;
-    }
+    return this->_length;
+}
+
+std::size_t SuperString::ConcatenationSequence::depth() const {
+    return this->_depth;
+}
+
+std::size_t SuperString::ConcatenationSequence::packedWidth() const /*override*/ {
+    return this->_packedWidth;
 }
 
 SuperString::Result<int, SuperString::Error>
@@ -1374,7 +4406,9 @@ SuperString::ConcatenationSequence::codeUnitAt(std::size_t index) const {
             break;
         case Kind::LEFTRECONSTRUCTED:
             if(index < this->_container._leftReconstructed._leftLength) {
-                return Result<int, Error>(this->_container._leftReconstructed._leftData[index]);
+                return Result<int, Error>(
+                        ReferenceStringSequence::unpack(this->_container._leftReconstructed._leftData,
+                                                        this->_container._leftReconstructed._leftEncoding, index));
             } else if((index - this->_container._leftReconstructed._leftLength) <
                       this->_container._leftReconstructed._right->length()) {
                 return Result<int, Error>(this->_container._leftReconstructed._right->codeUnitAt(
@@ -1386,28 +4420,139 @@ SuperString::ConcatenationSequence::codeUnitAt(std::size_t index) const {
                 return Result<int, Error>(this->_container._rightReconstructed._left->codeUnitAt(index));
             } else if((index - this->_container._rightReconstructed._left->length()) <
                       this->_container._rightReconstructed._rightLength) {
-                return Result<int, Error>(
-                        this->_container._rightReconstructed._rightData[
-                                index - this->_container._rightReconstructed._left->length()
-                        ]);
+                return Result<int, Error>(ReferenceStringSequence::unpack(
+                        this->_container._rightReconstructed._rightData,
+                        this->_container._rightReconstructed._rightEncoding,
+                        index - this->_container._rightReconstructed._left->length()));
             }
             break;
         case Kind::RECONSTRUCTED:
             if(index < this->_container._reconstructed._length) {
-                return Result<int, Error>(this->_container._reconstructed._data[index]);
+                return Result<int, Error>(
+                        ReferenceStringSequence::unpack(this->_container._reconstructed._data,
+                                                        this->_container._reconstructed._encoding, index));
             }
     }
     return Result<int, Error>(Error::RangeError);
 }
 
+bool SuperString::ConcatenationSequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    const StringSequence *sequence = NULL;
+    const Byte *data = NULL;
+    Encoding encoding = Encoding::UTF32;
+    std::size_t startIndex = 0, endIndex = 0;
+    switch(this->kind()) {
+        case Kind::CONCATENATION:
+            endIndex = this->_container._concatenation._left->length();
+            if(index < endIndex) {
+                sequence = this->_container._concatenation._left;
+            } else {
+                sequence = this->_container._concatenation._right;
+                startIndex = endIndex;
+            }
+            break;
+        case Kind::LEFTRECONSTRUCTED:
+            endIndex = this->_container._leftReconstructed._leftLength;
+            if(index < endIndex) {
+                data = this->_container._leftReconstructed._leftData;
+                encoding = this->_container._leftReconstructed._leftEncoding;
+            } else {
+                sequence = this->_container._leftReconstructed._right;
+                startIndex = endIndex;
+            }
+            break;
+        case Kind::RIGHTRECONSTRUCTED:
+            endIndex = this->_container._rightReconstructed._left->length();
+            if(index < endIndex) {
+                sequence = this->_container._rightReconstructed._left;
+            } else {
+                data = this->_container._rightReconstructed._rightData;
+                encoding = this->_container._rightReconstructed._rightEncoding;
+                startIndex = endIndex;
+                endIndex += this->_container._rightReconstructed._rightLength;
+            }
+            break;
+        case Kind::RECONSTRUCTED:
+            data = this->_container._reconstructed._data;
+            encoding = this->_container._reconstructed._encoding;
+            endIndex = this->_container._reconstructed._length;
+            break;
+    }
+    if(sequence != NULL) {
+        if(sequence->cursorAt(index - startIndex, cursor)) {
+            cursor._startIndex += startIndex;
+            cursor._endIndex += startIndex;
+            return true;
+        }
+    } else if(index < endIndex) {
+        cursor._bytes = data + (index - startIndex) * ReferenceStringSequence::widthOf(encoding);
+        cursor._encoding = encoding;
+        cursor._startIndex = startIndex;
+        cursor._endIndex = endIndex;
+        return true;
+    }
+    return false;
+}
+
+bool SuperString::ConcatenationSequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                     SuperString::ChunkVisitor visitor, void *context) const {
+    std::size_t leftLength;
+    switch(this->kind()) {
+        case Kind::CONCATENATION:
+            leftLength = this->_container._concatenation._left->length();
+            if(startIndex < leftLength &&
+               !this->_container._concatenation._left->visitChunks(startIndex, std::min(endIndex, leftLength),
+                                                                   visitor, context)) {
+                return false;
+            }
+            if(leftLength < endIndex) {
+                return this->_container._concatenation._right->visitChunks(
+                        std::max(startIndex, leftLength) - leftLength, endIndex - leftLength, visitor, context);
+            }
+            return true;
+        case Kind::LEFTRECONSTRUCTED:
+            leftLength = this->_container._leftReconstructed._leftLength;
+            if(startIndex < leftLength &&
+               !ReferenceStringSequence::visitData(this->_container._leftReconstructed._leftData,
+                                                   this->_container._leftReconstructed._leftEncoding, startIndex,
+                                                   std::min(endIndex, leftLength), visitor, context)) {
+                return false;
+            }
+            if(leftLength < endIndex) {
+                return this->_container._leftReconstructed._right->visitChunks(
+                        std::max(startIndex, leftLength) - leftLength, endIndex - leftLength, visitor, context);
+            }
+            return true;
+        case Kind::RIGHTRECONSTRUCTED:
+            leftLength = this->_container._rightReconstructed._left->length();
+            if(startIndex < leftLength &&
+               !this->_container._rightReconstructed._left->visitChunks(startIndex, std::min(endIndex, leftLength),
+                                                                        visitor, context)) {
+                return false;
+            }
+            if(leftLength < endIndex) {
+                return ReferenceStringSequence::visitData(this->_container._rightReconstructed._rightData,
+                                                          this->_container._rightReconstructed._rightEncoding,
+                                                          std::max(startIndex, leftLength) - leftLength,
+                                                          endIndex - leftLength, visitor, context);
+            }
+            return true;
+        case Kind::RECONSTRUCTED:
+            return ReferenceStringSequence::visitData(this->_container._reconstructed._data,
+                                                      this->_container._reconstructed._encoding, startIndex, endIndex,
+                                                      visitor, context);
+    }
+    return false;
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::ConcatenationSequence::substring(std::size_t startIndex,
                                               std::size_t endIndex) const {
     if(this->length() < startIndex || this->length() < endIndex) {
         return Result<SuperString, Error>(Error::RangeError);
     }
-    SubstringSequence *sequence = new SubstringSequence(this, startIndex, endIndex);
-    return Result<SuperString, Error>(SuperString(sequence));
+    return Result<SuperString, Error>(
+            SuperString((StringSequence *) ((std::size_t) this->slice(startIndex, endIndex))));
 }
 
 bool SuperString::ConcatenationSequence::print(std::ostream &stream) const {
@@ -1418,15 +4563,21 @@ bool SuperString::ConcatenationSequence::print(std::ostream &stream) const {
             isOk &= this->_container._concatenation._right->print(stream);
             break;
         case Kind::LEFTRECONSTRUCTED:
-            SuperString::UTF32::print(stream, (const Byte *) this->_container._leftReconstructed._leftData);
+            ReferenceStringSequence::printData(stream, this->_container._leftReconstructed._leftData,
+                                               this->_container._leftReconstructed._leftEncoding, 0,
+                                               this->_container._leftReconstructed._leftLength);
             isOk &= this->_container._leftReconstructed._right->print(stream);
             break;
         case Kind::RIGHTRECONSTRUCTED:
             isOk &= this->_container._rightReconstructed._left->print(stream);
-            SuperString::UTF32::print(stream, (const Byte *) this->_container._rightReconstructed._rightData);
+            ReferenceStringSequence::printData(stream, this->_container._rightReconstructed._rightData,
+                                               this->_container._rightReconstructed._rightEncoding, 0,
+                                               this->_container._rightReconstructed._rightLength);
             break;
         case Kind::RECONSTRUCTED:
-            SuperString::UTF32::print(stream, (const Byte *) this->_container._reconstructed._data);
+            ReferenceStringSequence::printData(stream, this->_container._reconstructed._data,
+                                               this->_container._reconstructed._encoding, 0,
+                                               this->_container._reconstructed._length);
             break;
     }
     return isOk;
@@ -1435,72 +4586,51 @@ bool SuperString::ConcatenationSequence::print(std::ostream &stream) const {
 bool SuperString::ConcatenationSequence::print(std::ostream &stream, std::size_t startIndex,
                                                             std::size_t endIndex) const {
     bool isOk = true;
+    std::size_t leftLength;
     switch(this->kind()) {
         case Kind::CONCATENATION:
-            if(startIndex < this->_container._concatenation._left->length()) {
-                if(endIndex < this->_container._concatenation._left->length()) {
-                    isOk &= this->_container._concatenation._left->print(stream, startIndex, endIndex);
-                } else {
-                    isOk &= this->_container._concatenation._left->print(stream, startIndex,
-                                                                         this->_container._concatenation._left->length());
-                    isOk &= this->_container._concatenation._right->print(stream, 0,
-                                                                          endIndex -
-                                                                          this->_container._concatenation._left->length());
-                }
-            } else {
-                if((endIndex - this->_container._concatenation._left->length()) <
-                   this->_container._concatenation._right->length()) {
-                    isOk &= this->_container._concatenation._right->print(stream, startIndex -
-                                                                                  this->_container._concatenation._left->length(),
-                                                                          endIndex -
-                                                                          this->_container._concatenation._left->length());
-                }
+            leftLength = this->_container._concatenation._left->length();
+            if(startIndex < leftLength) {
+                isOk &= this->_container._concatenation._left->print(stream, startIndex,
+                                                                     endIndex < leftLength ? endIndex : leftLength);
+            }
+            if(leftLength < endIndex) {
+                isOk &= this->_container._concatenation._right->print(stream, startIndex < leftLength ? 0 :
+                                                                              startIndex - leftLength,
+                                                                      endIndex - leftLength);
             }
             break;
         case Kind::LEFTRECONSTRUCTED:
-            if(startIndex < this->_container._leftReconstructed._leftLength) {
-                if(endIndex < this->_container._leftReconstructed._leftLength) {
-                    SuperString::UTF32::print(stream, (const Byte *) this->_container._leftReconstructed._leftData,
-                                              startIndex, endIndex);
-                } else {
-                    SuperString::UTF32::print(stream, (const Byte *) this->_container._leftReconstructed._leftData,
-                                              startIndex, this->_container._leftReconstructed._leftLength);
-                    isOk &= this->_container._leftReconstructed._right->print(stream, 0,
-                                                                              endIndex -
-                                                                              this->_container._leftReconstructed._leftLength);
-                }
-            } else {
-                if((endIndex - this->_container._leftReconstructed._leftLength) <
-                   this->_container._leftReconstructed._right->length()) {
-                    isOk &= this->_container._leftReconstructed._right->print(stream, startIndex -
-                                                                                      this->_container._leftReconstructed._leftLength,
-                                                                              endIndex -
-                                                                              this->_container._leftReconstructed._leftLength);
-                }
+            leftLength = this->_container._leftReconstructed._leftLength;
+            if(startIndex < leftLength) {
+                ReferenceStringSequence::printData(stream, this->_container._leftReconstructed._leftData,
+                                                   this->_container._leftReconstructed._leftEncoding, startIndex,
+                                                   endIndex < leftLength ? endIndex : leftLength);
+            }
+            if(leftLength < endIndex) {
+                isOk &= this->_container._leftReconstructed._right->print(stream, startIndex < leftLength ? 0 :
+                                                                                  startIndex - leftLength,
+                                                                          endIndex - leftLength);
             }
             break;
         case Kind::RIGHTRECONSTRUCTED:
-            if(startIndex < this->_container._rightReconstructed._left->length()) {
-                if(endIndex < this->_container._rightReconstructed._left->length()) {
-                    isOk &= this->_container._rightReconstructed._left->print(stream, startIndex, endIndex);
-                } else {
-                    isOk &= this->_container._rightReconstructed._left->print(stream, startIndex,
-                                                                      this->_container._rightReconstructed._left->length());
-                    SuperString::UTF32::print(stream, (const Byte *) this->_container._rightReconstructed._rightData, 0,
-                                              endIndex - this->_container._rightReconstructed._left->length());
-                }
-            } else {
-                if((endIndex - this->_container._rightReconstructed._left->length()) <
-                   this->_container._rightReconstructed._rightLength) {
-                    SuperString::UTF32::print(stream, (const Byte *) this->_container._rightReconstructed._rightData,
-                                              startIndex - this->_container._rightReconstructed._left->length(),
-                                              endIndex - this->_container._rightReconstructed._left->length());
-                }
+            leftLength = this->_container._rightReconstructed._left->length();
+            if(startIndex < leftLength) {
+                isOk &= this->_container._rightReconstructed._left->print(stream, startIndex,
+                                                                          endIndex < leftLength ? endIndex :
+                                                                          leftLength);
+            }
+            if(leftLength < endIndex) {
+                ReferenceStringSequence::printData(stream, this->_container._rightReconstructed._rightData,
+                                                   this->_container._rightReconstructed._rightEncoding,
+                                                   startIndex < leftLength ? 0 : startIndex - leftLength,
+                                                   endIndex - leftLength);
             }
             break;
         case Kind::RECONSTRUCTED:
-            SuperString::UTF32::print(stream, (const Byte *) this->_container._reconstructed._data, startIndex,
-                                      endIndex);
+            ReferenceStringSequence::printData(stream, this->_container._reconstructed._data,
+                                               this->_container._reconstructed._encoding, startIndex, endIndex);
+            break;
     }
     return isOk;
 }
@@ -1540,50 +4670,152 @@ SuperString SuperString::ConcatenationSequence::trimRight() const {
     return this->substring(0, endIndex).ok();
 }
 
-std::size_t SuperString::ConcatenationSequence::keepingCost() const {
+SuperString SuperString::ConcatenationSequence::compact(std::size_t threshold) const {
+    if(this->kind() != Kind::CONCATENATION || this->length() <= threshold) {
+        return StringSequence::compact(threshold);
+    }
+    const StringSequence *left = this->_container._concatenation._left;
+    const StringSequence *right = this->_container._concatenation._right;
+    SuperString compactLeft = left->compact(threshold);
+    SuperString compactRight = right->compact(threshold);
+    if(compactLeft._sequence == left && compactRight._sequence == right) {
+        return SuperString((StringSequence *) ((std::size_t) this));
+    }
+    return compactLeft + compactRight;
+}
+
+const SuperString::StringSequence *
+SuperString::ConcatenationSequence::slice(std::size_t startIndex, std::size_t endIndex) const {
+    if(this->kind() != Kind::CONCATENATION || endIndex <= startIndex ||
+       (startIndex == 0 && endIndex == this->length())) {
+        return StringSequence::slice(startIndex, endIndex);
+    }
+    const StringSequence *left = this->_container._concatenation._left;
+    const StringSequence *right = this->_container._concatenation._right;
+    std::size_t leftLength = left->length();
+    if(endIndex <= leftLength) {
+        return left->slice(startIndex, endIndex);
+    }
+    if(leftLength <= startIndex) {
+        return right->slice(startIndex - leftLength, endIndex - leftLength);
+    }
+    // the clipped children are joined, and rebalanced, as any concatenation
+    const StringSequence *leftPart = left->slice(startIndex, leftLength);
+    const StringSequence *rightPart = right->slice(0, endIndex - leftLength);
+    const StringSequence *joined = ConcatenationSequence::concatenate(leftPart, rightPart);
+    StringSequence::discard(leftPart);
+    StringSequence::discard(rightPart);
+    return joined;
+}
+
+std::uint64_t SuperString::ConcatenationSequence::hashOf(std::size_t startIndex, std::size_t endIndex) const {
+    // a reconstructed side is scanned, a sequence combines the hashes of its parts
+    const StringSequence *left = NULL;
+    const StringSequence *right = NULL;
+    std::size_t leftLength = 0;
     switch(this->kind()) {
         case Kind::CONCATENATION:
-            return sizeof(ConcatenationSequence) + this->_container._concatenation._left->keepingCost() +
-                   this->_container._concatenation._right->keepingCost();
+            left = this->_container._concatenation._left;
+            right = this->_container._concatenation._right;
+            leftLength = left->length();
+            break;
         case Kind::LEFTRECONSTRUCTED:
-            return sizeof(ConcatenationSequence) + this->_container._leftReconstructed._leftLength * sizeof(int) +
-                   this->_container._leftReconstructed._right->keepingCost();
+            right = this->_container._leftReconstructed._right;
+            leftLength = this->_container._leftReconstructed._leftLength;
+            break;
         case Kind::RIGHTRECONSTRUCTED:
-            return sizeof(ConcatenationSequence) + this->_container._rightReconstructed._left->keepingCost() +
-                   this->_container._rightReconstructed._rightLength * sizeof(int);
+            left = this->_container._rightReconstructed._left;
+            leftLength = left->length();
+            break;
         case Kind::RECONSTRUCTED:
-            return sizeof(ConcatenationSequence) + this->_container._reconstructed._length * sizeof(int);
+            return Hash::scan(this, startIndex, endIndex);
+    }
+    if(endIndex <= leftLength) {
+        return left != NULL ? left->hash(startIndex, endIndex) : Hash::scan(this, startIndex, endIndex);
+    }
+    if(leftLength <= startIndex) {
+        return right != NULL ? right->hash(startIndex - leftLength, endIndex - leftLength)
+                             : Hash::scan(this, startIndex, endIndex);
+    }
+    std::uint64_t leftHash = left != NULL ? left->hash(startIndex, leftLength)
+                                          : Hash::scan(this, startIndex, leftLength);
+    std::uint64_t rightHash = right != NULL ? right->hash(0, endIndex - leftLength)
+                                            : Hash::scan(this, leftLength, endIndex);
+    return Hash::combine(leftHash, rightHash, endIndex - leftLength);
+}
+
+bool SuperString::ConcatenationSequence::append(const StringSequence *other) {
+    // grows the last leaf when every sequence down to it belongs to this one only
+    if(this->kind() != Kind::CONCATENATION) {
+        return false;
+    }
+    StringSequence *right = (StringSequence *) ((std::size_t) this->_container._concatenation._right);
+    if(!right->isOwnedBy(this) || !right->append(other)) {
+        return false;
+    }
+    this->_length += other->length();
+    this->_packedWidth = std::max(this->_packedWidth, right->packedWidth());
+    this->hashChanged();
+    this->reconstructionCostChanged();
+    return true;
+}
+
+std::size_t SuperString::ConcatenationSequence::keepingCost() const {
+    if(this->_keepingCost == KeepingCostNotComputed) {
+        ConcatenationSequence *self = ((ConcatenationSequence *) ((std::size_t) this)); // to keep this method `const`
+        switch(this->kind()) {
+            case Kind::CONCATENATION:
+                self->_keepingCost = sizeof(ConcatenationSequence) +
+                                     this->_container._concatenation._left->keepingCost() +
+                                     this->_container._concatenation._right->keepingCost();
+                break;
+            case Kind::LEFTRECONSTRUCTED:
+                self->_keepingCost = sizeof(ConcatenationSequence) +
+                                     this->_container._leftReconstructed._leftLength * ReferenceStringSequence::widthOf(
+                                             this->_container._leftReconstructed._leftEncoding) +
+                                     this->_container._leftReconstructed._right->keepingCost();
+                break;
+            case Kind::RIGHTRECONSTRUCTED:
+                self->_keepingCost = sizeof(ConcatenationSequence) +
+                                     this->_container._rightReconstructed._left->keepingCost() +
+                                     this->_container._rightReconstructed._rightLength * ReferenceStringSequence::widthOf(
+                                             this->_container._rightReconstructed._rightEncoding);
+                break;
+            case Kind::RECONSTRUCTED:
+                self->_keepingCost = sizeof(ConcatenationSequence) +
+                                     this->_container._reconstructed._length *
+                                     ReferenceStringSequence::widthOf(this->_container._reconstructed._encoding);
+                break;
+        }
     }
+    return this->_keepingCost;
 }
 
 std::size_t SuperString::ConcatenationSequence::reconstructionCost(const StringSequence *sequence) const {
     switch(this->kind()) {
         case Kind::CONCATENATION:
             if(sequence == this->_container._concatenation._left) {
-                return sizeof(ConcatenationSequence) +
-                       this->_container._concatenation._left->length() * sizeof(int);
+                return ConcatenationSequence::packingCost(this->_container._concatenation._left);
             } else if(sequence == this->_container._concatenation._right) {
-                return sizeof(ConcatenationSequence) +
-                       this->_container._concatenation._right->length() * sizeof(int);
+                return ConcatenationSequence::packingCost(this->_container._concatenation._right);
             }
             return 0;
         case Kind::LEFTRECONSTRUCTED:
             if(sequence == this->_container._leftReconstructed._right) {
-                return sizeof(ConcatenationSequence) +
-                       this->_container._leftReconstructed._right->length() * sizeof(int);
+                return ConcatenationSequence::packingCost(this->_container._leftReconstructed._right);
             } else {
                 return 0;
             }
         case Kind::RIGHTRECONSTRUCTED:
             if(sequence == this->_container._rightReconstructed._left) {
-                return sizeof(ConcatenationSequence) +
-                       this->_container._rightReconstructed._left->length() * sizeof(int);
+                return ConcatenationSequence::packingCost(this->_container._rightReconstructed._left);
             } else {
                 return 0;
             }
         case Kind::RECONSTRUCTED:
             return 0;
     }
+    return 0;
 }
 
 void SuperString::ConcatenationSequence::reconstruct(const StringSequence *sequence) const {
@@ -1594,85 +4826,230 @@ void SuperString::ConcatenationSequence::reconstruct(const StringSequence *seque
             struct LeftReconstructedMetaInfo nw;
             nw._right = old._right;
             nw._leftLength = old._left->length();
-            nw._leftData = new int[nw._leftLength];
-            for(std::size_t i = 0; i < nw._leftLength; i++) {
-                nw._leftData[i] = old._left->codeUnitAt(i).ok();
-            }
+            nw._leftData = ReferenceStringSequence::pack(old._left, 0, nw._leftLength, nw._leftEncoding);
             old._left->removeReferencer(self);
-            if(old._left->refCount() == 0 && old._left->freeingCost() < old._left->keepingCost()) {
-                old._left->doDelete();
-            }
+            old._left->tryDelete();
             self->_kind = Kind::LEFTRECONSTRUCTED;
+            self->_depth = nw._right->depth() + 1;
+            self->_packedWidth = std::max(ReferenceStringSequence::widthOf(nw._leftEncoding),
+                                          nw._right->packedWidth());
             self->_container._leftReconstructed = nw;
+            self->invalidateKeepingCost();
+            self->reconstructionCostChanged();
         } else if(old._right == sequence) {
             struct RightReconstructedMetaInfo nw;
-            nw._left = old._right;
+            nw._left = old._left;
             nw._rightLength = old._right->length();
-            nw._rightData = new int[nw._rightLength];
-            for(std::size_t i = 0; i < nw._rightLength; i++) {
-                nw._rightData[i] = old._right->codeUnitAt(i).ok();
-            }
+            nw._rightData = ReferenceStringSequence::pack(old._right, 0, nw._rightLength, nw._rightEncoding);
             old._right->removeReferencer(self);
-            if(old._right->refCount() == 0 && old._right->freeingCost() < old._right->keepingCost()) {
-                old._right->doDelete();
-            }
+            old._right->tryDelete();
             self->_kind = Kind::RIGHTRECONSTRUCTED;
+            self->_depth = nw._left->depth() + 1;
+            self->_packedWidth = std::max(nw._left->packedWidth(),
+                                          ReferenceStringSequence::widthOf(nw._rightEncoding));
             self->_container._rightReconstructed = nw;
+            self->invalidateKeepingCost();
+            self->reconstructionCostChanged();
         }
     } else if(self->kind() == Kind::LEFTRECONSTRUCTED) {
         struct LeftReconstructedMetaInfo old = self->_container._leftReconstructed;
         if(old._right == sequence) {
+            // packed from this sequence itself, which still reads both halves
             struct ReconstructedMetaInfo nw;
             nw._length = old._leftLength + old._right->length();
-            nw._data = new int[nw._length];
-            for(std::size_t i = 0; i < nw._length; i++) {
-                if(i < old._leftLength) {
-                    nw._data[i] = old._leftData[i];
-                } else {
-                    nw._data[i] = old._right->codeUnitAt(i - old._leftLength).ok();
-                }
-            }
+            nw._data = ReferenceStringSequence::pack(self, 0, nw._length, nw._encoding);
+            delete[] old._leftData;
             old._right->removeReferencer(self);
-            if(old._right->refCount() == 0 && old._right->freeingCost() < old._right->keepingCost()) {
-                old._right->doDelete();
-            }
+            old._right->tryDelete();
             self->_kind = Kind::RECONSTRUCTED;
+            self->_depth = 0;
+            self->_packedWidth = ReferenceStringSequence::widthOf(nw._encoding);
             self->_container._reconstructed = nw;
+            self->invalidateKeepingCost();
+            self->reconstructionCostChanged();
         }
     } else if(self->kind() == Kind::RIGHTRECONSTRUCTED) {
         struct RightReconstructedMetaInfo old = self->_container._rightReconstructed;
         if(old._left == sequence) {
+            // packed from this sequence itself, which still reads both halves
             struct ReconstructedMetaInfo nw;
             nw._length = old._left->length() + old._rightLength;
-            nw._data = new int[nw._length];
-            std::size_t leftLength = old._left->length();
-            for(std::size_t i = 0; i < nw._length; i++) {
-                if(i < leftLength) {
-                    nw._data[i] = old._left->codeUnitAt(i).ok();
-                } else {
-                    nw._data[i] = old._rightData[i - leftLength];
-                }
-            }
+            nw._data = ReferenceStringSequence::pack(self, 0, nw._length, nw._encoding);
+            delete[] old._rightData;
             old._left->removeReferencer(self);
-            if(old._left->refCount() == 0 && old._left->freeingCost() < old._left->keepingCost()) {
-                old._left->doDelete();
-            }
+            old._left->tryDelete();
             self->_kind = Kind::RECONSTRUCTED;
+            self->_depth = 0;
+            self->_packedWidth = ReferenceStringSequence::widthOf(nw._encoding);
             self->_container._reconstructed = nw;
+            self->invalidateKeepingCost();
+            self->reconstructionCostChanged();
         }
     }
 }
 
-void SuperString::ConcatenationSequence::doDelete() const {
-    ConcatenationSequence *self = ((ConcatenationSequence *) (std::size_t) this);
-    if(!this->isToBeDeleted()) {
-        *((char *) &self->_kind) = ((char) self->kind()) + 0b10000000; // Just a trick, we don't want any more variable
-        delete self;
+const SuperString::StringSequence *
+SuperString::ConcatenationSequence::concatenate(const StringSequence *left, const StringSequence *right) {
+    std::size_t leftLength = left->length();
+    std::size_t rightLength = right->length();
+    if(leftLength == 0) {
+        return right;
+    }
+    if(rightLength == 0) {
+        return left;
+    }
+    if(leftLength + rightLength <= MergeLength) {
+        return merge(left, right);
+    }
+    // appending or prepending a short string, grow the boundary leaf instead of adding a node
+    const StringSequence *last = left;
+    while(asConcatenation(last) != NULL) {
+        last = asConcatenation(last)->_container._concatenation._right;
+    }
+    if(last->length() + rightLength <= MergeLength) {
+        return replaceLast(left, right);
+    }
+    const StringSequence *first = right;
+    while(asConcatenation(first) != NULL) {
+        first = asConcatenation(first)->_container._concatenation._left;
+    }
+    if(leftLength + first->length() <= MergeLength) {
+        return replaceFirst(left, right);
+    }
+    std::size_t leftDepth = left->depth();
+    std::size_t rightDepth = right->depth();
+    if(leftDepth > rightDepth + 1 && asConcatenation(left) != NULL) {
+        Pair<const StringSequence *, const StringSequence *> joined = joinRight(asConcatenation(left), right);
+        return new ConcatenationSequence(joined.first(), joined.second());
+    }
+    if(rightDepth > leftDepth + 1 && asConcatenation(right) != NULL) {
+        Pair<const StringSequence *, const StringSequence *> joined = joinLeft(left, asConcatenation(right));
+        return new ConcatenationSequence(joined.first(), joined.second());
+    }
+    return new ConcatenationSequence(left, right);
+}
+
+const SuperString::ConcatenationSequence *
+SuperString::ConcatenationSequence::asConcatenation(const StringSequence *sequence) {
+    const ConcatenationSequence *concatenation = dynamic_cast<const ConcatenationSequence *>(sequence);
+    if(concatenation != NULL && concatenation->kind() == Kind::CONCATENATION) {
+        return concatenation;
+    }
+    return NULL;
+}
+
+std::size_t SuperString::ConcatenationSequence::packingCost(const StringSequence *sequence) {
+    std::size_t cost = sizeof(ConcatenationSequence) + sequence->length() * sequence->packedWidth();
+    if(sequence->depth() != 0) {
+        return std::max(cost, sequence->keepingCost());
+    }
+    return cost;
+}
+
+const SuperString::StringSequence *
+SuperString::ConcatenationSequence::merge(const StringSequence *left, const StringSequence *right) {
+    Byte bytes[4 * MergeLength + 1];
+    std::size_t length = 0;
+    bool isASCII = true;
+    const StringSequence *sequences[] = {left, right};
+    for(const StringSequence *sequence : sequences) {
+        for(Iterator it(sequence, 0), end(sequence, sequence->length()); it != end; ++it) {
+            int codeUnit = *it;
+            std::size_t width = SuperString::UTF8::encode(codeUnit, bytes + length);
+            if(width == 0 || codeUnit == 0) {
+                // not representable as a NUL-terminated UTF-8 copy, keep the node
+                return new ConcatenationSequence(left, right);
+            }
+            isASCII &= codeUnit < 0x80;
+            length += width;
+        }
+    }
+    bytes[length] = 0x00;
+    if(isASCII) {
+        return new CopyASCIISequence(bytes);
+    }
+    return new CopyUTF8Sequence(bytes);
+}
+
+const SuperString::StringSequence *
+SuperString::ConcatenationSequence::replaceLast(const StringSequence *sequence, const StringSequence *right) {
+    const ConcatenationSequence *concatenation = asConcatenation(sequence);
+    if(concatenation == NULL) {
+        return merge(sequence, right);
+    }
+    return new ConcatenationSequence(concatenation->_container._concatenation._left,
+                                     replaceLast(concatenation->_container._concatenation._right, right));
+}
+
+const SuperString::StringSequence *
+SuperString::ConcatenationSequence::replaceFirst(const StringSequence *left, const StringSequence *sequence) {
+    const ConcatenationSequence *concatenation = asConcatenation(sequence);
+    if(concatenation == NULL) {
+        return merge(left, sequence);
     }
+    return new ConcatenationSequence(replaceFirst(left, concatenation->_container._concatenation._left),
+                                     concatenation->_container._concatenation._right);
 }
 
-bool SuperString::ConcatenationSequence::isToBeDeleted() const {
-    return (((char) this->_kind) & 0b10000000) == 0b10000000;
+SuperString::Pair<const SuperString::StringSequence *, const SuperString::StringSequence *>
+SuperString::ConcatenationSequence::joinRight(const ConcatenationSequence *left, const StringSequence *right) {
+    // [left] is deeper than [right] by more than one level, the result is returned as
+    // the two children of the node to build so the caller can still rotate it
+    const StringSequence *outer = left->_container._concatenation._left;
+    const StringSequence *inner = left->_container._concatenation._right;
+    std::size_t depth = right->depth();
+    if(inner->depth() <= depth + 1) {
+        const ConcatenationSequence *concatenation = asConcatenation(inner);
+        if(std::max(inner->depth(), depth) > outer->depth() && concatenation != NULL) {
+            // double rotation
+            return Pair<const StringSequence *, const StringSequence *>(
+                    new ConcatenationSequence(outer, concatenation->_container._concatenation._left),
+                    new ConcatenationSequence(concatenation->_container._concatenation._right, right));
+        }
+        return Pair<const StringSequence *, const StringSequence *>(outer, new ConcatenationSequence(inner, right));
+    }
+    const ConcatenationSequence *concatenation = asConcatenation(inner);
+    if(concatenation == NULL) {
+        return Pair<const StringSequence *, const StringSequence *>(outer, new ConcatenationSequence(inner, right));
+    }
+    Pair<const StringSequence *, const StringSequence *> joined = joinRight(concatenation, right);
+    if(std::max(joined.first()->depth(), joined.second()->depth()) + 1 <= outer->depth() + 1) {
+        return Pair<const StringSequence *, const StringSequence *>(
+                outer, new ConcatenationSequence(joined.first(), joined.second()));
+    }
+    // single rotation to the left
+    return Pair<const StringSequence *, const StringSequence *>(
+            new ConcatenationSequence(outer, joined.first()), joined.second());
+}
+
+SuperString::Pair<const SuperString::StringSequence *, const SuperString::StringSequence *>
+SuperString::ConcatenationSequence::joinLeft(const StringSequence *left, const ConcatenationSequence *right) {
+    // mirror of `joinRight`
+    const StringSequence *inner = right->_container._concatenation._left;
+    const StringSequence *outer = right->_container._concatenation._right;
+    std::size_t depth = left->depth();
+    if(inner->depth() <= depth + 1) {
+        const ConcatenationSequence *concatenation = asConcatenation(inner);
+        if(std::max(inner->depth(), depth) > outer->depth() && concatenation != NULL) {
+            // double rotation
+            return Pair<const StringSequence *, const StringSequence *>(
+                    new ConcatenationSequence(left, concatenation->_container._concatenation._left),
+                    new ConcatenationSequence(concatenation->_container._concatenation._right, outer));
+        }
+        return Pair<const StringSequence *, const StringSequence *>(new ConcatenationSequence(left, inner), outer);
+    }
+    const ConcatenationSequence *concatenation = asConcatenation(inner);
+    if(concatenation == NULL) {
+        return Pair<const StringSequence *, const StringSequence *>(new ConcatenationSequence(left, inner), outer);
+    }
+    Pair<const StringSequence *, const StringSequence *> joined = joinLeft(left, concatenation);
+    if(std::max(joined.first()->depth(), joined.second()->depth()) + 1 <= outer->depth() + 1) {
+        return Pair<const StringSequence *, const StringSequence *>(
+                new ConcatenationSequence(joined.first(), joined.second()), outer);
+    }
+    // single rotation to the right
+    return Pair<const StringSequence *, const StringSequence *>(
+            joined.first(), new ConcatenationSequence(joined.second(), outer));
 }
 
 //*-- MultipleSequence (internal)
@@ -1681,36 +5058,42 @@ SuperString::MultipleSequence::MultipleSequence(const StringSequence *sequence,
     this->_container._multiple._time = time;
     this->_container._multiple._sequence = sequence;
     this->_container._multiple._sequence->addReferencer(this);
+    this->_length = sequence->length() * time;
+    this->_depth = sequence->depth() + 1;
 }
 
 SuperString::MultipleSequence::~MultipleSequence() {
     this->reconstructReferencers();
     switch(this->kind()) {
         case Kind::MULTIPLE:
-            this->_container._multiple._sequence->removeReferencer(this);
-            if(this->_container._multiple._sequence->refCount() == 0 &&
-               this->_container._multiple._sequence->freeingCost() <
-               this->_container._multiple._sequence->keepingCost()) {
-                this->_container._multiple._sequence->doDelete();
-            }
+            this->_container._multiple._sequence->dropReferencer(this);
             break;
         case Kind::RECONSTRUCTED:
-            delete this->_container._reconstructed._data;
+            delete[] this->_container._reconstructed._data;
             break;
     }
 }
 
 SuperString::MultipleSequence::Kind SuperString::MultipleSequence::kind() const {
-    return (Kind) (((char) this->_kind) & 0b01111111);
+    return this->_kind;
 }
 
 std::size_t SuperString::MultipleSequence::length() const {
+    return this->_length;
+}
+
+std::size_t SuperString::MultipleSequence::depth() const {
+    return this->_depth;
+}
+
+std::size_t SuperString::MultipleSequence::packedWidth() const /*override*/ {
     switch(this->kind()) {
         case Kind::MULTIPLE:
-            return this->_container._multiple._sequence->length() * this->_container._multiple._time;
+            return this->_container._multiple._sequence->packedWidth();
         case Kind::RECONSTRUCTED:
-            return this->_container._reconstructed._dataLength * this->_container._reconstructed._time;
+            return ReferenceStringSequence::widthOf(this->_container._reconstructed._encoding);
     }
+    return 0;
 }
 
 SuperString::Result<int, SuperString::Error> SuperString::MultipleSequence::codeUnitAt(std::size_t index) const {
@@ -1721,21 +5104,73 @@ SuperString::Result<int, SuperString::Error> SuperString::MultipleSequence::code
                 return this->_container._multiple._sequence->codeUnitAt(
                         index % this->_container._multiple._sequence->length());
             case Kind::RECONSTRUCTED:
-                return this->_container._reconstructed._data[index % this->_container._reconstructed._dataLength];
+                return ReferenceStringSequence::unpack(this->_container._reconstructed._data,
+                                                       this->_container._reconstructed._encoding,
+                                                       index % this->_container._reconstructed._dataLength);
         }
     }
     return Result<int, Error>(Error::RangeError);
 }
 
+bool SuperString::MultipleSequence::cursorAt(std::size_t index, SuperString::Cursor &cursor) const {
+    if(index < this->length()) {
+        std::size_t unitLength;
+        std::size_t base;
+        switch(this->kind()) {
+            case Kind::MULTIPLE:
+                unitLength = this->_container._multiple._sequence->length();
+                base = index - index % unitLength;
+                if(this->_container._multiple._sequence->cursorAt(index - base, cursor)) {
+                    cursor._startIndex += base;
+                    cursor._endIndex += base;
+                    return true;
+                }
+                break;
+            case Kind::RECONSTRUCTED:
+                unitLength = this->_container._reconstructed._dataLength;
+                base = index - index % unitLength;
+                cursor._bytes = this->_container._reconstructed._data +
+                                (index - base) *
+                                ReferenceStringSequence::widthOf(this->_container._reconstructed._encoding);
+                cursor._encoding = this->_container._reconstructed._encoding;
+                cursor._startIndex = base;
+                cursor._endIndex = base + unitLength;
+                return true;
+        }
+    }
+    return false;
+}
+
+bool SuperString::MultipleSequence::visitChunks(std::size_t startIndex, std::size_t endIndex,
+                                                SuperString::ChunkVisitor visitor, void *context) const {
+    if(endIndex <= startIndex) {
+        return true;
+    }
+    std::size_t unitLength = this->kind() == Kind::MULTIPLE ? this->_container._multiple._sequence->length()
+                                                            : this->_container._reconstructed._dataLength;
+    for(std::size_t base = startIndex - startIndex % unitLength; base < endIndex; base += unitLength) {
+        std::size_t unitStart = std::max(startIndex, base) - base;
+        std::size_t unitEnd = std::min(endIndex, base + unitLength) - base;
+        bool isContinued = this->kind() == Kind::MULTIPLE
+                           ? this->_container._multiple._sequence->visitChunks(unitStart, unitEnd, visitor, context)
+                           : ReferenceStringSequence::visitData(this->_container._reconstructed._data,
+                                                                this->_container._reconstructed._encoding, unitStart,
+                                                                unitEnd, visitor, context);
+        if(!isContinued) {
+            return false;
+        }
+    }
+    return true;
+}
+
 SuperString::Result<SuperString, SuperString::Error>
 SuperString::MultipleSequence::substring(std::size_t startIndex,
                                          std::size_t endIndex) const {
-    std::size_t length = this->length();
-    if(length < startIndex || length < endIndex) {
+    if(this->length() < startIndex || this->length() < endIndex) {
         return Result<SuperString, Error>(Error::RangeError);
     }
-    SubstringSequence *sequence = new SubstringSequence(this, startIndex, endIndex);
-    return Result<SuperString, Error>(SuperString(sequence));
+    return Result<SuperString, Error>(
+            SuperString((StringSequence *) ((std::size_t) this->slice(startIndex, endIndex))));
 }
 
 bool SuperString::MultipleSequence::print(std::ostream &stream) const {
@@ -1747,7 +5182,9 @@ bool SuperString::MultipleSequence::print(std::ostream &stream) const {
             break;
         case Kind::RECONSTRUCTED:
             for(std::size_t i = 0; i < this->_container._multiple._time; i++) {
-                SuperString::UTF32::print(stream, (const Byte *) this->_container._reconstructed._data);
+                ReferenceStringSequence::printData(stream, this->_container._reconstructed._data,
+                                                   this->_container._reconstructed._encoding, 0,
+                                                   this->_container._reconstructed._dataLength);
             }
             break;
     }
@@ -1756,64 +5193,25 @@ bool SuperString::MultipleSequence::print(std::ostream &stream) const {
 
 bool SuperString::MultipleSequence::print(std::ostream &stream, std::size_t startIndex,
                                                        std::size_t endIndex) const {
-    bool printing = false;
-    std::size_t unitLength;
-    switch(this->kind()) {
-        case Kind::MULTIPLE:
-            unitLength = this->_container._multiple._sequence->length();
-            for(std::size_t i = 0; i < this->_container._multiple._time; i++) {
-                std::size_t iterationStartIndex = i * unitLength;
-                std::size_t iterationEndIndex = (i + 1) * unitLength;
-                if(!printing) {
-                    if(iterationStartIndex <= startIndex) {
-                        if(endIndex < iterationEndIndex) {
-                            this->_container._multiple._sequence->print(stream, startIndex - iterationStartIndex,
-                                                                        endIndex - iterationStartIndex);
-                            break;
-                        } else {
-                            printing = true;
-                            this->_container._multiple._sequence->print(stream, startIndex - iterationStartIndex,
-                                                                        unitLength);
-                        }
-                    }
-                } else {
-                    if(endIndex <= iterationEndIndex) {
-                        this->_container._multiple._sequence->print(stream, 0, endIndex - iterationStartIndex);
-                    } else {
-                        this->_container._multiple._sequence->print(stream);
-                    }
-                }
-            }
-            break;
-        case Kind::RECONSTRUCTED:
-            unitLength = this->_container._reconstructed._dataLength;
-            for(std::size_t i = 0; i < this->_container._reconstructed._time; i++) {
-                std::size_t iterationStartIndex = i * unitLength;
-                std::size_t iterationEndIndex = (i + 1) * unitLength;
-                if(!printing) {
-                    if(iterationStartIndex <= startIndex) {
-                        if(endIndex < iterationEndIndex) {
-                            SuperString::UTF32::print(stream, (const Byte *) this->_container._reconstructed._data,
-                                                      startIndex - iterationStartIndex,
-                                                      endIndex - iterationStartIndex);
-                            break;
-                        } else {
-                            printing = true;
-                            SuperString::UTF32::print(stream, (const Byte *) this->_container._reconstructed._data,
-                                                      startIndex - iterationStartIndex,
-                                                      unitLength);
-                        }
-                    }
-                } else {
-                    if(endIndex <= iterationEndIndex) {
-                        SuperString::UTF32::print(stream, (const Byte *) this->_container._reconstructed._data,
-                                                  0, endIndex - iterationStartIndex);
-                    } else {
-                        SuperString::UTF32::print(stream, (const Byte *) this->_container._reconstructed._data);
-                    }
-                }
-            }
-            break;
+    std::size_t unitLength = this->kind() == Kind::MULTIPLE ? this->_container._multiple._sequence->length()
+                                                            : this->_container._reconstructed._dataLength;
+    if(unitLength == 0) {
+        return true;
+    }
+    // from the repetition holding [startIndex], each one cut to the range
+    for(std::size_t i = startIndex / unitLength; i * unitLength < endIndex; i++) {
+        std::size_t iterationStartIndex = i * unitLength;
+        std::size_t from = startIndex < iterationStartIndex ? 0 : startIndex - iterationStartIndex;
+        std::size_t to = endIndex - iterationStartIndex < unitLength ? endIndex - iterationStartIndex : unitLength;
+        switch(this->kind()) {
+            case Kind::MULTIPLE:
+                this->_container._multiple._sequence->print(stream, from, to);
+                break;
+            case Kind::RECONSTRUCTED:
+                ReferenceStringSequence::printData(stream, this->_container._reconstructed._data,
+                                                   this->_container._reconstructed._encoding, from, to);
+                break;
+        }
     }
     return true;
 }
@@ -1853,24 +5251,84 @@ SuperString SuperString::MultipleSequence::trimRight() const {
     return this->substring(0, endIndex).ok();
 }
 
+const SuperString::StringSequence *
+SuperString::MultipleSequence::slice(std::size_t startIndex, std::size_t endIndex) const {
+    if(this->kind() != Kind::MULTIPLE || endIndex <= startIndex || (startIndex == 0 && endIndex == this->length())) {
+        return StringSequence::slice(startIndex, endIndex);
+    }
+    const StringSequence *unit = this->_container._multiple._sequence;
+    std::size_t unitLength = unit->length();
+    std::size_t first = startIndex / unitLength;
+    std::size_t last = (endIndex - 1) / unitLength;
+    if(first == last) {
+        return unit->slice(startIndex - first * unitLength, endIndex - first * unitLength);
+    }
+    // held meanwhile: discarding a part merged into a copy may free [unit] under the retention policy
+    unit->refAdd();
+    // the cut first and last repetitions around the whole ones
+    const StringSequence *sequence = unit->slice(startIndex - first * unitLength, unitLength);
+    if(last - first > 1) {
+        const StringSequence *middle = last - first == 2 ? unit : new MultipleSequence(unit, last - first - 1);
+        const StringSequence *joined = ConcatenationSequence::concatenate(sequence, middle);
+        StringSequence::discard(sequence);
+        StringSequence::discard(middle);
+        sequence = joined;
+    }
+    const StringSequence *tail = unit->slice(0, endIndex - last * unitLength);
+    const StringSequence *joined = ConcatenationSequence::concatenate(sequence, tail);
+    StringSequence::discard(sequence);
+    StringSequence::discard(tail);
+    unit->release();
+    return joined;
+}
+
+std::uint64_t SuperString::MultipleSequence::hashOf(std::size_t startIndex, std::size_t endIndex) const {
+    // a reconstructed unit is scanned in the first repetition
+    const StringSequence *unit = this->kind() == Kind::MULTIPLE ? this->_container._multiple._sequence : NULL;
+    std::size_t unitLength = unit != NULL ? unit->length() : this->_container._reconstructed._dataLength;
+    std::size_t first = startIndex / unitLength;
+    std::size_t last = (endIndex - 1) / unitLength;
+    std::size_t headStart = startIndex - first * unitLength;
+    if(first == last) {
+        std::size_t headEnd = endIndex - first * unitLength;
+        return unit != NULL ? unit->hash(headStart, headEnd) : Hash::scan(this, headStart, headEnd);
+    }
+    // the cut first and last repetitions around the whole ones
+    std::size_t tailEnd = endIndex - last * unitLength;
+    std::uint64_t head = unit != NULL ? unit->hash(headStart, unitLength) : Hash::scan(this, headStart, unitLength);
+    std::uint64_t whole = unit != NULL ? unit->hash() : Hash::scan(this, 0, unitLength);
+    std::uint64_t tail = unit != NULL ? unit->hash(0, tailEnd) : Hash::scan(this, 0, tailEnd);
+    std::uint64_t hash = Hash::combine(head, Hash::repeat(whole, unitLength, last - first - 1),
+                                       (last - first - 1) * unitLength);
+    return Hash::combine(hash, tail, tailEnd);
+}
+
 std::size_t SuperString::MultipleSequence::keepingCost() const {
-    switch(this->kind()) {
-        case Kind::MULTIPLE:
-            return sizeof(MultipleSequence) + this->_container._multiple._sequence->keepingCost();
-        case Kind::RECONSTRUCTED:
-            return sizeof(MultipleSequence) + this->_container._reconstructed._dataLength * sizeof(int);
+    if(this->_keepingCost == KeepingCostNotComputed) {
+        MultipleSequence *self = ((MultipleSequence *) ((std::size_t) this)); // to keep this method `const`
+        switch(this->kind()) {
+            case Kind::MULTIPLE:
+                self->_keepingCost = sizeof(MultipleSequence) + this->_container._multiple._sequence->keepingCost();
+                break;
+            case Kind::RECONSTRUCTED:
+                self->_keepingCost = sizeof(MultipleSequence) +
+                                     this->_container._reconstructed._dataLength *
+                                     ReferenceStringSequence::widthOf(this->_container._reconstructed._encoding);
+                break;
+        }
     }
-    return 0;
+    return this->_keepingCost;
 }
 
 std::size_t SuperString::MultipleSequence::reconstructionCost(const StringSequence *sequence) const {
     switch(this->kind()) {
         case Kind::MULTIPLE:
-            return sizeof(SubstringSequence) +
-                   this->_container._multiple._sequence->length() * this->_container._multiple._time * 2;
+            return sizeof(MultipleSequence) +
+                   this->_container._multiple._sequence->length() * this->_container._multiple._sequence->packedWidth();
         case Kind::RECONSTRUCTED:
             return 0;
     }
+    return 0;
 }
 
 void SuperString::MultipleSequence::reconstruct(const StringSequence *sequence) const {
@@ -1881,32 +5339,18 @@ void SuperString::MultipleSequence::reconstruct(const StringSequence *sequence)
             struct ReconstructedMetaInfo nw;
             nw._time = old._time;
             nw._dataLength = old._sequence->length();
-            nw._data = new int[nw._dataLength];
-            for(std::size_t i = 0; i < nw._dataLength; i++) {
-                nw._data[i] = old._sequence->codeUnitAt(i).ok();
-            }
+            nw._data = ReferenceStringSequence::pack(old._sequence, 0, nw._dataLength, nw._encoding);
             old._sequence->removeReferencer(self);
-            if(old._sequence->refCount() == 0 && old._sequence->freeingCost() < old._sequence->keepingCost()) {
-                old._sequence->doDelete();
-            }
+            old._sequence->tryDelete();
             self->_kind = Kind::RECONSTRUCTED;
+            self->_depth = 0;
             self->_container._reconstructed = nw;
+            self->invalidateKeepingCost();
+            self->reconstructionCostChanged();
         }
     }
 }
 
-void SuperString::MultipleSequence::doDelete() const {
-    MultipleSequence *self = ((MultipleSequence *) (std::size_t) this);
-    if(!self->isToBeDeleted()) {
-        self->_kind = (Kind) (((char) self->kind()) + 0b10000000); // Just a trick, we don't want any more variable
-        delete self;
-    }
-}
-
-bool SuperString::MultipleSequence::isToBeDeleted() const {
-    return (((char) this->_kind) & 0b10000000) == 0b10000000;
-}
-
 //*-- SuperString::ASCII
 std::size_t SuperString::ASCII::length(const SuperString::Byte *bytes) {
     const Byte *pointer = bytes;
@@ -1921,12 +5365,22 @@ int SuperString::ASCII::codeUnitAt(const SuperString::Byte *bytes, std::size_t i
 }
 
 void SuperString::ASCII::print(std::ostream &stream, const SuperString::Byte *bytes) {
-    stream << (const char *) bytes;
+    SuperString::ASCII::print(stream, bytes, 0, std::strlen((const char *) bytes));
 }
 
 void SuperString::ASCII::print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
                                std::size_t endIndex) {
-    stream.write(((char *) (bytes + startIndex)), endIndex - startIndex);
+    // runs of 7-bit bytes are written as they are, the Latin-1 ones in between as UTF-8
+    std::size_t runStart = startIndex;
+    for(std::size_t i = startIndex; i < endIndex; i++) {
+        if(bytes[i] >= 0x80) {
+            stream.write(((const char *) (bytes + runStart)), i - runStart);
+            Byte encoded[2];
+            stream.write((const char *) encoded, SuperString::UTF8::encode(bytes[i], encoded));
+            runStart = i + 1;
+        }
+    }
+    stream.write(((const char *) (bytes + runStart)), endIndex - runStart);
 }
 
 SuperString::Pair<std::size_t, std::size_t>
@@ -1962,36 +5416,291 @@ std::size_t SuperString::ASCII::trimRight(const SuperString::Byte *bytes, std::s
     return endIndex;
 }
 
+std::size_t SuperString::ASCII::encode(int codeUnit, SuperString::Byte *bytes) {
+    if(codeUnit < 0 || codeUnit > 0xff) {
+        return 0;
+    }
+    bytes[0] = (Byte) codeUnit;
+    return 1;
+}
+
+bool SuperString::ASCII::isSevenBit(const SuperString::Byte *bytes, std::size_t length) {
+    std::size_t i = 0;
+    for(; i + 8 <= length; i += 8) {
+        unsigned long long word;
+        std::memcpy(&word, bytes + i, 8);
+        if((word & 0x8080808080808080ULL) != 0) {
+            return false;
+        }
+    }
+    for(; i < length; i++) {
+        if(bytes[i] >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // SuperString::UTF8
-std::size_t SuperString::UTF8::length(const SuperString::Byte *bytes) {
-    std::size_t length = 0;
-    const Byte *pointer = bytes;
-    while(*pointer != 0x00) {
-        if((*pointer & 0xf8) == 0xf0) { pointer += 4; }
-        else if((*pointer & 0xf0) == 0xe0) { pointer += 3; }
-        else if((*pointer & 0xe0) == 0xc0) { pointer += 2; }
-        else if((*pointer & 0x80) == 0x00) { pointer++; }
-        else return 0;
-        length++;
+SuperString::Result<std::size_t, SuperString::Error> SuperString::UTF8::length(const SuperString::Byte *bytes) {
+    Result<Pair<std::size_t, std::size_t>, Error> result = SuperString::UTF8::validate(bytes, NULL);
+    if(result.isOk()) {
+        return Result<std::size_t, Error>(result.ok().first());
     }
-    return length;
+    return Result<std::size_t, Error>(result.err());
 }
 
-SuperString::Pair<std::size_t, std::size_t>
+std::size_t SuperString::UTF8::length(const SuperString::Byte *bytes, std::size_t byteLength) {
+    // every code unit has exactly one byte that is not a continuation byte (10xxxxxx)
+    std::size_t continuations = 0;
+    std::size_t i = 0;
+    for(; i + 8 <= byteLength; i += 8) {
+        unsigned long long word;
+        std::memcpy(&word, bytes + i, 8);
+        unsigned long long marks = (word & ~(word << 1)) & 0x8080808080808080ULL;
+        continuations += (std::size_t) (((marks >> 7) * 0x0101010101010101ULL) >> 56);
+    }
+    for(; i < byteLength; i++) {
+        continuations += (bytes[i] & 0xc0) == 0x80;
+    }
+    return byteLength - continuations;
+}
+
+SuperString::Result<SuperString::Pair<std::size_t, std::size_t>, SuperString::Error>
 SuperString::UTF8::lengthAndMemoryLength(const SuperString::Byte *bytes) {
+    return SuperString::UTF8::validate(bytes, NULL);
+}
+
+SuperString::Result<SuperString::Pair<std::size_t, std::size_t>, SuperString::Error>
+SuperString::UTF8::validate(const SuperString::Byte *bytes, std::size_t *errorOffset) {
     std::size_t length = 0;
     const Byte *pointer = bytes;
-    while(*pointer != 0x00) {
-        if((*pointer & 0xf8) == 0xf0) { pointer += 4; }
-        else if((*pointer & 0xf0) == 0xe0) { pointer += 3; }
-        else if((*pointer & 0xe0) == 0xc0) { pointer += 2; }
-        else if((*pointer & 0x80) == 0x00) { pointer++; }
-        else return Pair<std::size_t, std::size_t>(0, 0); // handle error
-        length++;
+    while(true) {
+        // short ASCII runs between multi-byte sequences are cheaper to walk inline
+        const Byte *next = pointer;
+        const Byte *limit = pointer + 16;
+        while(next < limit && *next != 0x00 && *next < 0x80) {
+            next++;
+        }
+        if(next == limit) {
+            next = SuperString::UTF8::skipASCII(next);
+        }
+        length += next - pointer;
+        pointer = next;
+        if(*pointer == 0x00) {
+            break;
+        }
+        // whole blocks of text are classified at once, the rest one sequence at a time
+        next = SuperString::UTF8::skipValid(pointer);
+        length += SuperString::UTF8::length(pointer, (std::size_t) (next - pointer));
+        pointer = next;
+        if(*pointer < 0x80) {
+            continue;
+        }
+        // a run of multi-byte sequences
+        do {
+            std::size_t width = SuperString::UTF8::check(pointer);
+            if(width == 0) {
+                if(errorOffset != NULL) {
+                    *errorOffset = (std::size_t) (pointer - bytes);
+                }
+                return Result<Pair<std::size_t, std::size_t>, Error>(Error::InvalidByteSequence);
+            }
+            pointer += width;
+            length++;
+        } while(*pointer >= 0x80);
+    }
+    return Result<Pair<std::size_t, std::size_t>, Error>(
+            Pair<std::size_t, std::size_t>(length, (std::size_t) (pointer - bytes) + 1));
+}
+
+const SuperString::Byte *SuperString::UTF8::skipASCII(const SuperString::Byte *pointer) {
+    static const SkipASCIIKernel kernel = SuperString::UTF8::selectSkipASCIIKernel();
+    return kernel(pointer);
+}
+
+SuperString::UTF8::SkipASCIIKernel SuperString::UTF8::selectSkipASCIIKernel() {
+#ifdef SUPERSTRING_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return &SuperString::UTF8::skipASCIIAVX2;
+    }
+    if(__builtin_cpu_supports("sse2")) {
+        return &SuperString::UTF8::skipASCIISSE2;
+    }
+#endif
+    return &SuperString::UTF8::skipASCIIScalar;
+}
+
+const SuperString::Byte *SuperString::UTF8::skipValid(const SuperString::Byte *pointer) {
+    static const SkipValidKernel kernel = SuperString::UTF8::selectSkipValidKernel();
+    return kernel(pointer);
+}
+
+SuperString::UTF8::SkipValidKernel SuperString::UTF8::selectSkipValidKernel() {
+#ifdef SUPERSTRING_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("ssse3")) {
+        return &SuperString::UTF8::skipValidSSSE3;
+    }
+#endif
+    return &SuperString::UTF8::skipValidScalar;
+}
+
+const SuperString::Byte *SuperString::UTF8::skipASCIIScalar(const SuperString::Byte *pointer) {
+    while(*pointer != 0x00 && *pointer < 0x80) {
+        pointer++;
+    }
+    return pointer;
+}
+
+const SuperString::Byte *SuperString::UTF8::skipValidScalar(const SuperString::Byte *pointer) {
+    // left to the sequence by sequence check
+    return pointer;
+}
+
+// The tables of Keiser and Lemire, "Validating UTF-8 in less than one instruction
+// per byte", looked up by the nibbles of each byte and of the byte before it.
+const SuperString::Byte SuperString::UTF8::FirstHighErrors[16] = {
+        TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+        TwoContinuations, TwoContinuations, TwoContinuations, TwoContinuations,
+        TooShort | Overlong2, TooShort, TooShort | Overlong3 | Surrogate,
+        TooShort | TooLarge | TooLarge1000 | Overlong4};
+
+const SuperString::Byte SuperString::UTF8::FirstLowErrors[16] = {
+        Carry | Overlong3 | Overlong2 | Overlong4, Carry | Overlong2, Carry, Carry,
+        Carry | TooLarge, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000 | Surrogate, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000};
+
+const SuperString::Byte SuperString::UTF8::SecondHighErrors[16] = {
+        TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+        TooLong | Overlong2 | TwoContinuations | Overlong3 | TooLarge1000 | Overlong4,
+        TooLong | Overlong2 | TwoContinuations | Overlong3 | TooLarge,
+        TooLong | Overlong2 | TwoContinuations | Surrogate | TooLarge,
+        TooLong | Overlong2 | TwoContinuations | Surrogate | TooLarge,
+        TooShort, TooShort, TooShort, TooShort};
+
+// The vector kernels only issue aligned loads: an aligned block never crosses a
+// page boundary, so reading past the terminating NUL inside it is harmless.
+#ifdef SUPERSTRING_X86_KERNELS
+__attribute__((target("sse2"), no_sanitize_address))
+const SuperString::Byte *SuperString::UTF8::skipASCIISSE2(const SuperString::Byte *pointer) {
+    while(((std::size_t) pointer & 15) != 0) {
+        if(*pointer == 0x00 || *pointer >= 0x80) {
+            return pointer;
+        }
+        pointer++;
+    }
+    const __m128i zero = _mm_setzero_si128();
+    while(true) {
+        __m128i block = _mm_load_si128((const __m128i *) pointer);
+        unsigned int mask = (unsigned int) (_mm_movemask_epi8(block) |
+                                            _mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)));
+        if(mask != 0) {
+            return pointer + __builtin_ctz(mask);
+        }
+        pointer += 16;
+    }
+}
+
+__attribute__((target("avx2"), no_sanitize_address))
+const SuperString::Byte *SuperString::UTF8::skipASCIIAVX2(const SuperString::Byte *pointer) {
+    while(((std::size_t) pointer & 31) != 0) {
+        if(*pointer == 0x00 || *pointer >= 0x80) {
+            return pointer;
+        }
+        pointer++;
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    while(true) {
+        __m256i block = _mm256_load_si256((const __m256i *) pointer);
+        unsigned int mask = (unsigned int) (_mm256_movemask_epi8(block) |
+                                            _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, zero)));
+        if(mask != 0) {
+            return pointer + __builtin_ctz(mask);
+        }
+        pointer += 32;
+    }
+}
+
+// Stops at the first block holding a NUL or an error, backing up to the start of
+// a sequence the block cuts, so that everything before is known to be well formed.
+__attribute__((target("ssse3"), no_sanitize_address))
+const SuperString::Byte *SuperString::UTF8::skipValidSSSE3(const SuperString::Byte *pointer) {
+    const Byte *block = (const Byte *) ((std::size_t) pointer & ~(std::size_t) 15);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i firstHigh = _mm_loadu_si128((const __m128i *) FirstHighErrors);
+    const __m128i firstLow = _mm_loadu_si128((const __m128i *) FirstLowErrors);
+    const __m128i secondHigh = _mm_loadu_si128((const __m128i *) SecondHighErrors);
+    // the last three bytes of a block may start sequences that go on in the next one
+    const __m128i incompleteLimits = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                   (char) (0xf0 - 1), (char) (0xe0 - 1), (char) (0xc0 - 1));
+    // the bytes of the first block before [pointer] read as spaces
+    std::size_t skipped = (std::size_t) (pointer - block);
+    const __m128i before = _mm_cmpgt_epi8(_mm_set1_epi8((char) skipped),
+                                          _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    __m128i input = _mm_load_si128((const __m128i *) block);
+    input = _mm_or_si128(_mm_andnot_si128(before, input), _mm_and_si128(before, _mm_set1_epi8(' ')));
+    __m128i previous = _mm_set1_epi8(' ');
+    __m128i incomplete = zero;
+    while(true) {
+        __m128i error;
+        if(_mm_movemask_epi8(input) == 0) {
+            // ASCII only, unless the block before left a sequence unfinished
+            error = incomplete;
+        } else {
+            __m128i previous1 = _mm_alignr_epi8(input, previous, 15);
+            __m128i cases = _mm_and_si128(
+                    _mm_and_si128(_mm_shuffle_epi8(firstHigh, _mm_and_si128(_mm_srli_epi16(previous1, 4), nibble)),
+                                  _mm_shuffle_epi8(firstLow, _mm_and_si128(previous1, nibble))),
+                    _mm_shuffle_epi8(secondHigh, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+            // the third and fourth bytes of a sequence must be continuation bytes, and only they
+            __m128i previous2 = _mm_alignr_epi8(input, previous, 14);
+            __m128i previous3 = _mm_alignr_epi8(input, previous, 13);
+            __m128i continued = _mm_or_si128(_mm_subs_epu8(previous2, _mm_set1_epi8((char) (0xe0 - 0x80))),
+                                             _mm_subs_epu8(previous3, _mm_set1_epi8((char) (0xf0 - 0x80))));
+            error = _mm_xor_si128(_mm_and_si128(continued, _mm_set1_epi8((char) 0x80)), cases);
+        }
+        // a NUL ends the text, so it stops the loop like an error does
+        error = _mm_or_si128(error, _mm_cmpeq_epi8(input, zero));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xffff) {
+            break;
+        }
+        incomplete = _mm_subs_epu8(input, incompleteLimits);
+        previous = input;
+        block += 16;
+        input = _mm_load_si128((const __m128i *) block);
+    }
+    // a sequence the block cuts is left to the caller
+    const Byte *end = block < pointer ? pointer : block;
+    if(pointer < end && end[-1] >= 0xc0) {
+        return end - 1;
+    }
+    if(pointer + 1 < end && end[-2] >= 0xe0) {
+        return end - 2;
     }
-    return Pair<std::size_t, std::size_t>(length, pointer - bytes + 1);
+    if(pointer + 2 < end && end[-3] >= 0xf0) {
+        return end - 3;
+    }
+    return end;
+}
+#else
+const SuperString::Byte *SuperString::UTF8::skipASCIISSE2(const SuperString::Byte *pointer) {
+    return SuperString::UTF8::skipASCIIScalar(pointer);
+}
+
+const SuperString::Byte *SuperString::UTF8::skipASCIIAVX2(const SuperString::Byte *pointer) {
+    return SuperString::UTF8::skipASCIIScalar(pointer);
 }
 
+const SuperString::Byte *SuperString::UTF8::skipValidSSSE3(const SuperString::Byte *pointer) {
+    return SuperString::UTF8::skipValidScalar(pointer);
+}
+#endif
+
 SuperString::Result<int, SuperString::Error>
 SuperString::UTF8::codeUnitAt(const SuperString::Byte *bytes, std::size_t index) {
     std::size_t i = 0;
@@ -2122,13 +5831,105 @@ SuperString::Pair<SuperString::Byte *, std::size_t> SuperString::UTF8::codeUnitT
     return Pair<Byte *, std::size_t>(bytes, numBytes);
 }
 
+std::size_t SuperString::UTF8::encode(int codeUnit, SuperString::Byte *bytes) {
+    if(codeUnit < 0 || (0xd800 <= codeUnit && codeUnit <= 0xdfff) || codeUnit > 0x10ffff) {
+        return 0;
+    }
+    if(codeUnit < 0x80) {
+        bytes[0] = (Byte) codeUnit;
+        return 1;
+    }
+    if(codeUnit < 0x800) {
+        bytes[0] = (Byte) (0xc0 | (codeUnit >> 6));
+        bytes[1] = (Byte) (0x80 | (codeUnit & 0x3f));
+        return 2;
+    }
+    if(codeUnit < 0x10000) {
+        bytes[0] = (Byte) (0xe0 | (codeUnit >> 12));
+        bytes[1] = (Byte) (0x80 | ((codeUnit >> 6) & 0x3f));
+        bytes[2] = (Byte) (0x80 | (codeUnit & 0x3f));
+        return 3;
+    }
+    bytes[0] = (Byte) (0xf0 | (codeUnit >> 18));
+    bytes[1] = (Byte) (0x80 | ((codeUnit >> 12) & 0x3f));
+    bytes[2] = (Byte) (0x80 | ((codeUnit >> 6) & 0x3f));
+    bytes[3] = (Byte) (0x80 | (codeUnit & 0x3f));
+    return 4;
+}
+
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::UTF8::offset(const SuperString::Byte *bytes, std::size_t index) {
+    const Byte *pointer = bytes;
+    for(std::size_t i = 0; i < index; i++) {
+        if(*pointer == 0x00) {
+            return Result<std::size_t, Error>(Error::RangeError);
+        }
+        if((*pointer & 0xf8) == 0xf0) { pointer += 4; }
+        else if((*pointer & 0xf0) == 0xe0) { pointer += 3; }
+        else if((*pointer & 0xe0) == 0xc0) { pointer += 2; }
+        else if((*pointer & 0x80) == 0x00) { pointer++; }
+        else return Result<std::size_t, Error>(Error::InvalidByteSequence);
+    }
+    return Result<std::size_t, Error>((std::size_t) (pointer - bytes));
+}
+
+int SuperString::UTF8::decode(const SuperString::Byte *pointer) {
+    if((*pointer & 0xf8) == 0xf0) {
+        return ((pointer[0] & 0x07) << 18) | ((pointer[1] & 0x3f) << 12) | ((pointer[2] & 0x3f) << 6) |
+               (pointer[3] & 0x3f);
+    } else if((*pointer & 0xf0) == 0xe0) {
+        return ((pointer[0] & 0x0f) << 12) | ((pointer[1] & 0x3f) << 6) | (pointer[2] & 0x3f);
+    } else if((*pointer & 0xe0) == 0xc0) {
+        return ((pointer[0] & 0x1f) << 6) | (pointer[1] & 0x3f);
+    }
+    return *pointer;
+}
+
+std::size_t SuperString::UTF8::width(const SuperString::Byte *pointer) {
+    if((*pointer & 0xf8) == 0xf0) { return 4; }
+    else if((*pointer & 0xf0) == 0xe0) { return 3; }
+    else if((*pointer & 0xe0) == 0xc0) { return 2; }
+    return 1;
+}
+
+std::size_t SuperString::UTF8::check(const SuperString::Byte *pointer) {
+    // as in RFC 3629: no overlong forms, no surrogates, nothing above U+10FFFF
+    Byte lead = *pointer;
+    Byte low = 0x80, high = 0xbf;
+    std::size_t width;
+    if(lead >= 0xc2 && lead <= 0xdf) {
+        width = 2;
+    } else if(lead >= 0xe0 && lead <= 0xef) {
+        width = 3;
+        if(lead == 0xe0) { low = 0xa0; }
+        else if(lead == 0xed) { high = 0x9f; }
+    } else if(lead >= 0xf0 && lead <= 0xf4) {
+        width = 4;
+        if(lead == 0xf0) { low = 0x90; }
+        else if(lead == 0xf4) { high = 0x8f; }
+    } else {
+        return 0;
+    }
+    if(pointer[1] < low || pointer[1] > high) {
+        return 0;
+    }
+    for(std::size_t i = 2; i < width; i++) {
+        if((pointer[i] & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return width;
+}
+
 // SuperString::UTF16BE
 std::size_t SuperString::UTF16BE::length(const SuperString::Byte *bytes) {
+    std::size_t length = 0;
     const Byte *pointer = bytes;
     while(*pointer != 0x00 || *(pointer + 1) != 0x00) {
-        pointer += 2;
+        pointer += SuperString::UTF16BE::width(pointer);
+        length++;
     }
-    return (pointer - bytes) / 2;
+    return length;
 }
 
 SuperString::Pair<std::size_t, std::size_t>
@@ -2148,17 +5949,8 @@ SuperString::UTF16BE::codeUnitAt(const SuperString::Byte *bytes, std::size_t ind
     std::size_t i = 0;
     const Byte *pointer = bytes;
     while(*pointer != 0x00 || *(pointer + 1) != 0x00) {
-        int codeUnit = 0;
-        if((*pointer & 0xfc) == 0xd8) {
-            codeUnit = (*pointer & 0x03) << 18;
-            codeUnit += *(pointer + 1) << 10;
-            codeUnit += (*(pointer + 2) & 0x03) << 8;
-            codeUnit += *(pointer + 3);
-            pointer += 4;
-        } else {
-            codeUnit = (*pointer << 8) + (*(pointer + 1));
-            pointer += 2;
-        }
+        int codeUnit = SuperString::UTF16BE::decode(pointer);
+        pointer += SuperString::UTF16BE::width(pointer);
         if(i == index) {
             return Result<int, SuperString::Error>(codeUnit);
         }
@@ -2171,31 +5963,86 @@ void SuperString::UTF16BE::print(std::ostream &stream, const SuperString::Byte *
     SuperString::UTF16BE::print(stream, bytes, 0, length);
 }
 
+SuperString::Result<std::size_t, SuperString::Error>
+SuperString::UTF16BE::offset(const SuperString::Byte *bytes, std::size_t index) {
+    const Byte *pointer = bytes;
+    for(std::size_t i = 0; i < index; i++) {
+        if(*pointer == 0x00 && *(pointer + 1) == 0x00) {
+            return Result<std::size_t, Error>(Error::RangeError);
+        }
+        pointer += SuperString::UTF16BE::width(pointer);
+    }
+    return Result<std::size_t, Error>((std::size_t) (pointer - bytes));
+}
+
+int SuperString::UTF16BE::decode(const SuperString::Byte *pointer) {
+    if((*pointer & 0xfc) == 0xd8) {
+        int high = ((pointer[0] & 0x03) << 8) | pointer[1];
+        int low = ((pointer[2] & 0x03) << 8) | pointer[3];
+        return 0x10000 + (high << 10) + low;
+    }
+    return (pointer[0] << 8) | pointer[1];
+}
+
+std::size_t SuperString::UTF16BE::width(const SuperString::Byte *pointer) {
+    return ((*pointer & 0xfc) == 0xd8) ? 4 : 2;
+}
+
+std::size_t SuperString::UTF16BE::encode(int codeUnit, SuperString::Byte *bytes) {
+    if(codeUnit < 0 || (0xd800 <= codeUnit && codeUnit <= 0xdfff) || codeUnit > 0x10ffff) {
+        return 0;
+    }
+    if(codeUnit < 0x10000) {
+        bytes[0] = (Byte) (codeUnit >> 8);
+        bytes[1] = (Byte) codeUnit;
+        return 2;
+    }
+    int high = 0xd800 + ((codeUnit - 0x10000) >> 10);
+    int low = 0xdc00 + ((codeUnit - 0x10000) & 0x3ff);
+    bytes[0] = (Byte) (high >> 8);
+    bytes[1] = (Byte) high;
+    bytes[2] = (Byte) (low >> 8);
+    bytes[3] = (Byte) low;
+    return 4;
+}
+
 void SuperString::UTF16BE::print(std::ostream &stream, const SuperString::Byte *bytes, std::size_t startIndex,
                                  std::size_t endIndex) {
     std::size_t i = 0;
     const Byte *pointer = bytes;
     while((*pointer != 0x00 || *(pointer + 1) != 0x00) && i < endIndex) {
-        int codeUnit = 0;
-        if((*pointer & 0xfc) == 0xd8) {
-            codeUnit = (*pointer & 0x03) << 18;
-            codeUnit += *(pointer + 1) << 10;
-            codeUnit += (*(pointer + 2) & 0x03) << 8;
-            codeUnit += *(pointer + 3);
-            pointer += 4;
-        } else {
-            codeUnit = (*pointer << 8) + (*(pointer + 1));
-            pointer += 2;
-        }
+        int codeUnit = SuperString::UTF16BE::decode(pointer);
+        pointer += SuperString::UTF16BE::width(pointer);
         if(startIndex <= i) {
             Pair<Byte *, std::size_t> encoded = SuperString::UTF8::codeUnitToChar(codeUnit);
             stream.write((const char *) encoded.first(), encoded.second());
-            delete encoded.first();
+            delete[] encoded.first();
         }
         i++;
     }
 }
 
+// SuperString::UTF16LE
+SuperString::Byte *SuperString::UTF16LE::toBigEndian(const SuperString::Byte *bytes) {
+    std::size_t size = 0;
+    while(bytes[size] != 0x00 || bytes[size + 1] != 0x00) {
+        size += 2;
+    }
+    Byte *swapped = new Byte[size + 2];
+    std::memcpy(swapped, bytes, size + 2);
+    SuperString::UTF16LE::swap(swapped, size);
+    return swapped;
+}
+
+void SuperString::UTF16LE::swap(SuperString::Byte *bytes, std::size_t size) {
+    // a plain loop over pairs, simple enough for the compiler to vectorize
+    for(std::size_t i = 0; i + 1 < size; i += 2) {
+        Byte first = bytes[i];
+        bytes[i] = bytes[i + 1];
+        bytes[i + 1] = first;
+    }
+}
+
 // SuperString::UTF32
 std::size_t SuperString::UTF32::length(const SuperString::Byte *bytes) {
     const Byte *pointer = bytes;
@@ -2220,13 +6067,21 @@ int SuperString::UTF32::codeUnitAt(const SuperString::Byte *bytes, std::size_t i
     return *(((int *) bytes) + index);
 }
 
+std::size_t SuperString::UTF32::encode(int codeUnit, SuperString::Byte *bytes) {
+    if(codeUnit < 0 || (0xd800 <= codeUnit && codeUnit <= 0xdfff) || codeUnit > 0x10ffff) {
+        return 0;
+    }
+    std::memcpy(bytes, &codeUnit, sizeof(int)); // [bytes] may not be aligned
+    return sizeof(int);
+}
+
 void SuperString::UTF32::print(std::ostream &stream, const SuperString::Byte *bytes) {
     const Byte *pointer = bytes;
     while(*((int *) pointer) != 0x00) {
         int codeUnit = *((int *) pointer);
         Pair<Byte *, std::size_t> encoded = SuperString::UTF8::codeUnitToChar(codeUnit);
         stream.write((const char *) encoded.first(), encoded.second());
-        delete encoded.first();
+        delete[] encoded.first();
         pointer += 4;
     }
 }
@@ -2237,7 +6092,7 @@ void SuperString::UTF32::print(std::ostream &stream, const SuperString::Byte *by
         int codeUnit = *(((int *) bytes) + i);
         Pair<Byte *, std::size_t> encoded = SuperString::UTF8::codeUnitToChar(codeUnit);
         stream.write((const char *) encoded.first(), encoded.second());
-        delete encoded.first();
+        delete[] encoded.first();
     }
 }
 
@@ -2274,6 +6129,109 @@ std::size_t SuperString::UTF32::trimRight(const SuperString::Byte *bytes, std::s
     return endIndex;
 }
 
+//*-- SuperString::Hash
+std::uint64_t SuperString::Hash::multiply(std::uint64_t a, std::uint64_t b) {
+    // the product of 32-bit halves, folded with 2^61 = 1 without 128-bit arithmetic
+    std::uint64_t aLow = a & 0xffffffffULL;
+    std::uint64_t aHigh = a >> 32;
+    std::uint64_t bLow = b & 0xffffffffULL;
+    std::uint64_t bHigh = b >> 32;
+    std::uint64_t low = aLow * bLow;
+    std::uint64_t middle = aHigh * bLow + aLow * bHigh;
+    std::uint64_t high = aHigh * bHigh;
+    std::uint64_t folded = (low & Modulus) + (low >> 61) + (high << 3) + (middle >> 29) + ((middle << 32) & Modulus);
+    folded = (folded & Modulus) + (folded >> 61);
+    return folded >= Modulus ? folded - Modulus : folded;
+}
+
+std::uint64_t SuperString::Hash::add(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t sum = a + b;
+    return sum >= Modulus ? sum - Modulus : sum;
+}
+
+std::uint64_t SuperString::Hash::subtract(std::uint64_t a, std::uint64_t b) {
+    return a >= b ? a - b : a + (Modulus - b);
+}
+
+std::uint64_t SuperString::Hash::power(std::size_t exponent) {
+    std::uint64_t result = 1;
+    std::uint64_t base = Base;
+    while(exponent != 0) {
+        if(exponent & 1) {
+            result = Hash::multiply(result, base);
+        }
+        base = Hash::multiply(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+std::uint64_t SuperString::Hash::combine(std::uint64_t left, std::uint64_t right, std::size_t rightLength) {
+    return Hash::add(Hash::multiply(left, Hash::power(rightLength)), right);
+}
+
+std::uint64_t SuperString::Hash::repeat(std::uint64_t hash, std::size_t length, std::size_t times) {
+    // appends the copies of the string doubled as many times as [times] has bits set
+    std::uint64_t result = 0;
+    std::uint64_t doubled = hash;
+    std::uint64_t shift = Hash::power(length);
+    while(times != 0) {
+        if(times & 1) {
+            result = Hash::add(Hash::multiply(result, shift), doubled);
+        }
+        doubled = Hash::add(Hash::multiply(doubled, shift), doubled);
+        shift = Hash::multiply(shift, shift);
+        times >>= 1;
+    }
+    return result;
+}
+
+std::uint64_t SuperString::Hash::scan(const StringSequence *sequence, std::size_t startIndex, std::size_t endIndex) {
+    State state = {0, 0, NULL};
+    if(startIndex < endIndex) {
+        sequence->visitChunks(startIndex, endIndex, Hash::visit, &state);
+    }
+    return state._hash;
+}
+
+bool SuperString::Hash::visit(const Chunk &chunk, void *context) {
+    State *state = (State *) context;
+    std::uint64_t hash = state->_hash;
+    std::size_t index = state->_index;
+    const Byte *pointer = chunk.bytes();
+    for(std::size_t i = 0; i < chunk.length(); i++, index++) {
+        int codeUnit = 0;
+        switch(chunk.encoding()) {
+            case Encoding::ASCII:
+            case Encoding::Latin1:
+                codeUnit = *pointer;
+                pointer += 1;
+                break;
+            case Encoding::UTF8:
+                codeUnit = SuperString::UTF8::decode(pointer);
+                pointer += SuperString::UTF8::width(pointer);
+                break;
+            case Encoding::UTF16BE:
+                codeUnit = SuperString::UTF16BE::decode(pointer);
+                pointer += SuperString::UTF16BE::width(pointer);
+                break;
+            case Encoding::UTF32:
+                codeUnit = *((const int *) pointer);
+                pointer += sizeof(int);
+                break;
+            case Encoding::UTF16LE:
+                break; // never stored, swapped into UTF16BE
+        }
+        if(state->_samples != NULL && index % HashIndex::Stride == 0) {
+            state->_samples[index / HashIndex::Stride] = hash;
+        }
+        hash = Hash::add(Hash::multiply(hash, Base), (std::uint32_t) codeUnit);
+    }
+    state->_hash = hash;
+    state->_index = index;
+    return true;
+}
+
 //
 std::ostream &operator<<(std::ostream &stream, const SuperString &string) {
     string.print(stream);
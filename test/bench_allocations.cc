@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+#include <string>
+
+#include "SuperString.hh"
+
+// global allocation counter
+static std::size_t allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *pointer = malloc(size == 0 ? 1 : size);
+    if(pointer == NULL) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+    free(pointer);
+}
+
+static bool measure(const char *name, const SuperString &string, std::size_t rounds) {
+    std::size_t length = string.length();
+    long checksum = 0;
+    std::size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t round = 0; round < rounds; round++) {
+        for(std::size_t i = 0; i < length; i++) {
+            SuperString::Result<int, SuperString::Error> result = string.codeUnitAt(i);
+            if(result.isOk()) {
+                checksum += result.ok();
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::size_t calls = rounds * length;
+    std::size_t count = allocations - before;
+    double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-24s %10zu calls %8zu allocations %8.2f ns/call (checksum %ld)\n", name, calls, count,
+           nanoseconds / calls, checksum);
+    return count == 0;
+}
+
+int main() {
+    std::string ascii;
+    for(int i = 0; i < 64; i++) {
+        ascii += "The quick brown fox jumps over the lazy dog. ";
+    }
+    const int utf32[] = {0x48, 0x00e9, 0x4e16, 0x1f600, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0};
+    const SuperString::Byte utf16be[] = {0x00, 0x48, 0x00, 0xe9, 0x4e, 0x16, 0xd8, 0x3d, 0xde, 0x00, 0x00, 0x21,
+                                         0x00, 0x00};
+    const char *utf8 = "H\xc3\xa9\xe4\xb8\x96\xf0\x9f\x98\x80 world";
+
+    SuperString constASCII = SuperString::Const(ascii.c_str(), SuperString::Encoding::ASCII);
+    SuperString copyASCII = SuperString::Copy(ascii.c_str(), SuperString::Encoding::ASCII);
+    SuperString constUTF8 = SuperString::Const(utf8);
+    SuperString copyUTF8 = SuperString::Copy(utf8);
+    SuperString constUTF16BE = SuperString::Const(utf16be, SuperString::Encoding::UTF16BE);
+    SuperString copyUTF16BE = SuperString::Copy(utf16be, SuperString::Encoding::UTF16BE);
+    SuperString constUTF32 = SuperString::Const(utf32);
+    SuperString copyUTF32 = SuperString::Copy(utf32);
+    SuperString substring = copyASCII.substring(5, 500).ok();
+    SuperString concatenation = constASCII + copyUTF8 + copyUTF32;
+    SuperString multiple = copyUTF16BE * 16;
+
+    bool isOk = true;
+    isOk &= measure("ConstASCIISequence", constASCII, 100);
+    isOk &= measure("CopyASCIISequence", copyASCII, 100);
+    isOk &= measure("ConstUTF8Sequence", constUTF8, 100);
+    isOk &= measure("CopyUTF8Sequence", copyUTF8, 100);
+    isOk &= measure("ConstUTF16BESequence", constUTF16BE, 100);
+    isOk &= measure("CopyUTF16BESequence", copyUTF16BE, 100);
+    isOk &= measure("ConstUTF32Sequence", constUTF32, 100);
+    isOk &= measure("CopyUTF32Sequence", copyUTF32, 100);
+    isOk &= measure("SubstringSequence", substring, 100);
+    isOk &= measure("ConcatenationSequence", concatenation, 100);
+    isOk &= measure("MultipleSequence", multiple, 100);
+
+    if(!isOk) {
+        printf("FAILED: codeUnitAt allocated on the heap\n");
+        return 1;
+    }
+    return 0;
+}
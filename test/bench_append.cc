@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "SuperString.hh"
+
+static const char *alphabet = "abcdefghijklmnopqrstuvwxyz";
+
+// Appends [count] single characters to a string, then measures random access on
+// the result. Returns false if a code unit read back is wrong.
+static bool run(const std::vector<SuperString> &characters, std::size_t count, double &appendNanoseconds,
+                double &accessNanoseconds) {
+    std::size_t accesses = 1000000;
+    auto start = std::chrono::steady_clock::now();
+    SuperString string = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < count; i++) {
+        string = string + characters[i % 26];
+    }
+    auto end = std::chrono::steady_clock::now();
+    appendNanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / count;
+
+    if(string.length() != count) {
+        printf("FAILED: expected length %zu, got %zu\n", count, string.length());
+        return false;
+    }
+
+    srand(42);
+    bool isOk = true;
+    start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < accesses; i++) {
+        std::size_t index = ((std::size_t) rand()) % count;
+        isOk &= string.codeUnitAt(index).ok() == alphabet[index % 26];
+    }
+    end = std::chrono::steady_clock::now();
+    accessNanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / accesses;
+
+    printf("%zu appends: %8.2f ns/append\n", count, appendNanoseconds);
+    printf("%zu random accesses: %8.2f ns/access\n", accesses, accessNanoseconds);
+    if(!isOk) {
+        printf("FAILED: random access returned the wrong code unit\n");
+    }
+    return isOk;
+}
+
+// Appends and reads N / 4 then N characters: with logarithmic appends and
+// accesses, four times the length must cost far less than four times the time.
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1000000;
+    std::vector<SuperString> characters;
+    for(int i = 0; i < 26; i++) {
+        char chars[2] = {alphabet[i], 0};
+        characters.push_back(SuperString::Copy(chars, SuperString::Encoding::ASCII));
+    }
+
+    double shortAppend, shortAccess, longAppend, longAccess;
+    if(!run(characters, count / 4, shortAppend, shortAccess) || !run(characters, count, longAppend, longAccess)) {
+        return 1;
+    }
+    if(longAppend > 3 * shortAppend || longAccess > 3 * shortAccess) {
+        printf("FAILED: appends or accesses grow linearly with the length\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Builds a string from a text delivered in reads of [readLength] bytes, as from
+// a pipe: with a builder, into a std::string for reference, and appending a copy
+// of every read. Reads may cut UTF-8 sequences.
+static int run(const char *name, const std::string &text, std::size_t readLength) {
+    auto start = std::chrono::steady_clock::now();
+    std::string reference;
+    for(std::size_t at = 0; at < text.size(); at += readLength) {
+        reference.append(text, at, readLength);
+    }
+    double referenceTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    SuperString::Builder builder;
+    for(std::size_t at = 0; at < text.size(); at += readLength) {
+        std::size_t length = text.size() - at < readLength ? text.size() - at : readLength;
+        if(builder.append(text.data() + at, length).isErr()) {
+            printf("FAILED: the builder rejected the read at %zu\n", at);
+            return 1;
+        }
+    }
+    SuperString built = builder.build().ok();
+    double builderTime = since(start);
+
+    // a copy per read, on the first megabyte only as it grows quadratically; the reads
+    // end on sequence boundaries, the fragments have to be valid on their own
+    std::vector<std::string> fragments;
+    for(std::size_t at = 0, next; at < (1 << 20); at = next) {
+        next = at + readLength;
+        while((text[next] & 0xc0) == 0x80) {
+            next--;
+        }
+        fragments.push_back(text.substr(at, next - at));
+    }
+    start = std::chrono::steady_clock::now();
+    SuperString appended = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(const std::string &fragment : fragments) {
+        appended += SuperString::Copy(fragment.c_str());
+    }
+    double appendTime = since(start);
+    start = std::chrono::steady_clock::now();
+    for(const std::string &fragment : fragments) {
+        builder.append(fragment.data(), fragment.size());
+    }
+    SuperString prefix = builder.build().ok();
+    double prefixTime = since(start);
+
+    printf("%-6s %9zu bytes in reads of %5zu: std::string %8.2f ms  builder %8.2f ms;"
+           "  first MB: += Copy %8.2f ms  builder %6.2f ms\n", name, text.size(), readLength, referenceTime,
+           builderTime, appendTime, prefixTime);
+    if(prefix.toStdString() != appended.toStdString()) {
+        printf("FAILED: the first megabyte differs\n");
+        return 1;
+    }
+    if(built.toStdString() != reference) {
+        printf("FAILED: the built string differs from the text\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::size_t megabytes = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 64;
+    std::string ascii, utf8;
+    while(ascii.size() < megabytes << 20) {
+        ascii += "The quick brown fox jumps over the lazy dog.\n";
+    }
+    while(utf8.size() < megabytes << 20) {
+        utf8 += "Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr pr\xc3\xa9" "f\xc3\xa8re \xe4\xb8\x96\xf0\x9f\x98\x80.\n";
+    }
+    return run("ascii", ascii, 4096) || run("ascii", ascii, 64) || run("utf8", utf8, 4096) || run("utf8", utf8, 64);
+}
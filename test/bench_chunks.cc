@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "SuperString.hh"
+
+// decodes the code unit at [bytes] in [encoding] and advances [bytes] past it
+static int decode(const SuperString::Byte *&bytes, SuperString::Encoding encoding) {
+    int codeUnit = 0;
+    switch(encoding) {
+        case SuperString::Encoding::ASCII:
+            codeUnit = *bytes++;
+            break;
+        case SuperString::Encoding::UTF8:
+            if(*bytes < 0x80) {
+                codeUnit = *bytes++;
+            } else if(*bytes < 0xe0) {
+                codeUnit = ((bytes[0] & 0x1f) << 6) | (bytes[1] & 0x3f);
+                bytes += 2;
+            } else if(*bytes < 0xf0) {
+                codeUnit = ((bytes[0] & 0x0f) << 12) | ((bytes[1] & 0x3f) << 6) | (bytes[2] & 0x3f);
+                bytes += 3;
+            } else {
+                codeUnit = ((bytes[0] & 0x07) << 18) | ((bytes[1] & 0x3f) << 12) | ((bytes[2] & 0x3f) << 6) |
+                           (bytes[3] & 0x3f);
+                bytes += 4;
+            }
+            break;
+        case SuperString::Encoding::UTF16BE:
+            codeUnit = (bytes[0] << 8) | bytes[1];
+            bytes += 2;
+            if((codeUnit & 0xfc00) == 0xd800) {
+                codeUnit = 0x10000 + ((codeUnit - 0xd800) << 10) + (((bytes[0] << 8) | bytes[1]) - 0xdc00);
+                bytes += 2;
+            }
+            break;
+        case SuperString::Encoding::UTF32:
+            codeUnit = *((const int *) bytes);
+            bytes += sizeof(int);
+            break;
+    }
+    return codeUnit;
+}
+
+// Walks a large document made of every kind of sequence, code unit by code unit
+// with the iterator and chunk by chunk with forEachChunk.
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 10000;
+    const int utf32[] = {0x48, 0x00e9, 0x4e16, 0x1f600, 0x20, 0};
+    const SuperString::Byte utf16be[] = {0x00, 0x48, 0x00, 0xe9, 0x4e, 0x16, 0xd8, 0x3d, 0xde, 0x00, 0x00, 0x20,
+                                         0x00, 0x00};
+    SuperString paragraph = SuperString::Copy("Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr pr\xc3\xa9"
+                                              "f\xc3\xa8re, the quick brown fox jumps over the lazy dog. ");
+    std::vector<SuperString> pieces;
+    pieces.push_back(SuperString::Copy("The quick brown fox jumps over the lazy dog. ", SuperString::Encoding::ASCII));
+    pieces.push_back(paragraph * 3);
+    pieces.push_back(paragraph.substring(5, 60).ok());
+    pieces.push_back(SuperString::Copy(utf16be, SuperString::Encoding::UTF16BE));
+    pieces.push_back(SuperString::Copy(utf32));
+    SuperString document = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < count; i++) {
+        document = document + pieces[i % pieces.size()];
+    }
+    std::size_t length = document.length();
+
+    unsigned long slowChecksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int codeUnit : document) {
+        slowChecksum = slowChecksum * 31 + codeUnit;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double slowNanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+
+    unsigned long fastChecksum = 0;
+    std::size_t chunks = 0;
+    std::size_t bytes = 0;
+    start = std::chrono::steady_clock::now();
+    auto visit = [&](const SuperString::Chunk &chunk) {
+        const SuperString::Byte *pointer = chunk.bytes();
+        for(std::size_t i = 0; i < chunk.length(); i++) {
+            fastChecksum = fastChecksum * 31 + decode(pointer, chunk.encoding());
+        }
+        chunks++;
+        bytes += chunk.byteLength();
+        return pointer == chunk.bytes() + chunk.byteLength();
+    };
+    SuperString::Result<bool, SuperString::Error> isComplete = document.forEachChunk(0, length, visit);
+    end = std::chrono::steady_clock::now();
+    double fastNanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+
+    printf("%zu code units in %zu chunks of %zu bytes\n", length, chunks, bytes);
+    printf("iterator:     %8.2f ms\n", slowNanoseconds / 1e6);
+    printf("forEachChunk: %8.2f ms\n", fastNanoseconds / 1e6);
+    if(isComplete.isErr() || !isComplete.ok() || slowChecksum != fastChecksum) {
+        printf("FAILED: iterator and forEachChunk disagree\n");
+        return 1;
+    }
+    return 0;
+}
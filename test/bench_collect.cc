@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+// Latency buckets, in microseconds.
+static const double bounds[] = {1, 10, 100, 1000, 10000};
+static const int boundCount = sizeof(bounds) / sizeof(bounds[0]);
+
+struct Histogram {
+    std::size_t counts[boundCount + 1];
+    double total;
+    double worst;
+
+    Histogram() : counts(), total(0), worst(0) {
+    }
+
+    void add(double micros) {
+        int i = 0;
+        while(i < boundCount && micros >= bounds[i]) {
+            i++;
+        }
+        counts[i]++;
+        total += micros;
+        worst = micros > worst ? micros : worst;
+    }
+
+    void print(const char *name) const {
+        printf("  %-22s", name);
+        for(int i = 0; i <= boundCount; i++) {
+            printf(" %7zu", counts[i]);
+        }
+        printf("   total %9.2f ms  worst %9.1f us\n", total / 1000, worst);
+    }
+};
+
+// Serves [count] requests that each load a document, keep slices of it in a
+// cache of recent results and drop it: the document is freed right away, its
+// slices copying what they reference, or deferred to a collection every
+// [batch] requests.
+static int run(const char *name, bool isDeferred, std::size_t count, std::size_t batch) {
+    SuperString::deferredReconstruction(isDeferred);
+    std::string text;
+    while(text.size() < (1 << 20)) {
+        text += "The quick brown fox jumps over the lazy dog. ";
+    }
+    std::vector<SuperString> cache(4096);
+    std::size_t next = 0;
+    Histogram releases, collections;
+    for(std::size_t i = 0; i < count; i++) {
+        SuperString document = SuperString::Copy(text.c_str(), SuperString::Encoding::ASCII);
+        for(std::size_t j = 0; j < 2048; j++) {
+            std::size_t start = (i * 131 + j * 7919) % (text.size() - 256);
+            cache[next++ % cache.size()] = document.substring(start, start + 256).ok();
+        }
+        auto start = std::chrono::steady_clock::now();
+        document = SuperString();
+        releases.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        if(isDeferred && (i + 1) % batch == 0) {
+            start = std::chrono::steady_clock::now();
+            SuperString::collect();
+            collections.add(
+                    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    SuperString::collect();
+    SuperString::deferredReconstruction(false);
+    printf("%s:\n  %-22s", name, "");
+    for(int i = 0; i < boundCount; i++) {
+        printf(" <%5.0fus", bounds[i]);
+    }
+    printf(" >=%.0fus\n", bounds[boundCount - 1]);
+    releases.print("release on request");
+    if(isDeferred) {
+        collections.print("collect between batches");
+    }
+    std::size_t length = 0;
+    for(const SuperString &slice : cache) {
+        length += slice.length();
+    }
+    if(length != cache.size() * 256) {
+        printf("FAILED: the cached slices have %zu code units instead of %zu\n", length, cache.size() * 256);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 400;
+    return run("immediate", false, count, 0) || run("deferred", true, count, 16);
+}
@@ -9,22 +9,13 @@
 #include "SuperString.hh"
 
 static void SplitToLines_SuperString(benchmark::State& state) {
-    char *content;
     // file reading
-    FILE *f = fopen("/Users/btwael/Downloads/longtextfile.txt", "r+");
-    fseek(f, 0, SEEK_END);
-    long fsize = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    content = (char *) malloc(fsize + 1);
-    fread(content, fsize, 1, f);
-    fclose(f);
-
-    SuperString string = SuperString::Const(content, SuperString::Encoding::ASCII);
-    free(content);
+    SuperString string = SuperString::MapFile("/Users/btwael/Downloads/longtextfile.txt",
+                                              SuperString::Encoding::ASCII).ok();
 
     std::vector<SuperString> lines;
-    SuperString::Size last = 0;
-    for(SuperString::Size i = 0; i < string.length(); i++) {
+    std::size_t last = 0;
+    for(std::size_t i = 0; i < string.length(); i++) {
         int c = string.codeUnitAt(i).ok();
         if(c == '\n') {
             lines.push_back(string.substring(last, i).ok());
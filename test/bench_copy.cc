@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+// Exports a large concatenated document to UTF-8, through print and with copyTo.
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 10000;
+    std::vector<SuperString> pieces;
+    pieces.push_back(SuperString::Copy("The quick brown fox jumps over the lazy dog. ", SuperString::Encoding::ASCII));
+    pieces.push_back(SuperString::Copy("Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr pr\xc3\xa9" "f\xc3\xa8re. "));
+    pieces.push_back(SuperString::Copy("\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87\xe7\xab\xa0\xe3\x80\x82 "));
+    SuperString document = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < count; i++) {
+        document = document + pieces[i % pieces.size()];
+    }
+    std::size_t length = document.length();
+
+    auto start = std::chrono::steady_clock::now();
+    std::ostringstream stream;
+    document.print(stream);
+    std::string slow = stream.str();
+    auto end = std::chrono::steady_clock::now();
+    double slowNanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::size_t size = document.copyTo(NULL, 0, length).ok();
+    std::string fast(size, '\0');
+    document.copyTo((SuperString::Byte *) &fast[0], 0, length);
+    end = std::chrono::steady_clock::now();
+    double fastNanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+
+    printf("%zu code units, %zu bytes\n", length, size);
+    printf("print:  %8.2f ms\n", slowNanoseconds / 1e6);
+    printf("copyTo: %8.2f ms\n", fastNanoseconds / 1e6);
+    if(slow != fast) {
+        printf("FAILED: copyTo and print disagree\n");
+        return 1;
+    }
+    return 0;
+}
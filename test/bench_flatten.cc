@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Reads [string] through random accesses and a full iteration.
+static unsigned long read(const char *name, const SuperString &string, double buildTime) {
+    std::size_t length = string.length();
+    auto start = std::chrono::steady_clock::now();
+    unsigned long sum = 0;
+    std::size_t index = 0;
+    for(int i = 0; i < 200000; i++) {
+        index = (index * 1103515245 + 12345) % length;
+        sum += (unsigned long) string.codeUnitAt(index).ok();
+    }
+    double accessTime = since(start);
+    start = std::chrono::steady_clock::now();
+    for(int codeUnit : string) {
+        sum += (unsigned long) codeUnit;
+    }
+    double iterateTime = since(start);
+    printf("%-14s build %8.2f ms  random access %8.2f ms  iterate %8.2f ms  keeps %10zu bytes\n", name, buildTime,
+           accessTime, iterateTime, string.keepingCost());
+    return sum;
+}
+
+// Assembles a document from many slices of a few sources and some literals,
+// then reads it as is, flattened and compacted.
+int main(int argc, char **argv) {
+    std::size_t pieces = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 20000;
+    std::vector<SuperString> sources;
+    for(int i = 0; i < 4; i++) {
+        std::string text;
+        while(text.size() < (1 << 18)) {
+            text += i % 2 == 0 ? "The quick brown fox jumps over the lazy dog. " : "Voix ambigu\xc3\xab d'un c\xc5\x93ur. ";
+        }
+        sources.push_back(SuperString::Copy(text.c_str()));
+    }
+    SuperString separator = SuperString::Copy(" | ", SuperString::Encoding::ASCII);
+    SuperString document = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < pieces; i++) {
+        const SuperString &source = sources[i % sources.size()];
+        std::size_t start = (i * 7919) % (source.length() - 300);
+        document = document + source.substring(start, start + 150 + i % 150).ok() + separator;
+    }
+
+    unsigned long expected = read("rope", document, 0);
+    auto start = std::chrono::steady_clock::now();
+    SuperString flat = document.flatten().ok();
+    double flattenTime = since(start);
+    start = std::chrono::steady_clock::now();
+    SuperString flat32 = document.flatten(SuperString::Encoding::UTF32).ok();
+    double flatten32Time = since(start);
+    start = std::chrono::steady_clock::now();
+    SuperString compacted = document.compact();
+    double compactTime = since(start);
+    if(read("flatten UTF-8", flat, flattenTime) != expected || read("flatten UTF-32", flat32, flatten32Time) != expected ||
+       read("compact", compacted, compactTime) != expected) {
+        printf("FAILED: the copies differ from the rope\n");
+        return 1;
+    }
+    sources.clear();
+    document = SuperString();
+    printf("sources released: flatten UTF-8 keeps %zu bytes, compact keeps %zu bytes\n", flat.keepingCost(),
+           compacted.keepingCost());
+    return 0;
+}
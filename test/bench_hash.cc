@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Hashes [string] code unit by code unit through `codeUnitAt`, the way it had
+// to be done without `hash`.
+static std::size_t hashByCodeUnits(const SuperString &string) {
+    std::size_t hash = 0;
+    for(std::size_t i = 0; i < string.length(); i++) {
+        hash = hash * 31 + (std::size_t) string.codeUnitAt(i).ok();
+    }
+    return hash;
+}
+
+// Hashes a large rope, then the rope grown by a piece, a long repetition and
+// long substrings of a flat string, and counts words in a hash map keyed by
+// substrings of a text.
+int main(int argc, char **argv) {
+    std::size_t pieces = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 10000;
+    std::string text;
+    while(text.size() < (1 << 20)) {
+        text += "Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr pr\xc3\xa9" "f\xc3\xa8re les jattes de kiwis. ";
+    }
+    SuperString source = SuperString::Copy(text.c_str());
+    SuperString rope = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < pieces; i++) {
+        std::size_t start = (i * 7919) % (source.length() - 300);
+        rope = rope + source.substring(start, start + 150 + i % 150).ok();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t byCodeUnits = hashByCodeUnits(rope);
+    double codeUnitTime = since(start);
+    start = std::chrono::steady_clock::now();
+    std::size_t first = rope.hash();
+    double firstTime = since(start);
+    start = std::chrono::steady_clock::now();
+    std::size_t again = rope.hash();
+    double againTime = since(start);
+    SuperString grown = rope + source.substring(0, 1000).ok();
+    start = std::chrono::steady_clock::now();
+    std::size_t combined = grown.hash();
+    double grownTime = since(start);
+    printf("rope of %zu code units: codeUnitAt %9.2f ms  hash %8.2f ms  cached %8.4f ms  grown %8.4f ms\n",
+           rope.length(), codeUnitTime, firstTime, againTime, grownTime);
+
+    SuperString repeated = source.substring(0, 1000).ok() * 100000;
+    start = std::chrono::steady_clock::now();
+    std::size_t repeatedHash = repeated.hash();
+    double repeatedTime = since(start);
+    printf("repetition of %zu code units: hash %8.4f ms\n", repeated.length(), repeatedTime);
+
+    start = std::chrono::steady_clock::now();
+    std::size_t substringHashes = 0;
+    for(std::size_t i = 0; i < 1000; i++) {
+        std::size_t from = (i * 7919) % (source.length() / 2);
+        substringHashes += source.substring(from, from + source.length() / 2).ok().hash();
+    }
+    double substringTime = since(start);
+    printf("1000 substrings of %zu code units: hash %8.2f ms (the first builds the index)\n",
+           source.length() / 2, substringTime);
+
+    std::vector<SuperString> words;
+    std::vector<std::string> stdWords;
+    std::size_t last = 0;
+    for(SuperString::Iterator it = source.begin(), end = source.end(); it != end; ++it) {
+        if(*it == ' ') {
+            words.push_back(source.substring(last, it.index()).ok());
+            stdWords.push_back(words.back().toStdString());
+            last = it.index() + 1;
+        }
+    }
+    start = std::chrono::steady_clock::now();
+    std::size_t wordHashes = 0;
+    for(const SuperString &word : words) {
+        wordHashes += std::hash<SuperString>()(word);
+    }
+    double wordHashTime = since(start);
+    start = std::chrono::steady_clock::now();
+    for(const std::string &word : stdWords) {
+        wordHashes += std::hash<std::string>()(word);
+    }
+    double stdWordHashTime = since(start);
+    printf("%zu words: hash SuperString %8.2f ms  std::string %8.2f ms\n", words.size(), wordHashTime,
+           stdWordHashTime);
+    start = std::chrono::steady_clock::now();
+    std::unordered_map<SuperString, std::size_t> counts;
+    for(const SuperString &word : words) {
+        counts[word]++;
+    }
+    double mapTime = since(start);
+    start = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, std::size_t> stdCounts;
+    for(const std::string &word : stdWords) {
+        stdCounts[word]++;
+    }
+    double stdMapTime = since(start);
+    printf("%zu words, %zu distinct: SuperString keys %8.2f ms  std::string keys %8.2f ms\n", words.size(),
+           counts.size(), mapTime, stdMapTime);
+
+    if(first != again || counts.size() != stdCounts.size() || combined == first ||
+       grown.hash() != grown.flatten(SuperString::Encoding::UTF32).ok().hash() ||
+       repeatedHash != repeated.flatten().ok().hash()) {
+        printf("FAILED: the hashes disagree\n");
+        return 1;
+    }
+    return (int) ((byCodeUnits ^ substringHashes ^ wordHashes) & 0);
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Short strings the way parsers make them: tokens copied from the input, words
+// sliced out of a line and counted in a map, single characters joined back.
+// Every one of them fits inline, so no sequence should be created.
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1000000;
+    std::vector<std::string> tokens;
+    for(std::size_t i = 0; i < count; i++) {
+        tokens.push_back((i % 3 == 0 ? "id" : (i % 3 == 1 ? "caf\xc3\xa9_" : "k")) + std::to_string(i % 5000));
+    }
+    std::string text;
+    for(std::size_t i = 0; text.size() < count * 8; i++) {
+        text += tokens[i % tokens.size()] + ' ';
+    }
+
+    std::size_t sequenceCount = SuperString::stats().sequenceCount();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SuperString> copies;
+    copies.reserve(tokens.size());
+    for(const std::string &token : tokens) {
+        copies.push_back(SuperString::Copy(token.c_str()));
+    }
+    double copyTime = since(start);
+    std::size_t copySequences = SuperString::stats().sequenceCount() - sequenceCount;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<std::string> references;
+    references.reserve(tokens.size());
+    for(const std::string &token : tokens) {
+        references.push_back(token);
+    }
+    double referenceCopyTime = since(start);
+
+    SuperString line = SuperString::Copy(text.c_str());
+    sequenceCount = SuperString::stats().sequenceCount();
+    start = std::chrono::steady_clock::now();
+    std::unordered_map<SuperString, std::size_t> counts;
+    std::size_t last = 0;
+    for(SuperString::Iterator it = line.begin(), end = line.end(); it != end; ++it) {
+        if(*it == ' ') {
+            counts[line.substring(last, it.index()).ok()]++;
+            last = it.index() + 1;
+        }
+    }
+    double countTime = since(start);
+    std::size_t countSequences = SuperString::stats().sequenceCount() - sequenceCount;
+
+    start = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, std::size_t> referenceCounts;
+    for(std::size_t at = 0, next; (next = text.find(' ', at)) != std::string::npos; at = next + 1) {
+        referenceCounts[text.substr(at, next - at)]++;
+    }
+    double referenceCountTime = since(start);
+
+    sequenceCount = SuperString::stats().sequenceCount();
+    start = std::chrono::steady_clock::now();
+    std::size_t joinedLength = 0;
+    for(std::size_t i = 0; i < count; i++) {
+        const SuperString &token = copies[i];
+        SuperString joined = token.substring(0, 1).ok() + token.substring(token.length() - 1, token.length()).ok();
+        joinedLength += joined.length();
+    }
+    double joinTime = since(start);
+    std::size_t joinSequences = SuperString::stats().sequenceCount() - sequenceCount;
+
+    printf("%zu tokens: Copy %8.2f ms (std::string %8.2f ms), %zu sequences\n", count, copyTime, referenceCopyTime,
+           copySequences);
+    printf("%zu words: counted %8.2f ms (std::string %8.2f ms), %zu sequences\n", counts.size(), countTime,
+           referenceCountTime, countSequences);
+    printf("%zu characters: joined %8.2f ms, %zu sequences\n", joinedLength, joinTime, joinSequences);
+    if(counts.size() != referenceCounts.size()) {
+        printf("FAILED: %zu distinct words instead of %zu\n", counts.size(), referenceCounts.size());
+        return 1;
+    }
+    for(const std::pair<const std::string, std::size_t> &entry : referenceCounts) {
+        if(counts[SuperString::Copy(entry.first.c_str())] != entry.second) {
+            printf("FAILED: the count of %s differs\n", entry.first.c_str());
+            return 1;
+        }
+    }
+    if(joinedLength != 2 * count) {
+        printf("FAILED: %zu characters joined instead of %zu\n", joinedLength, 2 * count);
+        return 1;
+    }
+    return 0;
+}
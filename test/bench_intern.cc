@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static long residentKilobytes() {
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if(f != NULL) {
+        if(fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * 4;
+}
+
+// Ingests the [tokens] of records, field names and enum values seen over and
+// over, keeping a string for each: a copy of its own, or interned in [pool]
+// by [threadCount] threads. Then counts the tokens equal to a given one.
+static int run(const char *name, const std::vector<std::string> &tokens, SuperString::InternPool *pool,
+               std::size_t threadCount) {
+    std::vector<SuperString> kept(tokens.size());
+    long resident = residentKilobytes();
+    std::size_t sequenceCount = SuperString::stats().sequenceCount();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(std::size_t t = 0; t < threadCount; t++) {
+        threads.push_back(std::thread([&tokens, &kept, pool, threadCount, t]() {
+            for(std::size_t i = t; i < tokens.size(); i += threadCount) {
+                SuperString token = SuperString::Copy(tokens[i].c_str());
+                kept[i] = pool != NULL ? pool->intern(token) : token;
+            }
+        }));
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+    double ingestTime = since(start);
+    long residentGrowth = residentKilobytes() - resident;
+    std::size_t sequences = SuperString::stats().sequenceCount() - sequenceCount;
+
+    SuperString key = kept[tokens.size() / 2];
+    start = std::chrono::steady_clock::now();
+    std::size_t matches = 0;
+    for(const SuperString &string : kept) {
+        matches += string == key;
+    }
+    double matchTime = since(start);
+
+    std::size_t expected = 0;
+    for(const std::string &token : tokens) {
+        expected += token == tokens[tokens.size() / 2];
+    }
+    printf("%-16s %zu tokens: ingest %8.2f ms  resident +%7ld KB  %8zu sequences;  == %6.2f ms\n", name,
+           tokens.size(), ingestTime, residentGrowth, sequences, matchTime);
+    if(matches != expected || kept[7].toStdString() != tokens[7]) {
+        printf("FAILED: %s keeps other contents\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1000000;
+    const char *names[] = {"timestamp", "level", "service", "host", "region", "status", "method", "path",
+                           "user_agent", "content_type", "request_id"};
+    const char *values[] = {"INFO", "WARN", "ERROR", "DEBUG", "GET", "POST", "PUT", "DELETE", "eu-west-1",
+                            "us-east-1", "application/json", "text/html", "200", "404", "500", "checkout",
+                            "inventory", "gateway"};
+    std::vector<std::string> tokens;
+    srand(1);
+    for(std::size_t i = 0; i < count; i++) {
+        tokens.push_back(i % 2 == 0 ? names[(i / 2) % 11] : values[rand() % 18]);
+    }
+    int failed = run("copies", tokens, NULL, 1);
+    {
+        SuperString::InternPool pool;
+        failed = failed || run("strong pool", tokens, &pool, 1);
+    }
+    {
+        SuperString::InternPool pool(true);
+        failed = failed || run("weak pool", tokens, &pool, 1);
+    }
+#ifdef SUPERSTRING_THREAD_SAFE
+    // the default build must not share strings between threads
+    for(std::size_t threadCount = 2; threadCount <= 8; threadCount *= 2) {
+        SuperString::InternPool pool;
+        std::string name = "pool, " + std::to_string(threadCount) + " threads";
+        failed = failed || run(name.c_str(), tokens, &pool, threadCount);
+    }
+#endif
+    return failed;
+}
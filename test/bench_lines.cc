@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The workload of withSS.cc on a generated text: splits it into lines, then
+// joins them back with `+=` and with `+`.
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 200000;
+    srand(42);
+    std::string text;
+    for(std::size_t i = 0; i < count; i++) {
+        std::size_t width = 10 + rand() % 70;
+        for(std::size_t j = 0; j < width; j++) {
+            text += "abcdefghijklmnopqrstuvwxyz     "[rand() % 31];
+        }
+        text += '\n';
+    }
+    SuperString string = SuperString::Copy(text.c_str(), SuperString::Encoding::ASCII);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SuperString> lines;
+    std::size_t last = 0;
+    for(SuperString::Iterator it = string.begin(), end = string.end(); it != end; ++it) {
+        if(*it == '\n') {
+            lines.push_back(string.substring(last, it.index()).ok());
+            last = it.index() + 1;
+        }
+    }
+    double splitTime = since(start);
+
+    SuperString newline = SuperString::Copy("\n", SuperString::Encoding::ASCII);
+    start = std::chrono::steady_clock::now();
+    SuperString appended = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(const SuperString &line : lines) {
+        appended += line;
+        appended += newline;
+    }
+    double appendTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    SuperString concatenated = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(const SuperString &line : lines) {
+        concatenated = concatenated + line + newline;
+    }
+    double concatenateTime = since(start);
+
+    printf("%zu lines: split %8.2f ms  += %8.2f ms  + %8.2f ms\n", lines.size(), splitTime, appendTime,
+           concatenateTime);
+    if(lines.size() != count || appended.toStdString() != text || concatenated.toStdString() != text) {
+        printf("FAILED: the joined lines differ from the text\n");
+        return 1;
+    }
+    return 0;
+}
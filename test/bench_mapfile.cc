@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <chrono>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static long peakKilobytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Loads a text file either by reading it into a buffer and copying it, or by
+// mapping it, then counts its lines chunk by chunk. Run each way in its own
+// process to compare the peak memory:
+//   SuperString.bench.mapfile copy|map [megabytes] [path]
+int main(int argc, char **argv) {
+    bool map = argc > 1 && strcmp(argv[1], "map") == 0;
+    std::size_t megabytes = argc > 2 ? (std::size_t) strtoul(argv[2], NULL, 10) : 256;
+    const char *path = argc > 3 ? argv[3] : "/tmp/superstring_bench_mapfile.txt";
+    FILE *f = fopen(path, "rb");
+    if(f == NULL) {
+        f = fopen(path, "wb");
+        for(std::size_t i = 0; i < megabytes * 1024 * 16; i++) {
+            fputs("The quick brown fox jumps over the lazy dog, again and again.\n", f);
+        }
+    }
+    fclose(f);
+
+    auto start = std::chrono::steady_clock::now();
+    SuperString string;
+    if(map) {
+        string = SuperString::MapFile(path, SuperString::Encoding::ASCII, SuperString::Access::Sequential).ok();
+    } else {
+        f = fopen(path, "rb");
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        char *content = (char *) malloc(size + 1);
+        fread(content, size, 1, f);
+        content[size] = 0;
+        fclose(f);
+        string = SuperString::Copy(content, SuperString::Encoding::ASCII);
+        free(content);
+    }
+    double loadTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    std::size_t lines = 0;
+    string.forEachChunk(0, string.length(), [&lines](const SuperString::Chunk &chunk) {
+        const SuperString::Byte *bytes = chunk.bytes();
+        for(std::size_t i = 0; i < chunk.byteLength(); i++) {
+            lines += bytes[i] == '\n';
+        }
+        return true;
+    });
+    double scanTime = since(start);
+
+    printf("%-4s %zu lines: load %9.2f ms  scan %9.2f ms  peak %8ld KB\n", map ? "map" : "copy", lines, loadTime,
+           scanTime, peakKilobytes());
+    return 0;
+}
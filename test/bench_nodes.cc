@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A request-scoped parse: splits a request into fields and their key/value
+// pairs, trims and joins some of them. Every string created here dies with
+// the request.
+static unsigned long parse(const SuperString &request) {
+    unsigned long sum = 0;
+    std::vector<SuperString> fields;
+    std::size_t last = 0;
+    for(SuperString::Iterator it = request.begin(), end = request.end(); it != end; ++it) {
+        if(*it == '&') {
+            fields.push_back(request.substring(last, it.index()).ok());
+            last = it.index() + 1;
+        }
+    }
+    fields.push_back(request.substring(last, request.length()).ok());
+    SuperString equals = SuperString::Const("=", SuperString::Encoding::ASCII);
+    SuperString joined = SuperString::Const("", SuperString::Encoding::ASCII);
+    for(const SuperString &field : fields) {
+        SuperString::Result<std::size_t, SuperString::Error> at = field.indexOf(equals);
+        if(at.isOk()) {
+            SuperString key = field.substring(0, at.ok()).ok().trim();
+            SuperString value = field.substring(at.ok() + 1, field.length()).ok().trim();
+            joined = joined + key + value;
+            sum += key.length() * 31 + value.length();
+        }
+    }
+    return sum + joined.length();
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 20000;
+    std::vector<SuperString> requests;
+    for(int i = 0; i < 16; i++) {
+        std::string request;
+        for(int j = 0; j < 24; j++) {
+            request += (j == 0 ? "" : "&") + std::string(" key") + std::to_string(i * j) + " = value number " +
+                       std::to_string(j * 7919 % 1000) + " ";
+        }
+        requests.push_back(SuperString::Copy(request.c_str(), SuperString::Encoding::ASCII));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned long sum = 0;
+    for(std::size_t i = 0; i < count; i++) {
+        sum += parse(requests[i % requests.size()]);
+    }
+    double parseTime = since(start);
+
+    // nothing but the nodes of substrings and of their concatenation, made and freed
+    SuperString text = SuperString::Copy(std::string(4000, 'x').c_str(), SuperString::Encoding::ASCII);
+    start = std::chrono::steady_clock::now();
+    std::size_t length = 0;
+    for(std::size_t i = 0; i < count * 100; i++) {
+        SuperString left = text.substring(i % 1000, i % 1000 + 100).ok();
+        SuperString right = text.substring(i % 700, i % 700 + 200).ok();
+        length += (left + right).length();
+    }
+    double nodeTime = since(start);
+
+    printf("%zu requests: %8.2f ms (checksum %lu), %zu concatenated substrings: %8.2f ms\n", count, parseTime, sum,
+           count * 100, nodeTime);
+    if(length != count * 100 * 300) {
+        printf("FAILED: the concatenations hold %zu code units instead of %zu\n", length, count * 100 * 300);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Compares two equal strings of different storage, then the same with their
+// last code unit changed, [rounds] times each.
+static int run(const char *name, const SuperString &string, const SuperString &equal, const SuperString &different,
+               int rounds) {
+    auto start = std::chrono::steady_clock::now();
+    int equals = 0;
+    for(int i = 0; i < rounds; i++) {
+        equals += string == equal;
+    }
+    double equalTime = since(start) / rounds;
+
+    start = std::chrono::steady_clock::now();
+    int before = 0;
+    for(int i = 0; i < rounds; i++) {
+        before += different.compareTo(string) < 0;
+    }
+    double compareTime = since(start) / rounds;
+
+    printf("%-14s %8zu code units: == %8.3f ms  compareTo %8.3f ms\n", name, string.length(), equalTime,
+           compareTime);
+    if(equals != rounds || before != rounds) {
+        printf("FAILED: %s compares wrongly\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::size_t megabytes = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    std::string ascii, utf8;
+    while(ascii.size() < megabytes << 20) {
+        ascii += "The quick brown fox jumps over the lazy dog.\n";
+    }
+    while(utf8.size() < megabytes << 20) {
+        utf8 += "Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr pr\xc3\xa9" "f\xc3\xa8re \xe4\xb8\x96.\n";
+    }
+    std::string asciiChanged = ascii.substr(0, ascii.size() - 1) + "\t";
+    std::string utf8Changed = utf8.substr(0, utf8.size() - 1) + "\t";
+
+    SuperString flat = SuperString::Copy(ascii.c_str(), SuperString::Encoding::ASCII);
+    SuperString rope = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t at = 0; at < ascii.size(); at += 4096) {
+        rope += SuperString::Copy(ascii.substr(at, 4096).c_str(), SuperString::Encoding::ASCII);
+    }
+    SuperString text = SuperString::Copy(utf8.c_str());
+    int failed = run("ascii", flat, SuperString::Copy(ascii.c_str(), SuperString::Encoding::ASCII),
+                     SuperString::Copy(asciiChanged.c_str(), SuperString::Encoding::ASCII), rounds) ||
+                 run("ascii/rope", flat, rope, SuperString::Copy(asciiChanged.c_str(), SuperString::Encoding::ASCII),
+                     rounds) ||
+                 run("ascii/utf32", flat, flat.flatten(SuperString::Encoding::UTF32).ok(),
+                     SuperString::Copy(asciiChanged.c_str()).flatten(SuperString::Encoding::UTF32).ok(), rounds) ||
+                 run("utf8", text, SuperString::Copy(utf8.c_str()), SuperString::Copy(utf8Changed.c_str()), rounds) ||
+                 run("utf8/utf16be", text, text.flatten(SuperString::Encoding::UTF16BE).ok(),
+                     SuperString::Copy(utf8Changed.c_str()).flatten(SuperString::Encoding::UTF16BE).ok(), rounds);
+    if(failed) {
+        return 1;
+    }
+
+    // words of the text, sorted and counted in an ordered map
+    std::vector<SuperString> words;
+    std::size_t last = 0;
+    for(std::size_t i = 0; i < ascii.size(); i++) {
+        if(ascii[i] == ' ' || ascii[i] == '\n') {
+            words.push_back(flat.substring(last, i).ok());
+            last = i + 1;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::sort(words.begin(), words.end());
+    double sortTime = since(start);
+    start = std::chrono::steady_clock::now();
+    std::map<SuperString, int> counts;
+    for(const SuperString &word : words) {
+        counts[word]++;
+    }
+    double mapTime = since(start);
+    printf("%zu words: sort %8.2f ms  map %8.2f ms (%zu distinct)\n", words.size(), sortTime, mapTime,
+           counts.size());
+    if(counts.size() != 9 || !std::is_sorted(words.begin(), words.end())) {
+        printf("FAILED: the words are not counted\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Slices a large text into substrings, releases the text so that every slice
+// is reconstructed, then reads the slices back.
+static int run(const char *name, const std::string &text, std::size_t sliceLength) {
+    SuperString string = SuperString::Copy(text.c_str());
+    std::size_t length = string.length();
+    std::vector<SuperString> slices;
+    std::size_t expected = 0;
+    for(std::size_t start = 0; start + sliceLength <= length; start += sliceLength * 8) {
+        slices.push_back(string.substring(start, start + sliceLength).ok());
+        expected += sliceLength;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    string = SuperString();
+    double releaseTime = since(start);
+
+    std::size_t kept = 0;
+    for(const SuperString &slice : slices) {
+        kept += slice.keepingCost();
+    }
+
+    start = std::chrono::steady_clock::now();
+    unsigned long sum = 0;
+    for(const SuperString &slice : slices) {
+        for(int codeUnit : slice) {
+            sum += (unsigned long) codeUnit;
+        }
+        sum += (unsigned long) slice.codeUnitAt(sliceLength / 2).ok();
+    }
+    double readTime = since(start);
+
+    std::size_t size = 0;
+    for(const SuperString &slice : slices) {
+        size += slice.toStdString().size();
+    }
+    printf("%-6s %zu code units: keeps %10zu bytes (%5.2f per code unit)  release %8.2f ms  read %8.2f ms  (%lu)\n",
+           name, expected, kept, (double) kept / expected, releaseTime, readTime, sum);
+    if(size == 0) {
+        printf("FAILED: the slices are empty\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Grows a string with `s = s + piece`, each released prefix being referenced by
+// the concatenation that replaces it. Returns the time per append in
+// nanoseconds, and the reconstructions it caused in [reconstructions].
+static double append(const std::vector<SuperString> &pieces, std::size_t count, std::size_t &reconstructions) {
+    std::size_t before = SuperString::stats().reconstructionCount();
+    auto start = std::chrono::steady_clock::now();
+    SuperString string = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < count; i++) {
+        string = string + pieces[i % pieces.size()];
+    }
+    double time = since(start) * 1e6 / count;
+    reconstructions = SuperString::stats().reconstructionCount() - before;
+    std::size_t length = 0;
+    for(std::size_t i = 0; i < count; i++) {
+        length += pieces[i % pieces.size()].length();
+    }
+    return string.length() == length ? time : -1;
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 4000000;
+    std::string ascii, bmp, astral;
+    for(std::size_t i = 0; i < count; i++) {
+        ascii += "The quick brown fox jumps over the lazy dog. "[i % 45];
+    }
+    for(std::size_t i = 0; i < count; i++) {
+        bmp += (i % 5 == 0) ? "\xc3\xa9" : (i % 5 == 1 ? "\xe4\xb8\x96" : "a");
+    }
+    for(std::size_t i = 0; i < count; i++) {
+        astral += (i % 4 == 0) ? "\xf0\x9f\x98\x80" : "b";
+    }
+    if(run("ascii", ascii, 1000) || run("bmp", bmp, 1000) || run("astral", astral, 1000)) {
+        return 1;
+    }
+
+    // appends must not repack the prefix they grow, so their cost does not depend on the length
+    SuperString text = SuperString::Copy(ascii.c_str());
+    std::vector<SuperString> pieces;
+    for(std::size_t i = 0; i < 1000; i++) {
+        std::size_t start = (i * 7919) % (count - 200);
+        pieces.push_back(text.substring(start, start + 130 + i % 70).ok());
+    }
+    std::size_t appends = count / 40, shortReconstructions, longReconstructions;
+    double shortTime = append(pieces, appends, shortReconstructions);
+    double longTime = append(pieces, 4 * appends, longReconstructions);
+    printf("append %zu pieces: %8.2f ns/append, %zu reconstructions\n", appends, shortTime, shortReconstructions);
+    printf("append %zu pieces: %8.2f ns/append, %zu reconstructions\n", 4 * appends, longTime, longReconstructions);
+    if(shortTime < 0 || longTime < 0) {
+        printf("FAILED: the appended string has the wrong length\n");
+        return 1;
+    }
+    if(longTime > 3 * shortTime) {
+        printf("FAILED: the cost of an append grows with the length of the string\n");
+        return 1;
+    }
+    return 0;
+}
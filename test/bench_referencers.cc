@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Takes [count] substrings of a hot base string then destructs them in a random
+// order, once while the base is held and once after it was released, in which
+// case every destruction weighs freeing the base against keeping it.
+static int run(const char *name, bool isBaseHeld, std::size_t count) {
+    std::string text;
+    for(std::size_t i = 0; i < count + 64; i++) {
+        text += "abcdefghijklmnopqrstuvwxyz"[i % 26];
+    }
+    SuperString base = SuperString::Copy(text.c_str(), SuperString::Encoding::ASCII);
+    std::vector<SuperString> substrings;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < count; i++) {
+        substrings.push_back(base.substring(i, i + 64).ok());
+    }
+    double createTime = since(start);
+    if(!isBaseHeld) {
+        base = SuperString();
+    }
+    std::shuffle(substrings.begin(), substrings.end(), std::mt19937(42));
+
+    start = std::chrono::steady_clock::now();
+    std::size_t length = 0;
+    while(!substrings.empty()) {
+        length += substrings.back().length();
+        substrings.pop_back();
+    }
+    double destructTime = since(start);
+    SuperString::Stats stats = SuperString::stats();
+    printf("%-8s %zu substrings: create %9.2f ms  destruct %9.2f ms  (%zu kept, %zu reconstructions so far)\n",
+           name, count, createTime, destructTime, stats.retentionCount(), stats.reconstructionCount());
+    if(length != count * 64) {
+        printf("FAILED: the substrings have %zu code units instead of %zu\n", length, count * 64);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 100000;
+    return run("held", true, count) || run("released", false, count);
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Loads [count] documents, keeps slices of each one and releases the documents,
+// under a retention policy: the time spent releasing is what the destruction
+// path pays in reconstructions, the retained bytes what memory pays instead.
+static int run(const char *name, SuperString::RetentionPolicy &policy, std::size_t count,
+               std::size_t sliceCount) {
+    SuperString::retentionPolicy(policy);
+    std::string text;
+    while(text.size() < 65536) {
+        text += "The quick brown fox jumps over the lazy dog. ";
+    }
+    SuperString::Stats before = SuperString::stats();
+    std::vector<SuperString> slices;
+    double releaseTime = 0;
+    double worstRelease = 0;
+    for(std::size_t i = 0; i < count; i++) {
+        SuperString document = SuperString::Copy(text.c_str(), SuperString::Encoding::ASCII);
+        for(std::size_t j = 0; j < sliceCount; j++) {
+            std::size_t start = (j * 7919) % (text.size() - 256);
+            slices.push_back(document.substring(start, start + 256).ok());
+        }
+        auto start = std::chrono::steady_clock::now();
+        document = SuperString();
+        double time = since(start);
+        releaseTime += time;
+        worstRelease = time > worstRelease ? time : worstRelease;
+    }
+    SuperString::Stats after = SuperString::stats();
+    std::size_t length = 0;
+    for(const SuperString &slice : slices) {
+        length += slice.length();
+    }
+    printf("%-13s release %8.2f ms (worst %6.3f ms)  retained %10zu bytes  reconstructed %10zu bytes\n", name,
+           releaseTime, worstRelease, after.retainedBytes(), after.reconstructedBytes() - before.reconstructedBytes());
+    if(length != count * sliceCount * 256) {
+        printf("FAILED: the slices have %zu code units instead of %zu\n", length, count * sliceCount * 256);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1000;
+    SuperString::RetentionPolicy::CostBased costBased;
+    SuperString::RetentionPolicy::AlwaysKeep alwaysKeep;
+    SuperString::RetentionPolicy::Threshold threshold(1 << 20);
+    SuperString::RetentionPolicy::MemoryBudget memoryBudget(16 << 20);
+    int failed = run("cost-based", costBased, count, 200) || run("always-keep", alwaysKeep, count, 200) ||
+                 run("threshold", threshold, count, 200) || run("memory-budget", memoryBudget, count, 200);
+    SuperString::retentionPolicy(costBased);
+    return failed;
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Searches the whole haystack with std::string and with SuperString, forward for
+// the [tail] needle that ends it, and backward for the [head] needle that starts it.
+static bool measure(const char *name, const std::string &text, const SuperString &string, const std::string &head,
+                    const std::string &tail, std::size_t tailIndex, int rounds) {
+    SuperString headPattern = SuperString::Copy(head.c_str());
+    SuperString tailPattern = SuperString::Copy(tail.c_str());
+    std::size_t expected = 0, found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; round++) {
+        expected += text.find(tail);
+    }
+    double findTime = since(start);
+    start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; round++) {
+        found += string.indexOf(tailPattern).ok();
+    }
+    double indexOfTime = since(start);
+    start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; round++) {
+        expected += text.rfind(head);
+    }
+    double rfindTime = since(start);
+    start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; round++) {
+        found += string.lastIndexOf(headPattern).ok();
+    }
+    double lastIndexOfTime = since(start);
+    printf("%-5s find %7.2f ms  indexOf %7.2f ms  rfind %7.2f ms  lastIndexOf %7.2f ms (%zu)\n", name, findTime,
+           indexOfTime, rfindTime, lastIndexOfTime, expected);
+    return found == rounds * tailIndex;
+}
+
+int main(int argc, char **argv) {
+    std::size_t size = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1 << 22;
+    srand(42);
+    std::string head = "the needle at the head";
+    std::string tail = "the needle at the tail";
+    std::string text = head;
+    for(std::size_t i = 0; i < size; i++) {
+        text += "abcdefghijklmnopqrstuvwxyz      "[rand() % 32];
+    }
+    text += tail;
+    std::string utf8 = head;
+    for(std::size_t i = 0; i < size / 8; i++) {
+        utf8 += (rand() % 4 == 0) ? "\xc3\xa9t\xc3\xa9 the " : "summer  ";
+    }
+    utf8 += tail;
+    SuperString flatUTF8 = SuperString::Copy(utf8.c_str());
+    SuperString rope = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < text.size(); i += 1000) {
+        rope = rope + SuperString::Copy(text.substr(i, 1000).c_str(), SuperString::Encoding::ASCII);
+    }
+
+    bool isOk = true;
+    isOk &= measure("ascii", text, SuperString::Const(text.c_str(), SuperString::Encoding::ASCII), head, tail,
+                    text.size() - tail.size(), 10);
+    isOk &= measure("utf8", utf8, flatUTF8, head, tail, flatUTF8.length() - tail.size(), 10);
+    isOk &= measure("rope", text, rope, head, tail, text.size() - tail.size(), 10);
+    if(!isOk) {
+        printf("FAILED: wrong positions\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Reads [string] through random accesses.
+static unsigned long read(const SuperString &string, double &accessTime) {
+    std::size_t length = string.length();
+    auto start = std::chrono::steady_clock::now();
+    unsigned long sum = 0;
+    std::size_t index = 0;
+    for(int i = 0; i < 100000; i++) {
+        index = (index * 1103515245 + 12345) % length;
+        sum += (unsigned long) string.codeUnitAt(index).ok();
+    }
+    accessTime = since(start);
+    return sum;
+}
+
+// Edits [string] in place again and again, each edit splicing a word between
+// two slices of the previous version, and reads it after a growing number of
+// edits. Random access should cost about the same however many times the
+// string was sliced.
+static int run(const char *name, SuperString string, std::size_t edits) {
+    SuperString word = SuperString::Copy("<edit>", SuperString::Encoding::ASCII);
+    std::vector<int> reference;
+    for(int codeUnit : string) {
+        reference.push_back(codeUnit);
+    }
+    std::size_t done = 0;
+    for(std::size_t count = 1; count <= edits; count *= 10) {
+        auto start = std::chrono::steady_clock::now();
+        for(; done < count; done++) {
+            std::size_t at = (done * 7919) % (string.length() - 8);
+            string = string.substring(0, at).ok() + word + string.substring(at + 4, string.length()).ok();
+            reference.erase(reference.begin() + at, reference.begin() + at + 4);
+            reference.insert(reference.begin() + at, word.begin(), word.end());
+        }
+        double editTime = since(start);
+        double accessTime;
+        read(string, accessTime);
+        printf("%-6s after %5zu edits: edit %8.2f ms  random access %8.2f ms\n", name, done, editTime, accessTime);
+    }
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    if(codeUnits != reference) {
+        printf("FAILED: the %s string differs from the reference\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::size_t edits = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1000;
+    std::vector<SuperString> sources;
+    for(int i = 0; i < 4; i++) {
+        std::string text;
+        while(text.size() < (1 << 16)) {
+            text += i % 2 == 0 ? "The quick brown fox jumps over the lazy dog. " : "Voix ambigu\xc3\xab d'un c\xc5\x93ur. ";
+        }
+        sources.push_back(SuperString::Copy(text.c_str()));
+    }
+    SuperString rope = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t i = 0; i < 2000; i++) {
+        const SuperString &source = sources[i % sources.size()];
+        std::size_t start = (i * 7919) % (source.length() - 300);
+        rope = rope + source.substring(start, start + 150 + i % 150).ok();
+    }
+    SuperString repeat = sources[1].substring(0, 1000).ok() * 100;
+    if(run("flat", sources[0], edits) || run("rope", rope, edits) || run("repeat", repeat, edits)) {
+        return 1;
+    }
+    // without reconstructions, nothing flattens the slices behind the edits
+    printf("never reconstructing:\n");
+    SuperString::RetentionPolicy::AlwaysKeep alwaysKeep;
+    SuperString::retentionPolicy(alwaysKeep);
+    return run("flat", sources[0], edits) || run("rope", rope, edits) || run("repeat", repeat, edits);
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "SuperString.hh"
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// copies and releases handles on a shared string, builds a rope by appending
+// and reads it at pseudo random indexes
+static unsigned long work(const SuperString &shared, const std::vector<SuperString> &pieces, std::size_t rounds,
+                          double *times) {
+    unsigned long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t round = 0; round < rounds * 100; round++) {
+        SuperString copy = shared;
+        sum += copy.length();
+    }
+    times[0] += since(start);
+    start = std::chrono::steady_clock::now();
+    SuperString rope = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(std::size_t round = 0; round < rounds; round++) {
+        rope = rope + pieces[round % pieces.size()];
+    }
+    times[1] += since(start);
+    start = std::chrono::steady_clock::now();
+    std::size_t length = rope.length();
+    for(std::size_t round = 0; round < rounds * 10; round++) {
+        sum += (unsigned long) rope.codeUnitAt((round * 104729) % length).ok();
+    }
+    times[2] += since(start);
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    std::size_t rounds = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 20000;
+#ifdef SUPERSTRING_THREAD_SAFE
+    printf("thread-safe build\n");
+#else
+    printf("default build\n");
+#endif
+    SuperString shared = SuperString::Copy("The quick brown fox jumps over the lazy dog, "
+                                           "Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr pr\xc3\xa9"
+                                           "f\xc3\xa8re.");
+    std::vector<SuperString> pieces;
+    // ASCII slices of the shared text
+    for(std::size_t i = 0; i < 20; i++) {
+        pieces.push_back(SuperString::Copy(shared.toStdString().substr(i, 32).c_str()));
+    }
+    unsigned long expected = 0;
+#ifdef SUPERSTRING_THREAD_SAFE
+    std::size_t maxThreadCount = 8;
+#else
+    // the default build must not share strings between threads
+    std::size_t maxThreadCount = 1;
+#endif
+    for(std::size_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2) {
+        std::vector<unsigned long> sums(threadCount);
+        std::vector<std::vector<double>> times(threadCount, std::vector<double>(3, 0.0));
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t i = 0; i < threadCount; i++) {
+            threads.push_back(std::thread([&sums, &times, &shared, &pieces, rounds, i]() {
+                sums[i] = work(shared, pieces, rounds, &times[i][0]);
+            }));
+        }
+        for(std::thread &thread : threads) {
+            thread.join();
+        }
+        double wall = since(start);
+        double copy = 0, append = 0, access = 0;
+        for(std::size_t i = 0; i < threadCount; i++) {
+            copy += times[i][0] / threadCount;
+            append += times[i][1] / threadCount;
+            access += times[i][2] / threadCount;
+            if(expected == 0) {
+                expected = sums[i];
+            } else if(sums[i] != expected) {
+                printf("FAILED: thread %zu computed %lu instead of %lu\n", i, sums[i], expected);
+                return 1;
+            }
+        }
+        printf("%zu threads: copy %8.2f ms  append %8.2f ms  codeUnitAt %8.2f ms  wall %8.2f ms\n", threadCount,
+               copy, append, access, wall);
+    }
+    return 0;
+}
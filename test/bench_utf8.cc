@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "SuperString.hh"
+
+// Validates [text] [rounds] times and prints the throughput, returns 1 if the
+// length is not [length].
+static int run(const char *name, const std::string &text, std::size_t length, int rounds) {
+    std::size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < rounds; i++) {
+        total += SuperString::validate(text.c_str()).ok();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("%-10s %8zu bytes: %6.2f GB/s\n", name, text.size(), (double) text.size() * rounds / seconds / 1e9);
+    if(total != length * rounds) {
+        printf("FAILED: %s validated to %zu code points instead of %zu\n", name, total / rounds, length);
+        return 1;
+    }
+    return 0;
+}
+
+// Validates megabytes of ASCII, of two-, three- and four-byte sequences, and of
+// a mix of them all.
+int main(int argc, char **argv) {
+    std::size_t count = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 1000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    const char *samples[] = {"The quick brown fox jumps over the lazy dog. ",
+                             "\xd0\xa1\xd1\x8a\xd0\xb5\xd1\x88\xd1\x8c \xd0\xb6\xd0\xb5 \xd0\xb5\xd1\x89\xd1\x91 ",
+                             "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87\xe7\xab\xa0\xe3\x80\x82",
+                             "\xf0\x9f\x98\x80\xf0\x9f\x8e\x89\xf0\x9f\x9a\x80\xf0\x9f\x8c\x8d",
+                             "Voix ambigu\xc3\xab d'un c\xc5\x93ur qui au z\xc3\xa9phyr \xe6\x97\xa5\xf0\x9f\x98\x80 "};
+    const char *names[] = {"ascii", "cyrillic", "cjk", "emoji", "mixed"};
+    for(int k = 0; k < 5; k++) {
+        std::string text;
+        while(text.size() < count) {
+            text += samples[k];
+        }
+        std::size_t length = SuperString::Copy(samples[k]).length() * (text.size() / strlen(samples[k]));
+        if(run(names[k], text, length, rounds)) {
+            return 1;
+        }
+    }
+    return 0;
+}
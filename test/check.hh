@@ -0,0 +1,18 @@
+#ifndef BOUTGLAY_SUPERSTRING_TEST_CHECK_HEADER
+#define BOUTGLAY_SUPERSTRING_TEST_CHECK_HEADER
+
+#include <stdio.h>
+
+/**
+ * Prints the failed [condition] and returns 1 from the enclosing function,
+ * the exit status of a failed test.
+ */
+#define CHECK(condition)                                                                 \
+    do {                                                                                 \
+        if(!(condition)) {                                                               \
+            printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #condition);               \
+            return 1;                                                                    \
+        }                                                                                \
+    } while(0)
+
+#endif
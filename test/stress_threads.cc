@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "SuperString.hh"
+
+// Shares immutable strings of every kind between threads that copy, slice,
+// concatenate, append to, search and read them, and release the last handles
+// concurrently. Meant to be built with SUPERSTRING_THREAD_SAFE and run under
+// ThreadSanitizer.
+
+static unsigned long checksum(const SuperString &string) {
+    unsigned long sum = 0;
+    for(int codeUnit : string) {
+        sum = sum * 31 + (unsigned long) codeUnit;
+    }
+    return sum;
+}
+
+static unsigned long work(std::vector<SuperString> shared, std::size_t seed, std::size_t rounds) {
+    unsigned long sum = 0;
+    for(std::size_t round = 0; round < rounds; round++) {
+        const SuperString &string = shared[(seed + round) % shared.size()];
+        std::size_t length = string.length();
+        // reads, which build offset indexes lazily on first access
+        std::size_t index = (seed * 7919 + round * 104729) % length;
+        sum += (unsigned long) string.codeUnitAt(index).ok();
+        sum += string.indexOf(SuperString::Copy("fox")).isOk() ? 1 : 0;
+        // new strings sharing the same sequences
+        SuperString slice = string.substring(index / 2, index).ok();
+        SuperString joined = slice + shared[round % shared.size()] + slice;
+        sum += checksum(joined) % 1000;
+        sum += joined.toStdString().size();
+        // appended in place while this thread holds the only handle, from pieces other threads hold too
+        SuperString grown = SuperString::Copy(">> ");
+        for(std::size_t i = 0; i < 4; i++) {
+            grown += shared[(round + i) % shared.size()].substring(i, i + 12).ok();
+            grown += slice;
+        }
+        sum += checksum(grown) % 1000;
+    }
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    std::size_t threadCount = argc > 1 ? (std::size_t) strtoul(argv[1], NULL, 10) : 8;
+    std::size_t rounds = argc > 2 ? (std::size_t) strtoul(argv[2], NULL, 10) : 200;
+    std::vector<SuperString> shared;
+    std::string text;
+    for(int i = 0; i < 40; i++) {
+        text += "The quick brown fox jumps over the lazy dog, d\xc3\xa9j\xc3\xa0 vu. ";
+    }
+    shared.push_back(SuperString::Const(text.c_str()));
+    shared.push_back(SuperString::Copy(text.c_str()));
+    shared.push_back(SuperString::Copy(text.c_str()).substring(10, 900).ok());
+    shared.push_back(SuperString::Copy("fox and hound ") * 50);
+    SuperString rope = SuperString::Copy("", SuperString::Encoding::ASCII);
+    for(int i = 0; i < 200; i++) {
+        rope = rope + shared[i % 4].substring(i, i + 150).ok();
+    }
+    shared.push_back(rope);
+
+    // the expected results, before any offset index exists
+    std::vector<unsigned long> expected;
+    for(std::size_t i = 0; i < threadCount; i++) {
+        std::vector<SuperString> copies;
+        for(const SuperString &string : shared) {
+            copies.push_back(SuperString::Copy(string.toStdString().c_str()));
+        }
+        expected.push_back(work(copies, i, rounds));
+    }
+
+    std::vector<unsigned long> results(threadCount);
+    std::vector<std::thread> threads;
+    for(std::size_t i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread([&results, shared, i, rounds]() {
+            results[i] = work(shared, i, rounds);
+        }));
+    }
+    // the workers now hold the last handles, they release them concurrently
+    shared.clear();
+    rope = SuperString::Copy("");
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+    for(std::size_t i = 0; i < threadCount; i++) {
+        if(results[i] != expected[i]) {
+            printf("FAILED: thread %zu computed %lu instead of %lu\n", i, results[i], expected[i]);
+            return 1;
+        }
+    }
+    printf("%zu threads x %zu rounds: OK\n", threadCount, rounds);
+    return 0;
+}
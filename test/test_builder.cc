@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+static std::string utf8(const SuperString &string) {
+    std::string bytes;
+    for(int codeUnit : string) {
+        if(codeUnit < 0x80) {
+            bytes += (char) codeUnit;
+        } else if(codeUnit < 0x800) {
+            bytes += (char) (0xc0 | (codeUnit >> 6));
+            bytes += (char) (0x80 | (codeUnit & 0x3f));
+        } else if(codeUnit < 0x10000) {
+            bytes += (char) (0xe0 | (codeUnit >> 12));
+            bytes += (char) (0x80 | ((codeUnit >> 6) & 0x3f));
+            bytes += (char) (0x80 | (codeUnit & 0x3f));
+        } else {
+            bytes += (char) (0xf0 | (codeUnit >> 18));
+            bytes += (char) (0x80 | ((codeUnit >> 12) & 0x3f));
+            bytes += (char) (0x80 | ((codeUnit >> 6) & 0x3f));
+            bytes += (char) (0x80 | (codeUnit & 0x3f));
+        }
+    }
+    return bytes;
+}
+
+// Input fed to a builder in random fragments, cutting multi-byte sequences and
+// mixed with whole strings and single code units, builds the same string as the
+// concatenated input.
+int main() {
+    srand(13);
+    const char *words[] = {"plain ", "caf\xc3\xa9 ", "\xe4\xb8\x96\xe7\x95\x8c ", "\xf0\x9f\x98\x80", "x"};
+    std::size_t capacities[] = {4, 16, 100, SuperString::Builder::DefaultChunkCapacity};
+    for(int round = 0; round < 200; round++) {
+        SuperString::Builder builder(capacities[round % 4]);
+        std::string expected;
+        std::string input;
+        for(int i = rand() % 2000; i > 0; i--) {
+            input += words[rand() % 5];
+        }
+        std::size_t length = 0;
+        for(std::size_t offset = 0; offset < input.size();) {
+            std::size_t byteLength = std::min<std::size_t>(input.size() - offset, 1 + rand() % 50);
+            CHECK(builder.append(input.c_str() + offset, byteLength).ok());
+            expected.append(input, offset, byteLength);
+            offset += byteLength;
+            switch(rand() % 8) {
+                case 0:
+                    // only between whole sequences
+                    if(SuperString::validate(expected.c_str()).isOk()) {
+                        SuperString string = SuperString::Copy("a whole string w\xc3\xb6rth appending");
+                        CHECK(builder.append(string).ok());
+                        expected += "a whole string w\xc3\xb6rth appending";
+                    }
+                    break;
+                case 1:
+                    if(SuperString::validate(expected.c_str()).isOk()) {
+                        CHECK(builder.appendCodeUnit(0x1f601).ok());
+                        expected += "\xf0\x9f\x98\x81";
+                    }
+                    break;
+                default:
+                    break;
+            }
+            length = builder.length();
+        }
+        SuperString built = builder.build().ok();
+        CHECK(built.length() == length && SuperString::validate(expected.c_str()).ok() == length);
+        CHECK(utf8(built) == expected && builder.length() == 0);
+        if(!built.isEmpty()) {
+            CHECK(built.codeUnitAt(built.length() - 1).isOk() && built.codeUnitAt(built.length()).isErr());
+        }
+    }
+
+    SuperString::Builder builder;
+    CHECK(builder.append("ab\xc3", 3).ok() && builder.build().err() == SuperString::Error::InvalidByteSequence);
+    CHECK(builder.append("ab\xff", 3).err() == SuperString::Error::InvalidByteSequence);
+    CHECK(utf8(builder.build().ok()) == "ab");
+    CHECK(builder.appendCodeUnit(0xd800).err() == SuperString::Error::Unencodable);
+    CHECK(builder.build().ok().isEmpty());
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// compareTo and the comparison operators order strings by code units, whatever
+// their encodings and shapes, like vectors of code units do.
+int main() {
+    srand(7);
+    const char *texts[] = {"abc\xee\x80\x80x", "abc\xf0\x90\x80\x80x", "abc", "abcd", "ab\xc3\xa9", "abc\xe4\xb8\x96",
+                           "abcabcabc"};
+    const int lone[] = {'a', 'b', 'c', 0xd800, 'x', 0};
+    Encoding encodings[] = {Encoding::ASCII, Encoding::UTF8, Encoding::UTF16BE, Encoding::UTF32};
+    for(int round = 0; round < 60; round++) {
+        std::vector<SuperString> strings;
+        for(const char *text : texts) {
+            strings.push_back(SuperString::Copy(text));
+        }
+        strings.push_back(SuperString::Copy("abcabc", Encoding::ASCII));
+        strings.push_back(SuperString::Const("abcab", Encoding::ASCII));
+        strings.push_back(SuperString::Copy(lone));
+        for(int step = 0; step < 40; step++) {
+            const SuperString &string = strings[rand() % strings.size()];
+            const SuperString &other = strings[rand() % strings.size()];
+            switch(rand() % 4) {
+                case 0:
+                    strings.push_back(string + other);
+                    break;
+                case 1:
+                    strings.push_back(string.length() < 3000 ? string * (1 + rand() % 7) : string);
+                    break;
+                case 2: {
+                    SuperString::Result<SuperString, SuperString::Error> flat = string.flatten(encodings[rand() % 4]);
+                    strings.push_back(flat.isOk() ? flat.ok() : string);
+                    break;
+                }
+                default: {
+                    std::size_t length = string.length();
+                    std::size_t start = rand() % (length / 4 + 1);
+                    strings.push_back(string.substring(start, length - rand() % (length / 4 + 1)).ok());
+                    break;
+                }
+            }
+        }
+        std::vector<std::vector<int> > expected;
+        for(const SuperString &string : strings) {
+            expected.push_back(codeUnits(string));
+        }
+        for(std::size_t i = 0; i < strings.size(); i++) {
+            for(std::size_t j = 0; j < strings.size(); j++) {
+                int order = expected[i] < expected[j] ? -1 : (expected[j] < expected[i] ? 1 : 0);
+                int comparison = strings[i].compareTo(strings[j]);
+                CHECK((comparison < 0 ? -1 : (comparison > 0 ? 1 : 0)) == order);
+                CHECK((strings[i] == strings[j]) == (order == 0) && (strings[i] != strings[j]) == (order != 0));
+                CHECK((strings[i] < strings[j]) == (order < 0) && (strings[i] <= strings[j]) == (order <= 0));
+                CHECK((strings[i] > strings[j]) == (order > 0) && (strings[i] >= strings[j]) == (order >= 0));
+            }
+        }
+        CHECK(std::set<SuperString>(strings.begin(), strings.end()).size() ==
+              std::set<std::vector<int> >(expected.begin(), expected.end()).size());
+    }
+
+    // code unit order, not UTF-16 order: a surrogate pair sorts after U+E000
+    CHECK(SuperString::Copy("\xee\x80\x80").flatten(Encoding::UTF16BE).ok() <
+          SuperString::Copy("\xf0\x90\x80\x80").flatten(Encoding::UTF16BE).ok());
+    CHECK(SuperString() == SuperString::Copy("") && SuperString() < SuperString::Copy("a"));
+
+    // long runs, compared block by block across encodings
+    std::string text;
+    for(int i = 0; i < 100000; i++) {
+        text += "The quick brown fox "[i % 20];
+    }
+    std::string changed = text;
+    changed[77777] = 'Z';
+    SuperString string = SuperString::Copy(text.c_str(), Encoding::ASCII);
+    for(Encoding encoding : encodings) {
+        SuperString flat = string.flatten(encoding).ok();
+        SuperString other = SuperString::Copy(changed.c_str(), Encoding::ASCII).flatten(encoding).ok();
+        CHECK(string == flat && flat == string);
+        CHECK(other < flat && string > other && string != other);
+    }
+    printf("ok\n");
+    return 0;
+}
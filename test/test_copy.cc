@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+// Appends [codeUnit] to [bytes] in [encoding], returns false if it does not fit.
+static bool encode(int codeUnit, Encoding encoding, std::string &bytes) {
+    switch(encoding) {
+        case Encoding::ASCII:
+        case Encoding::Latin1:
+            bytes += (char) codeUnit;
+            return codeUnit <= 0xff;
+        case Encoding::UTF8:
+            if(codeUnit < 0x80) {
+                bytes += (char) codeUnit;
+            } else if(codeUnit < 0x800) {
+                bytes += (char) (0xc0 | (codeUnit >> 6));
+                bytes += (char) (0x80 | (codeUnit & 0x3f));
+            } else if(codeUnit < 0x10000) {
+                bytes += (char) (0xe0 | (codeUnit >> 12));
+                bytes += (char) (0x80 | ((codeUnit >> 6) & 0x3f));
+                bytes += (char) (0x80 | (codeUnit & 0x3f));
+            } else {
+                bytes += (char) (0xf0 | (codeUnit >> 18));
+                bytes += (char) (0x80 | ((codeUnit >> 12) & 0x3f));
+                bytes += (char) (0x80 | ((codeUnit >> 6) & 0x3f));
+                bytes += (char) (0x80 | (codeUnit & 0x3f));
+            }
+            return true;
+        case Encoding::UTF16BE:
+            if(codeUnit >= 0x10000) {
+                int high = 0xd800 + ((codeUnit - 0x10000) >> 10);
+                bytes += (char) (high >> 8);
+                bytes += (char) (high & 0xff);
+                codeUnit = 0xdc00 + ((codeUnit - 0x10000) & 0x3ff);
+            }
+            bytes += (char) (codeUnit >> 8);
+            bytes += (char) (codeUnit & 0xff);
+            return true;
+        case Encoding::UTF16LE:
+            if(codeUnit >= 0x10000) {
+                int high = 0xd800 + ((codeUnit - 0x10000) >> 10);
+                bytes += (char) (high & 0xff);
+                bytes += (char) (high >> 8);
+                codeUnit = 0xdc00 + ((codeUnit - 0x10000) & 0x3ff);
+            }
+            bytes += (char) (codeUnit & 0xff);
+            bytes += (char) (codeUnit >> 8);
+            return true;
+        default:
+            bytes.append((const char *) &codeUnit, sizeof(int));
+            return true;
+    }
+}
+
+// copyTo writes any range of any string in any encoding, and Latin-1 bytes of
+// ASCII strings come out transcoded. What it writes reads back the same.
+int main() {
+    srand(3);
+    const int utf32[] = {'H', 0xe9, 0x4e16, 0x1f600, ' ', 'w', 0};
+    const SuperString::Byte utf16be[] = {0x00, 0x48, 0x00, 0xe9, 0x4e, 0x16, 0xd8, 0x3d, 0xde, 0x00, 0x00, 0x21,
+                                         0x00, 0x00};
+    SuperString parts[] = {SuperString::Const("hello ascii ", Encoding::ASCII),
+                           SuperString::Copy("copy ascii", Encoding::ASCII),
+                           SuperString::Const("H\xc3\xa9\xe4\xb8\x96\xf0\x9f\x98\x80 utf8"),
+                           SuperString::Copy(std::string(300, 'x').append("\xc3\xa9").c_str()),
+                           SuperString::Const(utf16be, Encoding::UTF16BE),
+                           SuperString::Copy(utf16be, Encoding::UTF16BE),
+                           SuperString::Const(utf32), SuperString::Copy(utf32),
+                           SuperString::Copy("caf\xe9 cr\xe8me", Encoding::ASCII)};
+    std::size_t partCount = sizeof(parts) / sizeof(parts[0]);
+    Encoding encodings[] = {Encoding::ASCII, Encoding::UTF8, Encoding::UTF16BE, Encoding::UTF32, Encoding::Latin1,
+                            Encoding::UTF16LE};
+    for(int round = 0; round < 300; round++) {
+        SuperString string = parts[rand() % partCount];
+        for(int i = rand() % 12; i > 0; i--) {
+            SuperString part = parts[rand() % partCount] * (1 + (rand() % 3 == 0 ? rand() % 3 : 0));
+            string = rand() % 2 == 0 ? string + part : part + string;
+        }
+        std::vector<int> codeUnits(string.begin(), string.end());
+        std::size_t start = rand() % (codeUnits.size() + 1);
+        std::size_t end = start + rand() % (codeUnits.size() - start + 1);
+        for(Encoding encoding : encodings) {
+            std::string expected;
+            bool isEncodable = true;
+            for(std::size_t i = start; i < end; i++) {
+                isEncodable &= encode(codeUnits[i], encoding, expected);
+            }
+            SuperString::Result<std::size_t, SuperString::Error> size = string.copyTo(NULL, start, end, encoding);
+            if(!isEncodable) {
+                CHECK(size.err() == SuperString::Error::Unencodable);
+                continue;
+            }
+            CHECK(size.ok() == expected.size());
+            std::string bytes(size.ok(), '\0');
+            CHECK(string.copyTo((SuperString::Byte *) &bytes[0], start, end, encoding).ok() == expected.size());
+            CHECK(bytes == expected);
+            // the round trip, through a NUL wide enough for every encoding
+            bytes.append(sizeof(int), '\0');
+            // validating ASCII accepts 7-bit bytes only, Latin-1 takes any
+            CHECK(encoding == Encoding::ASCII || SuperString::validate(bytes.c_str(), encoding).ok() == end - start);
+            SuperString copy = SuperString::Copy(bytes.c_str(), encoding);
+            SuperString constant = SuperString::Const(bytes.c_str(), encoding);
+            std::vector<int> range(codeUnits.begin() + start, codeUnits.begin() + end);
+            CHECK(std::vector<int>(copy.begin(), copy.end()) == range);
+            CHECK(std::vector<int>(constant.begin(), constant.end()) == range);
+        }
+        std::string utf8;
+        for(int codeUnit : codeUnits) {
+            encode(codeUnit, Encoding::UTF8, utf8);
+        }
+        CHECK(string.toStdString() == utf8);
+    }
+    SuperString string = SuperString::Copy("abc");
+    CHECK(string.copyTo(NULL, 2, 4).err() == SuperString::Error::RangeError);
+
+    // ASCII is Latin-1: its bytes above 0x7f are printed and copied to UTF-8 as two bytes
+    const char *latin1 = "caf\xe9 cr\xe8me, une tr\xe8s longue cha\xeene";
+    const char *utf8 = "caf\xc3\xa9 cr\xc3\xa8me, une tr\xc3\xa8s longue cha\xc3\xaene";
+    SuperString strings[] = {SuperString::Copy(latin1, Encoding::ASCII), SuperString::Const(latin1, Encoding::ASCII)};
+    for(const SuperString &latin : strings) {
+        CHECK(latin.codeUnitAt(3).ok() == 0xe9 && latin.toStdString() == utf8);
+        std::ostringstream stream;
+        latin.print(stream);
+        CHECK(stream.str() == utf8);
+        std::string bytes(latin.length(), '\0');
+        CHECK(latin.copyTo((SuperString::Byte *) &bytes[0], 0, latin.length(), Encoding::ASCII).ok() == bytes.size());
+        CHECK(bytes == latin1);
+        CHECK(latin.flatten(Encoding::UTF8).ok().toStdString() == utf8);
+        std::string latinBytes(latin.length(), '\0');
+        CHECK(latin.copyTo((SuperString::Byte *) &latinBytes[0], 0, latin.length(), Encoding::Latin1).ok() ==
+              latinBytes.size());
+        CHECK(latinBytes == latin1 && latin.flatten(Encoding::Latin1).ok() == latin);
+    }
+
+    // UTF-16LE is read into UTF-16BE strings, and has no flat strings of its own
+    const SuperString::Byte utf16le[] = {0x48, 0x00, 0xe9, 0x00, 0x16, 0x4e, 0x3d, 0xd8, 0x00, 0xde, 0x21, 0x00,
+                                         0x00, 0x00};
+    SuperString little = SuperString::Copy(utf16le, Encoding::UTF16LE);
+    CHECK(little == SuperString::Copy(utf16be, Encoding::UTF16BE) && little.length() == 5);
+    CHECK(SuperString::Const(utf16le, Encoding::UTF16LE) == little);
+    CHECK(little.flatten(Encoding::UTF16LE).err() == SuperString::Error::Unimplemented);
+    const SuperString::Byte unpaired[] = {0x48, 0x00, 0x3d, 0xd8, 0x21, 0x00, 0x00, 0x00};
+    std::size_t errorOffset = 0;
+    CHECK(SuperString::validate((const char *) unpaired, Encoding::UTF16LE, &errorOffset).isErr() &&
+          errorOffset == 2);
+    printf("ok\n");
+    return 0;
+}
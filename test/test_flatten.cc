@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// flatten copies strings of any shape into one leaf of the asked encoding, and
+// compact copies their short parts, both keeping the code units, and neither
+// keeping the released strings they were built of.
+int main() {
+    srand(21);
+    const int utf32[] = {'w', 0xe9, 0x4e16, 0x1f600, 0};
+    const SuperString::Byte utf16be[] = {0x00, 'u', 0xd8, 0x3d, 0xde, 0x00, 0x00, 0xe9, 0x00, 0x00};
+    SuperString parts[] = {SuperString::Copy("an ASCII leaf, long enough to be referenced", Encoding::ASCII),
+                           SuperString::Copy("h\xc3\xa9llo w\xc3\xb6rld, a UTF-8 leaf \xe4\xb8\x96\xe7\x95\x8c"),
+                           SuperString::Copy(utf16be, Encoding::UTF16BE), SuperString::Copy(utf32),
+                           SuperString::Copy("caf\xe9 in Latin-1", Encoding::ASCII)};
+    std::size_t partCount = sizeof(parts) / sizeof(parts[0]);
+    Encoding encodings[] = {Encoding::ASCII, Encoding::UTF8, Encoding::UTF16BE, Encoding::UTF32};
+    for(int round = 0; round < 300; round++) {
+        SuperString string = parts[rand() % partCount];
+        for(int i = rand() % 10; i > 0; i--) {
+            SuperString part = parts[rand() % partCount];
+            switch(rand() % 3) {
+                case 0:
+                    string = string + part;
+                    break;
+                case 1:
+                    string = part * (1 + rand() % 3) + string;
+                    break;
+                default: {
+                    std::size_t start = rand() % (string.length() + 1);
+                    string = string.substring(start, start + rand() % (string.length() - start + 1)).ok() + part;
+                    break;
+                }
+            }
+        }
+        std::vector<int> expected = codeUnits(string);
+        bool isLatin1 = true;
+        for(int codeUnit : expected) {
+            isLatin1 &= codeUnit <= 0xff;
+        }
+        for(Encoding encoding : encodings) {
+            SuperString::Result<SuperString, SuperString::Error> flat = string.flatten(encoding);
+            if(encoding == Encoding::ASCII && !isLatin1) {
+                CHECK(flat.err() == SuperString::Error::Unencodable);
+                continue;
+            }
+            CHECK(codeUnits(flat.ok()) == expected && flat.ok().length() == expected.size());
+            CHECK(flat.ok().substring(0, expected.size()).ok().length() == expected.size());
+        }
+        std::size_t thresholds[] = {0, 8, SuperString::CompactLength, (std::size_t) -1};
+        for(std::size_t threshold : thresholds) {
+            CHECK(codeUnits(string.compact(threshold)) == expected);
+        }
+        // the copies no longer need what they were built of
+        SuperString flat = string.flatten(Encoding::UTF16BE).ok();
+        SuperString compacted = string.compact();
+        string = SuperString();
+        CHECK(codeUnits(flat) == expected && codeUnits(compacted) == expected);
+    }
+    CHECK(SuperString().flatten(Encoding::UTF32).ok().isEmpty() && SuperString().compact().isEmpty());
+    printf("ok\n");
+    return 0;
+}
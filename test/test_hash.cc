@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// Returns the polynomial hash of the code units in [startIndex, endIndex), computed
+// one code unit at a time modulo 2^61 - 1.
+static unsigned long long polynomial(const std::vector<int> &codeUnits, std::size_t startIndex,
+                                     std::size_t endIndex) {
+    const unsigned long long modulus = (1ULL << 61) - 1;
+    const unsigned long long base = 0x16a09e667f3bcc9ULL;
+    unsigned long long hash = 0;
+    for(std::size_t i = startIndex; i < endIndex; i++) {
+        hash = (unsigned long long) (((unsigned __int128) hash * base + (unsigned) codeUnits[i]) % modulus);
+    }
+    return hash;
+}
+
+// Hashes combined from the parts of concatenations, repetitions and substrings
+// equal the hash of the code units, and equal strings hash alike.
+int main() {
+    srand(11);
+    const char *texts[] = {"hello w\xc3\xb6rld \xf0\x9f\x98\x80 and \xe4\xb8\x96 ", "plain ascii text with more words ",
+                           "ab"};
+    Encoding encodings[] = {Encoding::UTF8, Encoding::UTF16BE, Encoding::UTF32};
+    for(int round = 0; round < 200; round++) {
+        std::vector<SuperString> strings;
+        for(const char *text : texts) {
+            strings.push_back(SuperString::Copy(text));
+        }
+        strings.push_back(SuperString::Copy(texts[1], Encoding::ASCII));
+        for(int step = 0; step < 40; step++) {
+            const SuperString &string = strings[rand() % strings.size()];
+            const SuperString &other = strings[rand() % strings.size()];
+            (void) string.hash();
+            switch(rand() % 4) {
+                case 0:
+                    strings.push_back(string + other);
+                    break;
+                case 1:
+                    strings.push_back(string.length() < 3000 ? string * (1 + rand() % 7) : string);
+                    break;
+                case 2:
+                    strings.push_back(string.flatten(encodings[rand() % 3]).ok());
+                    break;
+                default: {
+                    std::size_t length = string.length();
+                    std::size_t start = rand() % (length + 1);
+                    strings.push_back(string.substring(start, start + rand() % (length - start + 1)).ok());
+                    break;
+                }
+            }
+        }
+        for(const SuperString &string : strings) {
+            std::vector<int> units = codeUnits(string);
+            CHECK(string.hash() == polynomial(units, 0, units.size()));
+            CHECK(string.hash() == polynomial(units, 0, units.size()));
+            std::size_t start = rand() % (units.size() + 1);
+            std::size_t end = start + rand() % (units.size() - start + 1);
+            CHECK(string.substring(start, end).ok().hash() == polynomial(units, start, end));
+        }
+    }
+
+    // substrings of long leaves, hashed through their sampled prefix hashes
+    std::string text;
+    for(int i = 0; i < 20000; i++) {
+        text += i % 7 == 0 ? "\xc3\xa9" : (i % 11 == 0 ? "\xf0\x9f\x98\x80" : "x");
+    }
+    SuperString leaves[] = {SuperString::Copy(text.c_str()), SuperString::Const(text.c_str()),
+                            SuperString::Copy(text.c_str()).flatten(Encoding::UTF16BE).ok(),
+                            SuperString::Copy(text.c_str()).flatten(Encoding::UTF32).ok()};
+    for(const SuperString &leaf : leaves) {
+        std::vector<int> units = codeUnits(leaf);
+        for(int k = 0; k < 300; k++) {
+            std::size_t start = rand() % (units.size() + 1);
+            std::size_t end = start + rand() % (units.size() - start + 1);
+            CHECK(leaf.substring(start, end).ok().hash() == polynomial(units, start, end));
+        }
+    }
+
+    std::unordered_map<SuperString, int> counts;
+    counts[SuperString::Copy("abc")] = 1;
+    counts[SuperString::Copy("ab") + SuperString::Copy("c", Encoding::ASCII)] += 1;
+    counts[SuperString::Copy("xabcx").substring(1, 4).ok()] += 1;
+    counts[SuperString::Copy("abc").flatten(Encoding::UTF32).ok()] += 1;
+    CHECK(counts.size() == 1 && counts.begin()->second == 4);
+    CHECK(SuperString().hash() == SuperString::Copy("").hash());
+    printf("ok\n");
+    return 0;
+}
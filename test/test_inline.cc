@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::size_t live() {
+    return SuperString::stats().sequenceCount();
+}
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// Short strings live in the SuperString itself, without a sequence, and behave
+// like the same content held in a sequence.
+int main() {
+    CHECK(sizeof(SuperString) == 16);
+    std::size_t sequenceCount = live();
+    {
+        const int utf32[] = {0x1f600, 'a', 0};
+        SuperString ascii = SuperString::Copy("bla");
+        SuperString borrowed = SuperString::Const("x");
+        SuperString utf8 = SuperString::Copy("h\xc3\xa9llo w\xc3\xb6rld");
+        SuperString wide = SuperString::Copy(utf32);
+        SuperString utf16 = SuperString::Copy("\x00\x41\xd8\x3d\xde\x00\x00\x00", Encoding::UTF16BE);
+        CHECK(ascii.length() == 3 && borrowed.length() == 1 && utf8.length() == 11);
+        CHECK(wide.codeUnitAt(0).ok() == 0x1f600 && utf16.codeUnitAt(1).ok() == 0x1f600);
+        CHECK(utf8.toStdString() == "h\xc3\xa9llo w\xc3\xb6rld" && utf8.keepingCost() == 0);
+        SuperString joined = ascii + borrowed + utf8.substring(0, 2).ok();
+        CHECK(joined.toStdString() == "blaxh\xc3\xa9" && joined.keepingCost() == 0);
+        std::vector<SuperString> tokens;
+        for(int i = 0; i < 1000; i++) {
+            tokens.push_back(SuperString::Copy(std::to_string(i * 7919).c_str()));
+        }
+        CHECK(live() == sequenceCount);
+    }
+
+    // short substrings of a sequence are copied out, searched and compared inline
+    SuperString sentence = SuperString::Copy("The quick brown fox jumps over the lazy dog");
+    CHECK(live() == sequenceCount + 1);
+    SuperString word = sentence.substring(4, 9).ok();
+    CHECK(word.toStdString() == "quick" && word.keepingCost() == 0 && live() == sequenceCount + 1);
+    CHECK(sentence.indexOf(word).ok() == 4 && word.indexOf(sentence).isErr());
+    CHECK(SuperString::Copy("a.b.c").lastIndexOf(SuperString::Copy(".")).ok() == 3);
+    CHECK(word == word.flatten(Encoding::UTF16BE).ok() && word.hash() == word.flatten(Encoding::UTF32).ok().hash());
+    CHECK(SuperString::Copy(" pad ").trim() == SuperString::Copy("pad"));
+    CHECK(SuperString::Copy("ab\xff").length() == 0);
+
+    // inline strings too long together are joined in a single leaf
+    SuperString digits = SuperString::Copy("0123456789");
+    SuperString letters = SuperString::Copy("abcdefgh\xc3\xa9j");
+    SuperString both = digits + letters;
+    CHECK(live() == sequenceCount + 2);
+    CHECK(both.toStdString() == "0123456789abcdefgh\xc3\xa9j" && both.codeUnitAt(18).ok() == 0xe9);
+    both += digits;
+    CHECK(both.toStdString() == "0123456789abcdefgh\xc3\xa9j0123456789");
+    SuperString repeated = digits * 3;
+    CHECK(repeated.length() == 30 && repeated.codeUnitAt(29).ok() == '9');
+
+    // inline strings moved and printed
+    SuperString moved = std::move(word);
+    CHECK(moved.toStdString() == "quick" && word.length() == 0);
+    std::ostringstream stream;
+    moved.print(stream, 1, 4);
+    CHECK(stream.str() == "uic");
+    std::vector<int> expected = {'u', 'i', 'c', 'k'};
+    CHECK(codeUnits(moved.substring(1, 5).ok()) == expected);
+    sentence = both = repeated = SuperString();
+    CHECK(live() == sequenceCount);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef SUPERSTRING_THREAD_SAFE
+#include <thread>
+#endif
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::size_t live() {
+    return SuperString::stats().sequenceCount();
+}
+
+// Equal contents share one entry whatever their shape, and a weak pool forgets
+// the strings nobody holds anymore.
+static int deduplicate(bool isWeak) {
+    std::size_t sequenceCount = live();
+    {
+        SuperString::InternPool pool(isWeak);
+        std::vector<SuperString> kept;
+        for(int i = 0; i < 1000; i++) {
+            kept.push_back(pool.intern(SuperString::Copy(("a_long_field_name_" + std::to_string(i % 10)).c_str())));
+        }
+        CHECK(pool.size() == 10 && live() - sequenceCount == 10);
+        CHECK(kept[3] == SuperString::Copy("a_long_field_name_3"));
+        // short strings stay inline, out of the pool
+        CHECK(pool.intern(SuperString::Copy("xxfield7yy").substring(2, 8).ok()) == SuperString::Copy("field7"));
+        CHECK(pool.size() == 10 && live() - sequenceCount == 10);
+
+        SuperString joined = SuperString::Copy("a_long_fie") + SuperString::Copy("ld_name_7", Encoding::ASCII);
+        SuperString sliced = SuperString::Copy("xxa_long_field_name_7yy").substring(2, 21).ok();
+        SuperString wide = SuperString::Copy("a_long_field_name_7").flatten(Encoding::UTF16BE).ok();
+        CHECK(pool.intern(joined) == kept[7] && pool.intern(sliced) == kept[7] && pool.intern(wide) == kept[7]);
+        CHECK(pool.size() == 10);
+
+        // new contents are flattened, lone surrogates kept in UTF-32
+        SuperString made = pool.intern(SuperString::Copy("brand new ") + SuperString::Copy("w\xc3\xb6rd, longer"));
+        const int lone[] = {'a', 0xd800, 'b', 0};
+        SuperString surrogate = pool.intern(SuperString::Copy(lone) + SuperString::Copy("c"));
+        CHECK(made.toStdString() == "brand new w\xc3\xb6rd, longer" && surrogate.codeUnitAt(1).ok() == 0xd800);
+        CHECK(pool.size() == 12);
+
+        // interned strings are never appended to in place
+        SuperString edited = pool.intern(SuperString::Copy("a_long_field_name_1"));
+        kept.clear();
+        edited += SuperString::Copy("!");
+        CHECK(edited.toStdString() == "a_long_field_name_1!");
+        CHECK(pool.intern(SuperString::Copy("a_long_field_name_1")).toStdString() == "a_long_field_name_1");
+
+        edited = made = surrogate = joined = SuperString();
+        CHECK(pool.size() == (isWeak ? 0 : 12));
+        SuperString again = pool.intern(SuperString::Copy("again and again, and again"));
+        SuperString::InternPool other(true);
+        SuperString shared = other.intern(again);
+        again = SuperString();
+        CHECK(shared.toStdString() == "again and again, and again" && other.size() == 1);
+        shared = SuperString();
+        CHECK(other.size() == (isWeak ? 0 : 1));
+    }
+    CHECK(live() == sequenceCount);
+
+    SuperString survivor;
+    {
+        SuperString::InternPool pool(isWeak);
+        survivor = pool.intern(SuperString::Copy("the survivor, a long string"));
+    }
+    CHECK(survivor.toStdString() == "the survivor, a long string");
+    survivor = SuperString();
+    CHECK(live() == sequenceCount);
+    return 0;
+}
+
+// Borrowed bytes are copied into the pool, so they may be freed afterwards.
+static int borrow(bool isWeak) {
+    SuperString::InternPool pool(isWeak);
+    char *buffer = new char[64];
+    strcpy(buffer, "a borrowed buffer that is too long to be inline");
+    SuperString interned = pool.intern(SuperString::Const(buffer));
+    SuperString again = pool.intern(SuperString::Copy("a borrowed buffer that is too long to be inline"));
+    memset(buffer, 'x', 40);
+    delete[] buffer;
+    CHECK(interned.toStdString() == "a borrowed buffer that is too long to be inline");
+    CHECK(again == interned && pool.size() == 1);
+    return 0;
+}
+
+#ifdef SUPERSTRING_THREAD_SAFE
+// Threads interning the same words concurrently all get them back intact.
+static int share() {
+    SuperString::InternPool pool(true);
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for(int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&pool, &failures, t]() {
+            unsigned int seed = (unsigned int) t;
+            std::vector<SuperString> held(32);
+            for(int i = 0; i < 20000; i++) {
+                std::string word = "a longer word " + std::to_string(rand_r(&seed) % 50);
+                SuperString interned = pool.intern(SuperString::Copy(word.c_str()));
+                failures[t] += interned.toStdString() != word;
+                held[rand_r(&seed) % held.size()] = interned;
+            }
+        }));
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+    for(int t = 0; t < 4; t++) {
+        CHECK(failures[t] == 0);
+    }
+    CHECK(pool.size() == 0);
+    return 0;
+}
+#endif
+
+int main() {
+    CHECK(deduplicate(false) == 0 && deduplicate(true) == 0);
+    CHECK(borrow(false) == 0 && borrow(true) == 0);
+#ifdef SUPERSTRING_THREAD_SAFE
+    CHECK(share() == 0);
+#endif
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+// Walks [string] forwards and backwards and checks both walks against codeUnitAt.
+static int walk(const SuperString &string) {
+    std::vector<int> expected;
+    for(std::size_t i = 0; i < string.length(); i++) {
+        expected.push_back(string.codeUnitAt(i).ok());
+    }
+    std::vector<int> forwards;
+    for(SuperString::Iterator it = string.begin(); it != string.end(); ++it) {
+        CHECK(it.index() == forwards.size());
+        forwards.push_back(*it);
+    }
+    std::vector<int> backwards;
+    SuperString::Iterator it = string.end();
+    while(it != string.begin()) {
+        --it;
+        backwards.push_back(*it);
+        CHECK(it.index() == expected.size() - backwards.size());
+    }
+    std::reverse(backwards.begin(), backwards.end());
+    CHECK(forwards == expected && backwards == expected);
+    return 0;
+}
+
+// Iterators read every encoding, through concatenations, substrings and
+// repetitions, in both directions.
+int main() {
+    const int utf32[] = {'H', 0xe9, 0x4e16, 0x1f600, ' ', 'w', 0};
+    const SuperString::Byte utf16be[] = {0x00, 0x48, 0x00, 0xe9, 0x4e, 0x16, 0xd8, 0x3d, 0xde, 0x00, 0x00, 0x21,
+                                         0x00, 0x00};
+    const char *utf8 = "H\xc3\xa9\xe4\xb8\x96\xf0\x9f\x98\x80 world, long enough for a sequence";
+    SuperString ascii = SuperString::Const("hello world, long enough for a sequence", Encoding::ASCII);
+    SuperString copy = SuperString::Copy(utf8);
+    SuperString utf16 = SuperString::Copy(utf16be, Encoding::UTF16BE);
+    SuperString wide = SuperString::Const(utf32);
+    SuperString borrowed = SuperString::Const(utf8);
+    SuperString strings[] = {ascii, copy, utf16, wide, borrowed, SuperString(), SuperString::Copy("short"),
+                             copy.substring(1, 6).ok()};
+    for(const SuperString &string : strings) {
+        CHECK(walk(string) == 0);
+    }
+    SuperString left = ascii + copy;
+    SuperString right = utf16 + wide;
+    SuperString both = left + right;
+    SuperString joined = both + borrowed;
+    CHECK(walk(joined) == 0);
+    SuperString substring = joined.substring(3, 60).ok();
+    CHECK(walk(substring) == 0);
+    SuperString piece = copy.substring(2, 5).ok();
+    SuperString repeated = piece * 4;
+    CHECK(walk(repeated) == 0);
+    SuperString repeatedJoined = joined * 3;
+    CHECK(walk(repeatedJoined.substring(5, 150).ok()) == 0);
+
+    SuperString::Iterator it = copy.begin();
+    CHECK(*it++ == 'H' && *it == 0xe9 && *++it == 0x4e16 && *++it == 0x1f600);
+    CHECK(*it-- == 0x1f600 && *it == 0x4e16);
+    CHECK(std::count(joined.begin(), joined.end(), 'o') == 13);
+    printf("ok\n");
+    return 0;
+}
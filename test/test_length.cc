@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// Joins, repeats or cuts random strings of [strings], whose code units are in
+// [expected], and puts the code units of the result in [units].
+static SuperString derive(const std::vector<SuperString> &strings, const std::vector<std::vector<int> > &expected,
+                          std::vector<int> &units) {
+    std::size_t first = rand() % strings.size();
+    std::size_t second = rand() % strings.size();
+    switch(rand() % 3) {
+        case 0:
+            units = expected[first];
+            units.insert(units.end(), expected[second].begin(), expected[second].end());
+            return strings[first] + strings[second];
+        case 1: {
+            std::size_t times = expected[first].size() > 1000 ? 1 : rand() % 4;
+            for(std::size_t i = 0; i < times; i++) {
+                units.insert(units.end(), expected[first].begin(), expected[first].end());
+            }
+            return strings[first] * times;
+        }
+        default: {
+            std::size_t length = expected[first].size();
+            std::size_t start = rand() % (length + 1);
+            std::size_t end = start + rand() % (length - start + 1);
+            units.assign(expected[first].begin() + start, expected[first].begin() + end);
+            return strings[first].substring(start, end).ok();
+        }
+    }
+}
+
+// The lengths cached on concatenations, repetitions and substrings stay those of
+// the flat strings, also once the strings they reference are released and they
+// are reconstructed.
+int main() {
+    srand(9);
+    const int utf32[] = {'w', 0xe9, 0x4e16, 0x1f600, 0};
+    const SuperString::Byte utf16be[] = {0x00, 'u', 0xd8, 0x3d, 0xde, 0x00, 0x00, 0xe9, 0x00, 0x00};
+    for(int round = 0; round < 200; round++) {
+        std::vector<SuperString> strings;
+        std::vector<std::vector<int> > expected;
+        strings.push_back(SuperString::Copy("a leaf of ASCII text long enough to be referenced", Encoding::ASCII));
+        strings.push_back(SuperString::Copy("h\xc3\xa9llo w\xc3\xb6rld, \xe4\xb8\x96\xe7\x95\x8c \xf0\x9f\x98\x80"));
+        strings.push_back(SuperString::Copy(utf16be, Encoding::UTF16BE));
+        strings.push_back(SuperString::Copy(utf32));
+        for(const SuperString &string : strings) {
+            expected.push_back(codeUnits(string));
+        }
+        for(int step = 0; step < 30; step++) {
+            std::vector<int> units;
+            SuperString string = derive(strings, expected, units);
+            CHECK(string.length() == units.size());
+            strings.push_back(string);
+            expected.push_back(units);
+            // releasing a string reconstructs the strings referencing it
+            if(rand() % 4 == 0) {
+                std::size_t released = rand() % strings.size();
+                strings.erase(strings.begin() + released);
+                expected.erase(expected.begin() + released);
+            }
+        }
+        for(std::size_t i = 0; i < strings.size(); i++) {
+            CHECK(strings[i].length() == expected[i].size() && codeUnits(strings[i]) == expected[i]);
+            CHECK(strings[i].isEmpty() == expected[i].empty());
+            if(!expected[i].empty()) {
+                CHECK(strings[i].codeUnitAt(expected[i].size() - 1).ok() == expected[i].back());
+            }
+        }
+    }
+    printf("ok\n");
+    return 0;
+}
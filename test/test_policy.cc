@@ -0,0 +1,75 @@
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+// Frees every sequence, whatever it costs.
+class AlwaysFree: public SuperString::RetentionPolicy {
+public:
+    bool isToBeFreed(std::size_t /*keepingCost*/, std::size_t /*freeingCost*/) const /*override*/ {
+        return true;
+    }
+};
+
+// Releases a 20000 bytes string after taking [count] slices of 100 bytes out of
+// it under [policy], checks the slices and returns the number of reconstructions.
+static std::size_t release(std::size_t count, SuperString::RetentionPolicy *policy) {
+    std::string text;
+    for(int i = 0; i < 20000; i++) {
+        text += "abcdefghijklmnopqrstuvwxyz"[i % 26];
+    }
+    SuperString string = SuperString::Copy(text.c_str(), SuperString::Encoding::ASCII);
+    string.retentionPolicy(policy);
+    std::vector<SuperString> slices;
+    for(std::size_t i = 0; i < count; i++) {
+        slices.push_back(string.substring(i * 10, i * 10 + 100).ok());
+    }
+    std::size_t reconstructionCount = SuperString::stats().reconstructionCount();
+    string = SuperString();
+    reconstructionCount = SuperString::stats().reconstructionCount() - reconstructionCount;
+    for(std::size_t i = 0; i < count; i++) {
+        if(slices[i].toStdString() != text.substr(i * 10, 100)) {
+            return (std::size_t) -1;
+        }
+    }
+    return reconstructionCount;
+}
+
+// The global policy and a policy set on a string decide whether a released
+// string is kept for its slices or the slices reconstructed.
+int main() {
+#ifndef SUPERSTRING_THREAD_SAFE
+    // 10 slices of 100 bytes are cheaper than 20000 bytes, 1000 are not
+    CHECK(release(10, NULL) == 10);
+    CHECK(release(1000, NULL) == 0);
+    CHECK(SuperString::stats().sequenceCount() == 0 && SuperString::stats().retainedBytes() == 0);
+
+    SuperString::RetentionPolicy::AlwaysKeep keep;
+    SuperString::RetentionPolicy::Threshold threshold(1 << 30);
+    SuperString::RetentionPolicy::MemoryBudget small(1000);
+    SuperString::RetentionPolicy::MemoryBudget large(1 << 30);
+    AlwaysFree always;
+    SuperString::retentionPolicy(keep);
+    CHECK(&SuperString::retentionPolicy() == &keep);
+    CHECK(release(10, NULL) == 0);
+    CHECK(release(10, &threshold) == 10);
+    SuperString::retentionPolicy(threshold);
+    CHECK(release(1000, NULL) == 1000);
+    CHECK(release(1000, &keep) == 0);
+    SuperString::retentionPolicy(small);
+    CHECK(release(1000, NULL) == 1000);
+    SuperString::retentionPolicy(large);
+    CHECK(release(1000, NULL) == 0);
+    CHECK(release(1000, &always) == 1000);
+    SuperString::RetentionPolicy::CostBased cost;
+    SuperString::retentionPolicy(cost);
+    CHECK(release(10, NULL) == 10);
+#else
+    // referenced sequences are always kept by the thread-safe build
+    CHECK(release(10, NULL) == 0);
+#endif
+    CHECK(SuperString::stats().sequenceCount() == 0 && SuperString::stats().retainedBytes() == 0);
+    printf("ok\n");
+    return 0;
+}
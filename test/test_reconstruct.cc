@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// Returns a string of [codeUnits] stored in [encoding].
+static SuperString make(const std::vector<int> &codeUnits, Encoding encoding) {
+    std::vector<SuperString::Byte> bytes;
+    for(int codeUnit : codeUnits) {
+        if(encoding == Encoding::UTF8) {
+            if(codeUnit < 0x80) {
+                bytes.push_back((SuperString::Byte) codeUnit);
+            } else if(codeUnit < 0x800) {
+                bytes.push_back((SuperString::Byte) (0xc0 | (codeUnit >> 6)));
+                bytes.push_back((SuperString::Byte) (0x80 | (codeUnit & 0x3f)));
+            } else if(codeUnit < 0x10000) {
+                bytes.push_back((SuperString::Byte) (0xe0 | (codeUnit >> 12)));
+                bytes.push_back((SuperString::Byte) (0x80 | ((codeUnit >> 6) & 0x3f)));
+                bytes.push_back((SuperString::Byte) (0x80 | (codeUnit & 0x3f)));
+            } else {
+                bytes.push_back((SuperString::Byte) (0xf0 | (codeUnit >> 18)));
+                bytes.push_back((SuperString::Byte) (0x80 | ((codeUnit >> 12) & 0x3f)));
+                bytes.push_back((SuperString::Byte) (0x80 | ((codeUnit >> 6) & 0x3f)));
+                bytes.push_back((SuperString::Byte) (0x80 | (codeUnit & 0x3f)));
+            }
+        } else {
+            int units[2] = {codeUnit, -1};
+            if(codeUnit >= 0x10000) {
+                units[0] = 0xd800 + ((codeUnit - 0x10000) >> 10);
+                units[1] = 0xdc00 + ((codeUnit - 0x10000) & 0x3ff);
+            }
+            for(int unit : units) {
+                if(unit >= 0) {
+                    bytes.push_back((SuperString::Byte) (unit >> 8));
+                    bytes.push_back((SuperString::Byte) (unit & 0xff));
+                }
+            }
+        }
+    }
+    if(encoding == Encoding::UTF32) {
+        std::vector<int> terminated = codeUnits;
+        terminated.push_back(0);
+        return SuperString::Copy(terminated.data());
+    }
+    bytes.push_back(0);
+    if(encoding == Encoding::UTF16BE) {
+        bytes.push_back(0);
+    }
+    return SuperString::Copy(bytes.data(), encoding);
+}
+
+// Strings referencing a released string are rebuilt from the code units they
+// use, stored in the narrowest encoding that holds them, and read as before.
+int main() {
+    srand(3);
+    // the widest code unit of the first n needs 1, 2 or 4 bytes
+    const int alphabet[] = {'a', ' ', 0xe9, 0xff, 0x4e16, 0xfffd, 0x1f600};
+    std::size_t alphabetLengths[] = {2, 4, 6, 7};
+    Encoding encodings[] = {Encoding::UTF8, Encoding::UTF16BE, Encoding::UTF32};
+    for(int round = 0; round < 120; round++) {
+        std::vector<int> expected;
+        for(int i = 0; i < 2000; i++) {
+            expected.push_back(alphabet[rand() % alphabetLengths[round % 4]]);
+        }
+        SuperString parent = make(expected, encodings[round % 3]);
+        SuperString other = SuperString::Copy("and an other string to concatenate");
+        std::vector<int> otherUnits = codeUnits(other);
+
+        std::vector<SuperString> strings;
+        std::vector<std::vector<int> > references;
+        for(int i = 0; i < 8; i++) {
+            std::size_t start = rand() % expected.size();
+            std::size_t end = start + rand() % std::min<std::size_t>(200, expected.size() - start + 1);
+            SuperString slice = parent.substring(start, end).ok();
+            std::vector<int> sliceUnits(expected.begin() + start, expected.begin() + end);
+            switch(i % 4) {
+                case 0:
+                    strings.push_back(slice);
+                    references.push_back(sliceUnits);
+                    break;
+                case 1:
+                    strings.push_back(other + slice);
+                    references.push_back(otherUnits);
+                    references.back().insert(references.back().end(), sliceUnits.begin(), sliceUnits.end());
+                    break;
+                case 2:
+                    strings.push_back(slice + other);
+                    references.push_back(sliceUnits);
+                    references.back().insert(references.back().end(), otherUnits.begin(), otherUnits.end());
+                    break;
+                default:
+                    strings.push_back(slice * 3);
+                    references.push_back(std::vector<int>());
+                    for(int k = 0; k < 3; k++) {
+                        references.back().insert(references.back().end(), sliceUnits.begin(), sliceUnits.end());
+                    }
+                    break;
+            }
+        }
+        parent = SuperString();
+        other = SuperString();
+        for(std::size_t i = 0; i < strings.size(); i++) {
+            CHECK(strings[i].length() == references[i].size() && codeUnits(strings[i]) == references[i]);
+            for(int k = 0; k < 20 && !references[i].empty(); k++) {
+                std::size_t index = rand() % references[i].size();
+                CHECK(strings[i].codeUnitAt(index).ok() == references[i][index]);
+            }
+            std::vector<int> terminated = references[i];
+            terminated.push_back(0);
+            std::ostringstream stream;
+            std::ostringstream expectedStream;
+            CHECK(strings[i].print(stream) && SuperString::Copy(terminated.data()).print(expectedStream));
+            CHECK(stream.str() == expectedStream.str());
+        }
+    }
+    printf("ok\n");
+    return 0;
+}
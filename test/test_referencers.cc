@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// A string referenced by a few strings or by thousands, past the inline part of
+// its referencer set, keeps track of them as they come and go, and each one still
+// reads right once the string itself is released.
+int main() {
+    srand(17);
+    std::string text;
+    for(int i = 0; i < 50000; i++) {
+        text += "abcdefghijklmnopqrstuvwxyz\xc3\xa9"[i % 28];
+    }
+    std::size_t counts[] = {1, 3, 8, 9, 40, 2000};
+    for(int round = 0; round < 60; round++) {
+        SuperString parent = SuperString::Copy(text.c_str(), SuperString::Encoding::ASCII);
+        std::vector<int> expected = codeUnits(parent);
+        SuperString other = SuperString::Copy("a second string both kinds of referencers use");
+        std::vector<SuperString> strings;
+        std::vector<std::vector<int> > references;
+        std::size_t count = counts[round % 6];
+        for(std::size_t i = 0; i < count; i++) {
+            std::size_t start = rand() % expected.size();
+            std::size_t end = start + rand() % std::min<std::size_t>(100, expected.size() - start + 1);
+            std::vector<int> units(expected.begin() + start, expected.begin() + end);
+            if(i % 2 == 0) {
+                strings.push_back(parent.substring(start, end).ok());
+            } else {
+                strings.push_back(parent.substring(start, end).ok() + other);
+                std::vector<int> otherUnits = codeUnits(other);
+                units.insert(units.end(), otherUnits.begin(), otherUnits.end());
+            }
+            references.push_back(units);
+            // referencers leave in any order
+            if(rand() % 3 == 0) {
+                std::size_t released = rand() % strings.size();
+                strings.erase(strings.begin() + released);
+                references.erase(references.begin() + released);
+            }
+        }
+        if(round % 2 == 0) {
+            parent = SuperString();
+            other = SuperString();
+        }
+        while(!strings.empty()) {
+            std::size_t index = rand() % strings.size();
+            CHECK(codeUnits(strings[index]) == references[index]);
+            strings.erase(strings.begin() + index);
+            references.erase(references.begin() + index);
+        }
+        CHECK(round % 2 == 0 || codeUnits(parent) == expected);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include <string>
+#include <utility>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Error Error;
+
+// Results hold their value inline, switch between Ok and Err, and release the
+// strings they hold when reassigned or destroyed.
+int main() {
+    SuperString::Result<int, Error> number(42);
+    CHECK(number.isOk() && !number.isErr() && number.ok() == 42);
+    number.err(Error::RangeError);
+    CHECK(number.isErr() && number.err() == Error::RangeError);
+    number.ok(7);
+    CHECK(number.isOk() && number.ok() == 7);
+    CHECK(sizeof(SuperString::Result<int, Error>) <= 2 * sizeof(int));
+
+    SuperString::Result<std::string, Error> text(std::string("a string too long for the small buffer"));
+    SuperString::Result<std::string, Error> copy(text);
+    SuperString::Result<std::string, Error> moved(std::move(text));
+    CHECK(copy.ok() == "a string too long for the small buffer" && moved.ok() == copy.ok());
+    copy = SuperString::Result<std::string, Error>(Error::NotFound);
+    CHECK(copy.isErr() && copy.err() == Error::NotFound);
+    copy = moved;
+    CHECK(copy.isOk() && copy.ok() == moved.ok());
+
+    {
+        SuperString string = SuperString::Copy("a string kept in a heap sequence");
+        SuperString::Result<SuperString, Error> result(string);
+        SuperString::Result<SuperString, Error> other(Error::Unexpected);
+        other = result;
+        result = SuperString::Result<SuperString, Error>(Error::RangeError);
+        CHECK(result.isErr() && other.ok().length() == string.length());
+        other = std::move(result);
+        CHECK(other.isErr() && other.err() == Error::RangeError);
+        string = SuperString::Copy("a replacement");
+        result = SuperString::Result<SuperString, Error>(SuperString::Copy("another string"));
+        CHECK(result.ok().length() == 14 && result.ok().codeUnitAt(0).ok() == 'a');
+    }
+
+    SuperString string = SuperString::Copy("h\xc3\xa9llo, w\xc3\xb6rld and more");
+    CHECK(string.codeUnitAt(1).ok() == 0xe9);
+    CHECK(string.codeUnitAt(string.length()).isErr());
+    CHECK(string.codeUnitAt(string.length()).err() == Error::RangeError);
+    CHECK(string.substring(0, string.length() + 1).err() == Error::RangeError);
+    CHECK(string.substring(7, 12).ok().length() == 5 && string.substring(7, 12).ok().codeUnitAt(1).ok() == 0xf6);
+    CHECK(string.indexOf(SuperString::Copy("missing")).err() == Error::NotFound);
+    printf("ok\n");
+    return 0;
+}
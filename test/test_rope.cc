@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// Checks [string] against the flat [expected] code units, through iteration,
+// codeUnitAt at random positions and printing.
+static int compare(const SuperString &string, const std::vector<int> &expected, const std::string &utf8) {
+    CHECK(string.length() == expected.size());
+    CHECK(codeUnits(string) == expected);
+    for(int k = 0; k < 50 && !expected.empty(); k++) {
+        std::size_t index = rand() % expected.size();
+        CHECK(string.codeUnitAt(index).ok() == expected[index]);
+    }
+    CHECK(string.codeUnitAt(expected.size()).isErr());
+    std::ostringstream stream;
+    CHECK(string.print(stream) && stream.str() == utf8);
+    return 0;
+}
+
+// Ropes built by appending and prepending pieces of every size, and by joining
+// ropes together, read like the flat string, however they get rebalanced.
+int main() {
+    srand(5);
+    const char *pieces[] = {"a", "bc", "d\xc3\xa9", "\xe4\xb8\x96", "\xf0\x9f\x98\x80",
+                            "a piece long enough not to be merged"};
+    std::size_t pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+    std::vector<SuperString> leaves;
+    std::vector<std::vector<int> > leafUnits;
+    for(std::size_t i = 0; i < pieceCount; i++) {
+        leaves.push_back(SuperString::Copy(pieces[i]));
+        leafUnits.push_back(codeUnits(leaves.back()));
+    }
+    for(int round = 0; round < 40; round++) {
+        SuperString ropes[2] = {leaves[0], leaves[1]};
+        std::vector<int> expected[2] = {leafUnits[0], leafUnits[1]};
+        std::string utf8[2] = {pieces[0], pieces[1]};
+        for(int step = 0; step < 400; step++) {
+            int side = rand() % 2;
+            std::size_t piece = rand() % pieceCount;
+            if(rand() % 2 == 0) {
+                ropes[side] = ropes[side] + leaves[piece];
+                expected[side].insert(expected[side].end(), leafUnits[piece].begin(), leafUnits[piece].end());
+                utf8[side] += pieces[piece];
+            } else {
+                ropes[side] = leaves[piece] + ropes[side];
+                expected[side].insert(expected[side].begin(), leafUnits[piece].begin(), leafUnits[piece].end());
+                utf8[side] = pieces[piece] + utf8[side];
+            }
+            if(rand() % 100 == 0) {
+                ropes[side] = ropes[side] + ropes[1 - side];
+                expected[side].insert(expected[side].end(), expected[1 - side].begin(), expected[1 - side].end());
+                utf8[side] += utf8[1 - side];
+            }
+        }
+        CHECK(compare(ropes[0], expected[0], utf8[0]) == 0 && compare(ropes[1], expected[1], utf8[1]) == 0);
+    }
+
+    // long chains of single characters, appended on either side
+    std::vector<SuperString> letters;
+    for(int i = 0; i < 26; i++) {
+        char letter[2] = {(char) ('a' + i), 0};
+        letters.push_back(SuperString::Copy(letter, Encoding::ASCII));
+    }
+    SuperString appended = letters[0];
+    SuperString prepended = letters[99999 % 26];
+    std::string text = "a";
+    for(int i = 1; i < 100000; i++) {
+        appended = appended + letters[i % 26];
+        prepended = letters[(99999 - i) % 26] + prepended;
+        text += (char) ('a' + i % 26);
+    }
+    std::vector<int> expected(text.begin(), text.end());
+    CHECK(compare(appended, expected, text) == 0 && compare(prepended, expected, text) == 0);
+    CHECK(compare(appended + prepended, codeUnits(appended + appended), text + text) == 0);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// Returns the first, or last if [isReverse], position of [pattern] in [text], or -1.
+static long find(const std::vector<int> &text, const std::vector<int> &pattern, bool isReverse) {
+    if(pattern.empty()) {
+        return isReverse ? (long) text.size() : 0;
+    }
+    long found = -1;
+    for(std::size_t i = 0; i + pattern.size() <= text.size(); i++) {
+        if(std::equal(pattern.begin(), pattern.end(), text.begin() + i)) {
+            if(!isReverse) {
+                return (long) i;
+            }
+            found = (long) i;
+        }
+    }
+    return found;
+}
+
+static long position(const SuperString::Result<std::size_t, SuperString::Error> &result) {
+    return result.isOk() ? (long) result.ok() : -1;
+}
+
+// indexOf and lastIndexOf agree with a naive search on random strings of every
+// shape, and on long ropes where matches cross leaves and search blocks.
+int main() {
+    srand(7);
+    const char *pieces[] = {"a", "b", "\xc3\xa9", "\xe4\xb8\x96", "ab", "ba"};
+    const int utf32[] = {'a', 0xe9, 'b', 0x1f600, 0};
+    const SuperString::Byte utf16be[] = {0x00, 'a', 0x00, 'b', 0xd8, 0x3d, 0xde, 0x00, 0x00, 0x00};
+    for(int round = 0; round < 3000; round++) {
+        std::string text;
+        std::string pattern;
+        for(int i = rand() % 40; i > 0; i--) {
+            text += pieces[rand() % 6];
+        }
+        for(int i = rand() % 5; i > 0; i--) {
+            pattern += pieces[rand() % 6];
+        }
+        SuperString string = SuperString::Copy(text.c_str());
+        switch(rand() % 4) {
+            case 0:
+                string = string + SuperString::Copy(utf32) + SuperString::Copy(utf16be, Encoding::UTF16BE) + string;
+                break;
+            case 1:
+                string = string.length() > 2 ? string.substring(1, string.length() - 1).ok() : string;
+                break;
+            case 2:
+                string = string * 3;
+                break;
+            default: {
+                // a flat UTF-16BE copy
+                std::string bytes(string.copyTo(NULL, 0, string.length(), Encoding::UTF16BE).ok() + 2, '\0');
+                string.copyTo((SuperString::Byte *) &bytes[0], 0, string.length(), Encoding::UTF16BE);
+                string = SuperString::Copy((const SuperString::Byte *) bytes.data(), Encoding::UTF16BE);
+                break;
+            }
+        }
+        SuperString other = rand() % 4 == 0 ? SuperString::Copy(utf32).substring(0, rand() % 3).ok()
+                                            : SuperString::Copy(pattern.c_str());
+        std::vector<int> textUnits = codeUnits(string);
+        std::vector<int> patternUnits = codeUnits(other);
+        CHECK(position(string.indexOf(other)) == find(textUnits, patternUnits, false));
+        CHECK(position(string.lastIndexOf(other)) == find(textUnits, patternUnits, true));
+    }
+
+    std::string text;
+    for(int i = 0; i < 20000; i++) {
+        text += "abcdefghij"[rand() % 10];
+    }
+    SuperString rope = SuperString::Copy("");
+    for(std::size_t i = 0; i < text.size(); i += 97) {
+        rope = rope + SuperString::Copy(text.substr(i, 97).c_str());
+    }
+    for(int k = 0; k < 200; k++) {
+        std::size_t start = rand() % text.size();
+        std::string pattern = text.substr(start, 1 + rand() % (k < 100 ? 8 : 5000));
+        SuperString other = SuperString::Copy(pattern.c_str());
+        CHECK(rope.indexOf(other).ok() == text.find(pattern) && rope.lastIndexOf(other).ok() == text.rfind(pattern));
+    }
+
+    SuperString empty;
+    CHECK(empty.indexOf(SuperString::Copy("")).ok() == 0 && empty.lastIndexOf(SuperString::Copy("")).ok() == 0);
+    CHECK(empty.indexOf(SuperString::Copy("a")).err() == SuperString::Error::NotFound);
+    SuperString latin1 = SuperString::Copy("caf\xe9 and a cr\xe8me long enough", Encoding::ASCII);
+    CHECK(latin1.indexOf(SuperString::Copy("cr\xc3\xa8me")).ok() == 11);
+    SuperString mojibake = SuperString::Copy("x\xc3\xa9 in Latin-1 bytes", Encoding::ASCII);
+    CHECK(mojibake.indexOf(SuperString::Copy("\xc3\xa9")).isErr());
+    printf("ok\n");
+    return 0;
+}
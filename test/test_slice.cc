@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Encoding Encoding;
+
+static std::vector<int> codeUnits(const SuperString &string) {
+    std::vector<int> codeUnits;
+    for(int codeUnit : string) {
+        codeUnits.push_back(codeUnit);
+    }
+    return codeUnits;
+}
+
+// Substrings pushed down through concatenations and repetitions, and substrings
+// of those, read the code units of the flat string, across any number of parts
+// and repetitions.
+int main() {
+    srand(23);
+    const int utf32[] = {'w', 0xe9, 0x4e16, 0x1f600, 0};
+    SuperString parts[] = {SuperString::Copy("an ASCII leaf", Encoding::ASCII),
+                           SuperString::Copy("h\xc3\xa9llo w\xc3\xb6rld \xe4\xb8\x96\xe7\x95\x8c"),
+                           SuperString::Copy(utf32), SuperString::Copy("a", Encoding::ASCII)};
+    std::size_t partCount = sizeof(parts) / sizeof(parts[0]);
+    for(int round = 0; round < 2000; round++) {
+        std::vector<SuperString> strings;
+        std::vector<std::vector<int> > expected;
+        for(std::size_t i = 0; i < partCount; i++) {
+            strings.push_back(parts[i]);
+            expected.push_back(codeUnits(parts[i]));
+        }
+        for(int step = 0; step < 12; step++) {
+            std::size_t first = rand() % strings.size();
+            std::size_t second = rand() % strings.size();
+            std::vector<int> units;
+            SuperString string;
+            switch(rand() % 3) {
+                case 0:
+                    string = strings[first] + strings[second];
+                    units = expected[first];
+                    units.insert(units.end(), expected[second].begin(), expected[second].end());
+                    break;
+                case 1: {
+                    std::size_t times = expected[first].size() > 500 ? 1 : 1 + rand() % 5;
+                    string = strings[first] * times;
+                    for(std::size_t i = 0; i < times; i++) {
+                        units.insert(units.end(), expected[first].begin(), expected[first].end());
+                    }
+                    break;
+                }
+                default: {
+                    std::size_t length = expected[first].size();
+                    std::size_t start = rand() % (length + 1);
+                    std::size_t end = start + rand() % (length - start + 1);
+                    string = strings[first].substring(start, end).ok();
+                    units.assign(expected[first].begin() + start, expected[first].begin() + end);
+                    break;
+                }
+            }
+            strings.push_back(string);
+            expected.push_back(units);
+        }
+        for(std::size_t i = 0; i < strings.size(); i++) {
+            std::size_t length = expected[i].size();
+            for(int k = 0; k < 4; k++) {
+                std::size_t start = rand() % (length + 1);
+                std::size_t end = start + rand() % (length - start + 1);
+                SuperString slice = strings[i].substring(start, end).ok();
+                std::vector<int> units(expected[i].begin() + start, expected[i].begin() + end);
+                CHECK(slice.length() == units.size() && codeUnits(slice) == units);
+                if(!units.empty()) {
+                    std::size_t index = rand() % units.size();
+                    CHECK(slice.codeUnitAt(index).ok() == units[index]);
+                }
+                std::size_t innerStart = rand() % (units.size() + 1);
+                std::size_t innerEnd = innerStart + rand() % (units.size() - innerStart + 1);
+                CHECK(codeUnits(slice.substring(innerStart, innerEnd).ok()) ==
+                      std::vector<int>(units.begin() + innerStart, units.begin() + innerEnd));
+                std::ostringstream stream;
+                std::ostringstream expectedStream;
+                std::vector<int> terminated = units;
+                terminated.push_back(0);
+                CHECK(slice.print(stream) && SuperString::Copy(terminated.data()).print(expectedStream));
+                CHECK(stream.str() == expectedStream.str());
+                std::ostringstream rangeStream;
+                CHECK(strings[i].print(rangeStream, start, end) && rangeStream.str() == expectedStream.str());
+            }
+        }
+    }
+
+    // a unit kept only by its repetition, freed as soon as a slice across 2 or 3
+    // repetitions merges its cut parts into a copy
+    const char *text = "a unit longer than the inline capacity";
+    std::size_t unitLength = strlen(text);
+    SuperString::RetentionPolicy &previous = SuperString::retentionPolicy();
+    SuperString::RetentionPolicy::AlwaysKeep keep;
+    SuperString::RetentionPolicy::Threshold freeing((std::size_t) -1);
+    for(std::size_t times = 2; times <= 3; times++) {
+        SuperString::retentionPolicy(keep);
+        SuperString repeated = SuperString::Copy(text, Encoding::ASCII) * 4;
+        SuperString::retentionPolicy(freeing);
+        std::size_t start = unitLength / 2;
+        std::size_t end = start + (times - 1) * unitLength + 3;
+        std::string flat;
+        for(int i = 0; i < 4; i++) {
+            flat += text;
+        }
+        std::vector<int> units(flat.begin() + start, flat.begin() + end);
+        SuperString slice = repeated.substring(start, end).ok();
+        CHECK(codeUnits(slice) == units && codeUnits(repeated.substring(start, end).ok()) == units);
+        CHECK(codeUnits(repeated) == std::vector<int>(flat.begin(), flat.end()));
+    }
+    SuperString::retentionPolicy(previous);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "SuperString.hh"
+#include "check.hh"
+
+typedef SuperString::Error Error;
+
+// Returns the number of code points of the NUL-terminated [bytes], or -1 after
+// storing the offset of its first ill-formed sequence in [errorOffset], one byte
+// at a time as RFC 3629 spells it out.
+static long validate(const unsigned char *bytes, std::size_t &errorOffset) {
+    long length = 0;
+    std::size_t i = 0;
+    while(bytes[i] != 0) {
+        unsigned char lead = bytes[i];
+        std::size_t width = lead < 0x80 ? 1 : lead < 0xc2 ? 0 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : lead < 0xf5 ? 4 : 0;
+        unsigned char low = 0x80;
+        unsigned char high = 0xbf;
+        if(lead == 0xe0) {
+            low = 0xa0;
+        } else if(lead == 0xed) {
+            high = 0x9f;
+        } else if(lead == 0xf0) {
+            low = 0x90;
+        } else if(lead == 0xf4) {
+            high = 0x8f;
+        }
+        bool isValid = width != 0;
+        for(std::size_t k = 1; k < width && isValid; k++) {
+            isValid = k == 1 ? low <= bytes[i + k] && bytes[i + k] <= high : (bytes[i + k] & 0xc0) == 0x80;
+        }
+        if(!isValid) {
+            errorOffset = i;
+            return -1;
+        }
+        i += width;
+        length++;
+    }
+    return length;
+}
+
+// Ill-formed UTF-8 is reported as InvalidByteSequence by validate and by every
+// read of a string made from it, well-formed UTF-8 is counted in code points.
+int main() {
+    const char *illFormed[] = {"ab\xff", "a longer text that is not inline \xc3", "\xed\xa0\x80 surrogate",
+                               "\xc0\xaf overlong", "\xf4\x90\x80\x80 above U+10FFFF"};
+    std::size_t offsets[] = {2, 33, 0, 0, 0};
+    for(std::size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        std::size_t errorOffset = (std::size_t) -1;
+        CHECK(SuperString::validate(illFormed[i], SuperString::Encoding::UTF8, &errorOffset).err() ==
+              Error::InvalidByteSequence);
+        CHECK(errorOffset == offsets[i]);
+        SuperString strings[] = {SuperString::Copy(illFormed[i]), SuperString::Const(illFormed[i])};
+        for(const SuperString &string : strings) {
+            CHECK(string.length() == 0);
+            CHECK(string.codeUnitAt(0).err() == Error::InvalidByteSequence);
+            CHECK(string.substring(0, 0).err() == Error::InvalidByteSequence);
+            CHECK(string.copyTo(NULL, 0, 0).err() == Error::InvalidByteSequence);
+            CHECK(string.flatten(SuperString::Encoding::UTF32).err() == Error::InvalidByteSequence);
+            SuperString appended = string;
+            appended += SuperString::Copy("x");
+            CHECK(appended.toStdString() == "x");
+        }
+    }
+
+    // long ASCII runs around multi-byte sequences, across the vector blocks
+    std::string text;
+    std::size_t length = 0;
+    for(int i = 0; i < 1000; i++) {
+        text += std::string((std::size_t) i % 70, 'a') + (i % 3 == 0 ? "\xc3\xa9" : "\xf0\x9f\x98\x80");
+        length += (std::size_t) i % 70 + 1;
+    }
+    CHECK(SuperString::validate(text.c_str()).ok() == length);
+    SuperString string = SuperString::Copy(text.c_str());
+    CHECK(string.length() == length && SuperString::Const(text.c_str()).length() == length);
+    CHECK(string.codeUnitAt(0).ok() == 0xe9 && string.codeUnitAt(length).err() == Error::RangeError);
+    CHECK(string.toStdString() == text);
+    text[text.size() / 2 + 1] = '\xff';
+    CHECK(SuperString::validate(text.c_str()).isErr() && SuperString::Copy(text.c_str()).length() == 0);
+
+    // mostly non-ASCII text, corrupted now and then, at every alignment of the vector blocks
+    srand(4);
+    const char *sequences[] = {"a", " ", "\xc3\xa9", "\xd0\x96", "\xe4\xb8\x96", "\xef\xbf\xbd", "\xf0\x9f\x98\x80",
+                               "\xf4\x8f\xbf\xbf", "\xe0\xa0\x80", "\xed\x9f\xbf"};
+    const unsigned char corruptions[] = {0x80, 0xbf, 0xc0, 0xc1, 0xc2, 0xe0, 0xed, 0xf0, 0xf4, 0xf5, 0xff, 0xa0, 0x90, 0x7f};
+    std::vector<unsigned char> buffer(1024);
+    for(int round = 0; round < 20000; round++) {
+        std::string random;
+        for(int i = rand() % 120; i > 0; i--) {
+            random += sequences[rand() % 10];
+        }
+        if(!random.empty() && rand() % 2 == 0) {
+            random[rand() % random.size()] = (char) corruptions[rand() % 14];
+        }
+        std::size_t alignment = (std::size_t) rand() % 32;
+        memcpy(&buffer[alignment], random.c_str(), random.size() + 1);
+        const char *chars = (const char *) &buffer[alignment];
+        std::size_t expectedOffset = 0;
+        long expected = validate(&buffer[alignment], expectedOffset);
+        std::size_t errorOffset = (std::size_t) -1;
+        SuperString::Result<std::size_t, Error> result =
+                SuperString::validate(chars, SuperString::Encoding::UTF8, &errorOffset);
+        if(expected < 0) {
+            CHECK(result.err() == Error::InvalidByteSequence && errorOffset == expectedOffset);
+        } else {
+            CHECK(result.ok() == (std::size_t) expected && SuperString::Copy(chars).length() == (std::size_t) expected);
+        }
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -2,29 +2,19 @@
 #include <stdlib.h>
 #include <vector>
 
-#include "../src/SuperString.cc"
+#include "SuperString.hh"
 
 int main() {
-    char *content;
     // file reading
-    FILE *f = fopen("/Users/btwael/Downloads/longtextfile.txt", "r+");
-    fseek(f, 0, SEEK_END);
-    long fsize = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    content = (char *) malloc(fsize + 1);
-    fread(content, fsize, 1, f);
-    fclose(f);
-
-    SuperString string = SuperString::Copy(content, SuperString::Encoding::ASCII);
-    free(content);
+    SuperString string = SuperString::MapFile("/Users/btwael/Downloads/longtextfile.txt",
+                                              SuperString::Encoding::ASCII).ok();
 
     std::vector<SuperString> lines;
     std::size_t last = 0;
-    for(std::size_t i = 0, length = string.length(); i < length; i++) {
-        int c = string.codeUnitAt(i).ok();
-        if(c == '\n') {
-            lines.push_back(string.substring(last, i).ok());
-            last = i + 1;
+    for(SuperString::Iterator it = string.begin(), end = string.end(); it != end; ++it) {
+        if(*it == '\n') {
+            lines.push_back(string.substring(last, it.index()).ok());
+            last = it.index() + 1;
         }
     }
 